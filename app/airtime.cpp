@@ -0,0 +1,69 @@
+/*
+/ _____)             _              | |
+( (____  _____ ____ _| |_ _____  ____| |__
+\____ \| ___ |    (_   _) ___ |/ ___)  _ \
+_____) ) ____| | | || |_| ____( (___| | | |
+(______/|_____)_|_|_| \__)_____)\____)_| |_|
+(C)2017 Semtech
+
+Description: Time on air of LoRa frames, to compare the cost of coding configurations
+License: Revised BSD License, see LICENSE file included in the project
+By: Paul Marcelis
+*/
+
+#include <cmath>
+#include <algorithm>
+#include "airtime.h"
+
+/*
+ * set the modulation settings
+ * @param SFIn - spreading factor 6 to 12
+ * @param bandwidthIn - bandwidth in Hz, 125000, 250000 or 500000
+ * @param codingRateIn - coding rate 1 to 4, for 4/5 to 4/8
+ * @param explicitHeaderIn - false for implicit header mode
+ * @param crcIn - whether the payload has a CRC, LoRaWAN uplinks do
+ * @param preambleSymbolsIn - programmed preamble length, 8 for LoRaWAN
+ */
+void LoRaAirtime::init(uint8_t SFIn, uint32_t bandwidthIn, uint8_t codingRateIn, bool explicitHeaderIn, bool crcIn, uint16_t preambleSymbolsIn) {
+  SF = SFIn;
+  bandwidth = bandwidthIn;
+  codingRate = (codingRateIn < 1) ? 1 : ((codingRateIn > 4) ? 4 : codingRateIn);
+  explicitHeader = explicitHeaderIn;
+  crc = crcIn;
+  preambleSymbols = preambleSymbolsIn;
+}
+
+/*
+ * time on air of a LoRa frame
+ * @param phyPayloadSize - PHY payload in bytes, the LoRaWAN overhead included
+ * @return time on air in seconds
+ */
+double LoRaAirtime::timeOnAir(uint32_t phyPayloadSize) {
+  double symbolTime = pow(2.0, SF) / bandwidth;
+  // the low data rate optimization is mandated for symbols of 16 ms and longer
+  int lowDataRateOptimize = (symbolTime >= 0.016) ? 1 : 0;
+  double payloadSymbols = 8 + std::max(ceil((8.0 * phyPayloadSize - 4.0 * SF + 28 + (crc ? 16 : 0) - (explicitHeader ? 0 : 20))
+    / (4.0 * (SF - 2 * lowDataRateOptimize))) * (codingRate + 4), 0.0);
+  return (preambleSymbols + 4.25 + payloadSymbols) * symbolTime;
+}
+
+/*
+ * time on air of a LoRaWAN uplink
+ * @param payloadSize - application payload in bytes, for example the DaRe payload
+ * @return time on air in seconds
+ */
+double LoRaAirtime::frameTimeOnAir(uint32_t payloadSize) {
+  return timeOnAir(AIRTIME_LORAWAN_OVERHEAD + payloadSize);
+}
+
+uint8_t LoRaAirtime::getSF() {
+  return SF;
+}
+
+uint32_t LoRaAirtime::getBandwidth() {
+  return bandwidth;
+}
+
+uint8_t LoRaAirtime::getCodingRate() {
+  return codingRate;
+}
@@ -0,0 +1,41 @@
+/*
+/ _____)             _              | |
+( (____  _____ ____ _| |_ _____  ____| |__
+\____ \| ___ |    (_   _) ___ |/ ___)  _ \
+_____) ) ____| | | || |_| ____( (___| | | |
+(______/|_____)_|_|_| \__)_____)\____)_| |_|
+(C)2017 Semtech
+
+Description: Time on air of LoRa frames, to compare the cost of coding configurations
+License: Revised BSD License, see LICENSE file included in the project
+By: Paul Marcelis
+*/
+#include <stdint.h>
+
+#ifndef __DARE_AIRTIME_H
+#define __DARE_AIRTIME_H
+
+#define AIRTIME_LORAWAN_OVERHEAD 13 // MHDR, FHDR, FPort and MIC bytes around the application payload
+#define AIRTIME_DUTY_CYCLE 0.01 // duty-cycle limit of the EU868 uplink sub-bands
+
+/*
+ * LoRa modulation settings and the time on air of a frame, see the SX1276 datasheet and Semtech AN1200.13
+ */
+class LoRaAirtime {
+  uint8_t SF = 7;
+  uint32_t bandwidth = 125000;
+  uint8_t codingRate = 1; // 1 to 4 for 4/5 to 4/8
+  bool explicitHeader = true;
+  bool crc = true;
+  uint16_t preambleSymbols = 8;
+
+public:
+  void init(uint8_t SFIn, uint32_t bandwidthIn = 125000, uint8_t codingRateIn = 1, bool explicitHeaderIn = true, bool crcIn = true, uint16_t preambleSymbolsIn = 8);
+  double timeOnAir(uint32_t phyPayloadSize);
+  double frameTimeOnAir(uint32_t payloadSize);
+  uint8_t getSF();
+  uint32_t getBandwidth();
+  uint8_t getCodingRate();
+};
+
+#endif
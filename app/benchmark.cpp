@@ -0,0 +1,1048 @@
+/*
+/ _____)             _              | |
+( (____  _____ ____ _| |_ _____  ____| |__
+\____ \| ___ |    (_   _) ___ |/ ___)  _ \
+_____) ) ____| | | || |_| ____( (___| | | |
+(______/|_____)_|_|_| \__)_____)\____)_| |_|
+(C)2017 Semtech
+
+Description: Benchmarks of the DaRe decoder
+License: Revised BSD License, see LICENSE file included in the project
+By: Paul Marcelis
+*/
+
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <cstdio>
+#include <thread>
+#include <atomic>
+#include "benchmark.h"
+#include "DaReEncode.h"
+#include "DaReDecode.h"
+#include "DaReDecodeWorker.h"
+#include "DaReColumnStore.h"
+#include "DaReSession.h"
+#include "DaReMemoryBudget.h"
+#include "DaReSessionStore.h"
+
+#define BENCHMARK_LENGTH 2000 // Number of frames per session
+#define BENCHMARK_SESSIONS 50 // Number of sessions with interleaved frames
+#define BENCHMARK_DATA_POINT_SIZE 2
+#define BENCHMARK_SNAPSHOT_READ 16 // number of newest data points per snapshot read
+#define BENCHMARK_BUDGET_OUTAGE 20 // frames lost by all sessions at once in the memory budget benchmark
+#define BENCHMARK_STORE_FRAMES 40 // frames per device in the session store benchmark
+#define BENCHMARK_STORE_PREFETCH 16 // frames between the prefetch hint and the frame of a device
+#define BENCHMARK_SMALL_BUDGET 1 // microseconds per call of the deferred elimination, less than one pass over the buffers
+
+/*
+ * Keeps track of the in-order delivery of data points
+ */
+struct DeliveryCheck {
+  uint32_t expected = 1;
+  uint32_t outOfOrder = 0;
+  uint32_t received = 0;
+};
+
+static void checkDelivery(void *context, uint32_t fcntup, uint8_t * /*dataPoint*/, bool received, uint8_t /*phase*/, uint32_t /*delay*/) {
+  DeliveryCheck *check = (DeliveryCheck *)context;
+  if (fcntup != check->expected) {
+    check->outOfOrder++;
+  }
+  check->expected = fcntup + 1;
+  if (received) {
+    check->received++;
+  }
+}
+
+/*
+ * Print percentiles of the decode call latencies in microseconds
+ */
+static void displayLatencies(const char *name, std::vector<double> &latencies, DeliveryCheck &check) {
+  std::sort(latencies.begin(), latencies.end());
+  size_t n = latencies.size();
+  std::cout << name
+    << "\t" << latencies[n / 2]
+    << "\t" << latencies[(size_t)(n * 0.99)]
+    << "\t" << latencies[(size_t)(n * 0.999)]
+    << "\t" << latencies[n - 1]
+    << "\t" << (double)100 * check.received / (BENCHMARK_LENGTH * BENCHMARK_SESSIONS)
+    << "\t" << check.outOfOrder << std::endl;
+}
+
+/*
+ * Compare the latency of decode() calls on the ingest thread with inline elimination and with deferred elimination
+ * on a background worker. The frames of a number of sessions arrive interleaved, like on a gateway, and the losses come
+ * in bursts to trigger the expensive elimination
+ */
+void latencyBenchmark(DaRe::R_VALUE R, DaRe::W_VALUE W, int p_e_percent, uint32_t budgetMicroseconds) {
+  std::mt19937 rng(1);
+  std::uniform_real_distribution<double> uniform(0.0, 1.0);
+  double p_badToGood = 0.25, p_goodToBad = p_badToGood * p_e_percent / (100.0 - p_e_percent); // mean burst length of 4 frames
+  std::vector<uint8_t> frames;
+  std::vector<bool> lost(BENCHMARK_LENGTH * BENCHMARK_SESSIONS);
+  std::vector<double> latencies;
+  uint8_t payloadCopy[1 + 2 * BENCHMARK_DATA_POINT_SIZE * 5];
+  uint8_t dataPoint[BENCHMARK_DATA_POINT_SIZE];
+  uint32_t fcntup, frameSize = 1 + BENCHMARK_DATA_POINT_SIZE * DaRe::getR(R), i, sessionI;
+  bool bad;
+  int mode;
+
+  // encode once for all sessions, and draw a bursty loss pattern with average loss rate p_e for every session
+  DaRe::Payload payload;
+  DaReEncode encoding;
+  encoding.init(&payload, BENCHMARK_DATA_POINT_SIZE, DaRe::R_1_5, DaRe::W_64);
+  encoding.set(R, W);
+  frames.resize(BENCHMARK_LENGTH * frameSize);
+  for (fcntup = 1; fcntup <= BENCHMARK_LENGTH; fcntup++) {
+    for (i = 0; i < BENCHMARK_DATA_POINT_SIZE; i++) {
+      dataPoint[i] = (uint8_t)rng();
+    }
+    encoding.encode(&payload, dataPoint, fcntup);
+    std::copy(payload.payload, payload.payload + frameSize, frames.begin() + (fcntup - 1) * frameSize);
+  }
+  encoding.destroy();
+  for (sessionI = 0; sessionI < BENCHMARK_SESSIONS; sessionI++) {
+    bad = false;
+    for (fcntup = 1; fcntup <= BENCHMARK_LENGTH; fcntup++) {
+      bad = bad ? (uniform(rng) >= p_badToGood) : (uniform(rng) < p_goodToBad);
+      lost[sessionI * BENCHMARK_LENGTH + fcntup - 1] = bad;
+    }
+  }
+
+  std::cout << "mode \t\tp50 \tp99 \tp99.9 \tmax [us] \tp_rr \tout of order" << std::endl;
+  // mode 0 decodes inline, mode 1 defers the elimination with the given budget, mode 2 with a budget so small that
+  // every call runs out of it
+  for (mode = 0; mode < 3; mode++) {
+    std::vector<DaReDecode> decoding(BENCHMARK_SESSIONS);
+    std::vector<DaReDecodeWorker::Session *> sessions(BENCHMARK_SESSIONS);
+    std::vector<DeliveryCheck> check(BENCHMARK_SESSIONS);
+    DeliveryCheck total;
+    DaReDecodeWorker worker;
+
+    if (mode > 0) {
+      worker.start((mode == 1) ? budgetMicroseconds : BENCHMARK_SMALL_BUDGET);
+    }
+    for (sessionI = 0; sessionI < BENCHMARK_SESSIONS; sessionI++) {
+      decoding[sessionI].init(BENCHMARK_DATA_POINT_SIZE, BENCHMARK_LENGTH);
+      decoding[sessionI].setDeliveryCallback(checkDelivery, &check[sessionI]);
+      if (mode > 0) {
+        sessions[sessionI] = worker.attach(&decoding[sessionI]);
+      }
+    }
+    latencies.clear();
+
+    for (fcntup = 1; fcntup <= BENCHMARK_LENGTH; fcntup++) {
+      for (sessionI = 0; sessionI < BENCHMARK_SESSIONS; sessionI++) {
+        if (lost[sessionI * BENCHMARK_LENGTH + fcntup - 1]) {
+          continue;
+        }
+        std::copy(frames.begin() + (fcntup - 1) * frameSize, frames.begin() + fcntup * frameSize, payloadCopy);
+        payload.payload = payloadCopy;
+        payload.payloadSize = (uint8_t)frameSize;
+
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        if (mode > 0) {
+          worker.decode(sessions[sessionI], payload, fcntup);
+        } else {
+          decoding[sessionI].decode(payload, fcntup);
+        }
+        latencies.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count());
+      }
+    }
+
+    for (sessionI = 0; sessionI < BENCHMARK_SESSIONS; sessionI++) {
+      if (mode > 0) {
+        worker.flush(sessions[sessionI]);
+        worker.detach(sessions[sessionI]);
+      } else {
+        decoding[sessionI].flushBuffers();
+      }
+      total.received += check[sessionI].received;
+      total.outOfOrder += check[sessionI].outOfOrder;
+      decoding[sessionI].destroy();
+    }
+    if (mode > 0) {
+      worker.stop();
+    }
+    displayLatencies((mode == 2) ? "deferred 1us" : ((mode == 1) ? "deferred" : "inline  "), latencies, total);
+  }
+}
+
+/*
+ * Measure the cost of writing all delivered data points to a column store during decoding, then reopen the store and
+ * check the stored columns against the decoders with range scans
+ * @param path - the column store file, overwritten
+ */
+void columnStoreBenchmark(const char *path) {
+  std::mt19937 rng(1);
+  std::uniform_real_distribution<double> uniform(0.0, 1.0);
+  DaRe::R_VALUE R = DaRe::R_1_3;
+  std::vector<uint8_t> frames;
+  std::vector<bool> lost(BENCHMARK_LENGTH * BENCHMARK_SESSIONS);
+  std::vector<DaReColumnStore::Columns> segments;
+  uint8_t payloadCopy[1 + 2 * BENCHMARK_DATA_POINT_SIZE * 5];
+  uint8_t dataPoint[BENCHMARK_DATA_POINT_SIZE];
+  uint32_t fcntup, frameSize = 1 + BENCHMARK_DATA_POINT_SIZE * DaRe::getR(R), i, sessionI, mismatches = 0, scanned = 0;
+  double seconds[2];
+  bool bad;
+  int mode;
+
+  DaRe::Payload payload;
+  DaReEncode encoding;
+  encoding.init(&payload, BENCHMARK_DATA_POINT_SIZE, DaRe::R_1_5, DaRe::W_64);
+  encoding.set(R, DaRe::W_16);
+  frames.resize(BENCHMARK_LENGTH * frameSize);
+  for (fcntup = 1; fcntup <= BENCHMARK_LENGTH; fcntup++) {
+    for (i = 0; i < BENCHMARK_DATA_POINT_SIZE; i++) {
+      dataPoint[i] = (uint8_t)rng();
+    }
+    encoding.encode(&payload, dataPoint, fcntup);
+    std::copy(payload.payload, payload.payload + frameSize, frames.begin() + (fcntup - 1) * frameSize);
+  }
+  encoding.destroy();
+  for (sessionI = 0; sessionI < BENCHMARK_SESSIONS; sessionI++) {
+    bad = false;
+    for (fcntup = 1; fcntup <= BENCHMARK_LENGTH; fcntup++) {
+      bad = bad ? (uniform(rng) >= 0.25) : (uniform(rng) < 0.1);
+      lost[sessionI * BENCHMARK_LENGTH + fcntup - 1] = bad;
+    }
+  }
+
+  std::remove(path);
+  DaReColumnStore store;
+  if (!store.init(path, BENCHMARK_DATA_POINT_SIZE)) {
+    return;
+  }
+  std::vector<DaReDecode> decoding;
+  std::vector<DaReColumnStore::Device> devices(BENCHMARK_SESSIONS);
+
+  // mode 0 decodes without output, mode 1 writes every delivered data point to the store
+  for (mode = 0; mode < 2; mode++) {
+    decoding.assign(BENCHMARK_SESSIONS, DaReDecode());
+    for (sessionI = 0; sessionI < BENCHMARK_SESSIONS; sessionI++) {
+      decoding[sessionI].init(BENCHMARK_DATA_POINT_SIZE, BENCHMARK_LENGTH);
+      if (mode == 1) {
+        devices[sessionI].store = &store;
+        devices[sessionI].deviceId = 0x26000000 + sessionI;
+        decoding[sessionI].setDeliveryCallback(DaReColumnStore::onDelivery, &devices[sessionI]);
+      }
+    }
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (fcntup = 1; fcntup <= BENCHMARK_LENGTH; fcntup++) {
+      for (sessionI = 0; sessionI < BENCHMARK_SESSIONS; sessionI++) {
+        if (!lost[sessionI * BENCHMARK_LENGTH + fcntup - 1]) {
+          std::copy(frames.begin() + (fcntup - 1) * frameSize, frames.begin() + fcntup * frameSize, payloadCopy);
+          payload.payload = payloadCopy;
+          payload.payloadSize = (uint8_t)frameSize;
+          decoding[sessionI].decode(payload, fcntup);
+        }
+      }
+    }
+    for (sessionI = 0; sessionI < BENCHMARK_SESSIONS; sessionI++) {
+      decoding[sessionI].flushBuffers();
+    }
+    if (!store.flush()) {
+      std::cout << "Not all records were written to " << path << std::endl;
+    }
+    seconds[mode] = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    if (mode == 0) {
+      for (sessionI = 0; sessionI < BENCHMARK_SESSIONS; sessionI++) {
+        decoding[sessionI].destroy();
+      }
+    }
+  }
+  store.destroy();
+
+  // reopen the file, the block index is rebuilt from the block headers
+  if (!store.init(path, BENCHMARK_DATA_POINT_SIZE)) {
+    return;
+  }
+  for (sessionI = 0; sessionI < BENCHMARK_SESSIONS; sessionI++) {
+    scanned += store.scan(devices[sessionI].deviceId, 1, BENCHMARK_LENGTH, segments);
+    for (i = 0; i < segments.size(); i++) {
+      uint32_t j;
+      for (j = 0; j < segments[i].count; j++) {
+        fcntup = segments[i].fcntup[j];
+        if ((segments[i].lost[j] == 0) != decoding[sessionI].isReceived(fcntup) || segments[i].phase[j] != decoding[sessionI].getPhase(fcntup)
+          || (segments[i].lost[j] == 0 && !std::equal(segments[i].value + j * BENCHMARK_DATA_POINT_SIZE, segments[i].value + (j + 1) * BENCHMARK_DATA_POINT_SIZE, decoding[sessionI].getDataPoint(fcntup)))) {
+          mismatches++;
+        }
+      }
+    }
+    decoding[sessionI].destroy();
+  }
+
+  // short range scans, like a dashboard query
+  uint32_t scans = 100000, records = 0;
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  for (i = 0; i < scans; i++) {
+    fcntup = 1 + rng() % (BENCHMARK_LENGTH - 100);
+    records += store.scan(0x26000000 + rng() % BENCHMARK_SESSIONS, fcntup, fcntup + 99, segments);
+  }
+  double scanSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  std::cout << "decode [ns/frame] \twith store [ns/frame] \tblocks \tstored \tmismatches \tscan of 100 [ns]" << std::endl;
+  std::cout << 1e9 * seconds[0] / (BENCHMARK_LENGTH * BENCHMARK_SESSIONS)
+    << "\t\t\t" << 1e9 * seconds[1] / (BENCHMARK_LENGTH * BENCHMARK_SESSIONS)
+    << "\t\t\t" << store.getBlocksUsed()
+    << "\t" << scanned
+    << "\t" << mismatches
+    << "\t\t" << 1e9 * scanSeconds / scans << " (" << records / scans << " records)" << std::endl;
+  store.destroy();
+}
+
+/*
+ * Compare the ingest CPU time of eager decoding with the lazy mode, in which the recovery only runs when a consumer
+ * queries the data points or when a missing data point is about to be doomed
+ * @param R, W - the coding parameters
+ * @param p_e_percent - average frame loss rate, with bursty losses
+ * @param framesPerQuery - the consumer of the lazy decoders reads the newest data points every so many frames
+ */
+void lazyBenchmark(DaRe::R_VALUE R, DaRe::W_VALUE W, int p_e_percent, uint32_t framesPerQuery) {
+  std::mt19937 rng(1);
+  std::uniform_real_distribution<double> uniform(0.0, 1.0);
+  double p_badToGood = 0.25, p_goodToBad = p_badToGood * p_e_percent / (100.0 - p_e_percent);
+  std::vector<uint8_t> frames;
+  std::vector<bool> lost(BENCHMARK_LENGTH * BENCHMARK_SESSIONS);
+  std::vector<bool> eagerReceived(BENCHMARK_LENGTH * BENCHMARK_SESSIONS);
+  uint8_t payloadCopy[1 + 2 * BENCHMARK_DATA_POINT_SIZE * 5];
+  uint8_t dataPoint[BENCHMARK_DATA_POINT_SIZE];
+  uint32_t fcntup, frameSize = 1 + BENCHMARK_DATA_POINT_SIZE * DaRe::getR(R), i, sessionI, decoded, recovered, differences;
+  double ingestUs, queryUs;
+  bool bad;
+  int mode;
+
+  DaRe::Payload payload;
+  DaReEncode encoding;
+  encoding.init(&payload, BENCHMARK_DATA_POINT_SIZE, DaRe::R_1_5, DaRe::W_64);
+  encoding.set(R, W);
+  frames.resize(BENCHMARK_LENGTH * frameSize);
+  for (fcntup = 1; fcntup <= BENCHMARK_LENGTH; fcntup++) {
+    for (i = 0; i < BENCHMARK_DATA_POINT_SIZE; i++) {
+      dataPoint[i] = (uint8_t)rng();
+    }
+    encoding.encode(&payload, dataPoint, fcntup);
+    std::copy(payload.payload, payload.payload + frameSize, frames.begin() + (fcntup - 1) * frameSize);
+  }
+  encoding.destroy();
+  for (sessionI = 0; sessionI < BENCHMARK_SESSIONS; sessionI++) {
+    bad = false;
+    for (fcntup = 1; fcntup <= BENCHMARK_LENGTH; fcntup++) {
+      bad = bad ? (uniform(rng) >= p_badToGood) : (uniform(rng) < p_goodToBad);
+      lost[sessionI * BENCHMARK_LENGTH + fcntup - 1] = bad;
+    }
+  }
+
+  std::cout << "mode 		ingest [us/frame] 	query [us/frame] 	p_rr 	differences" << std::endl;
+  for (mode = 0; mode < 3; mode++) {
+    std::vector<DaReDecode> decoding;
+    decoding.assign(BENCHMARK_SESSIONS, DaReDecode());
+    for (sessionI = 0; sessionI < BENCHMARK_SESSIONS; sessionI++) {
+      decoding[sessionI].init(BENCHMARK_DATA_POINT_SIZE, BENCHMARK_LENGTH);
+      decoding[sessionI].setLazyRecovery(mode > 0);
+    }
+    ingestUs = 0;
+    queryUs = 0;
+    decoded = 0;
+
+    for (fcntup = 1; fcntup <= BENCHMARK_LENGTH; fcntup++) {
+      for (sessionI = 0; sessionI < BENCHMARK_SESSIONS; sessionI++) {
+        if (lost[sessionI * BENCHMARK_LENGTH + fcntup - 1]) {
+          continue;
+        }
+        std::copy(frames.begin() + (fcntup - 1) * frameSize, frames.begin() + fcntup * frameSize, payloadCopy);
+        payload.payload = payloadCopy;
+        payload.payloadSize = (uint8_t)frameSize;
+
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        decoding[sessionI].decode(payload, fcntup);
+        ingestUs += std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+        decoded++;
+      }
+      if (mode == 2 && fcntup % framesPerQuery == 0) {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        for (sessionI = 0; sessionI < BENCHMARK_SESSIONS; sessionI++) {
+          decoding[sessionI].query(fcntup - framesPerQuery + 1, fcntup);
+        }
+        queryUs += std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+      }
+    }
+
+    recovered = 0;
+    differences = 0;
+    for (sessionI = 0; sessionI < BENCHMARK_SESSIONS; sessionI++) {
+      decoding[sessionI].flushBuffers();
+      for (fcntup = 1; fcntup <= BENCHMARK_LENGTH; fcntup++) {
+        bool received = decoding[sessionI].isReceived(fcntup);
+        if (mode == 0) {
+          eagerReceived[sessionI * BENCHMARK_LENGTH + fcntup - 1] = received;
+        } else if (received != eagerReceived[sessionI * BENCHMARK_LENGTH + fcntup - 1]) {
+          differences++;
+        }
+        recovered += received;
+      }
+      decoding[sessionI].destroy();
+    }
+    std::cout << ((mode == 0) ? "eager\t" : (mode == 1) ? "lazy\t" : "lazy+query") << "\t" << ingestUs / decoded << "\t\t\t"
+      << queryUs / decoded << "\t\t\t" << (double)100 * recovered / (BENCHMARK_LENGTH * BENCHMARK_SESSIONS) << "\t" << differences << std::endl;
+  }
+}
+
+/*
+ * Decode a number of sessions on one thread while other threads read the newest data points of random sessions from
+ * their snapshot windows. Every value read is checked against the data points that were sent
+ * @param readers - number of reader threads
+ */
+void snapshotBenchmark(unsigned int readers) {
+  std::mt19937 rng(1);
+  std::uniform_real_distribution<double> uniform(0.0, 1.0);
+  DaRe::R_VALUE R = DaRe::R_1_3;
+  double p_badToGood = 0.25, p_goodToBad = p_badToGood * 30 / (100.0 - 30); // p_e = 30%
+  std::vector<uint8_t> frames;
+  std::vector<bool> lost(BENCHMARK_LENGTH * BENCHMARK_SESSIONS);
+  uint8_t payloadCopy[1 + 2 * BENCHMARK_DATA_POINT_SIZE * 5];
+  uint8_t dataPoint[BENCHMARK_DATA_POINT_SIZE];
+  uint32_t fcntup, frameSize = 1 + BENCHMARK_DATA_POINT_SIZE * DaRe::getR(R), i, sessionI, decoded;
+  unsigned int reader_i;
+  double ingestUs;
+  bool bad;
+  int mode;
+
+  DaRe::Payload payload;
+  DaReEncode encoding;
+  encoding.init(&payload, BENCHMARK_DATA_POINT_SIZE, DaRe::R_1_5, DaRe::W_64);
+  encoding.set(R, DaRe::W_16);
+  frames.resize(BENCHMARK_LENGTH * frameSize);
+  for (fcntup = 1; fcntup <= BENCHMARK_LENGTH; fcntup++) {
+    for (i = 0; i < BENCHMARK_DATA_POINT_SIZE; i++) {
+      dataPoint[i] = (uint8_t)rng();
+    }
+    encoding.encode(&payload, dataPoint, fcntup);
+    std::copy(payload.payload, payload.payload + frameSize, frames.begin() + (fcntup - 1) * frameSize);
+  }
+  encoding.destroy();
+  for (sessionI = 0; sessionI < BENCHMARK_SESSIONS; sessionI++) {
+    bad = false;
+    for (fcntup = 1; fcntup <= BENCHMARK_LENGTH; fcntup++) {
+      bad = bad ? (uniform(rng) >= p_badToGood) : (uniform(rng) < p_goodToBad);
+      lost[sessionI * BENCHMARK_LENGTH + fcntup - 1] = bad;
+    }
+  }
+
+  std::cout << "readers \tingest [us/frame] \treads \tdata points read \twrong values" << std::endl;
+  for (mode = 0; mode < 2; mode++) {
+    std::vector<DaReDecode> decoding;
+    std::vector<std::thread> threads;
+    std::atomic<bool> running(true);
+    std::atomic<uint64_t> reads(0), pointsRead(0), wrong(0);
+
+    decoding.assign(BENCHMARK_SESSIONS, DaReDecode());
+    for (sessionI = 0; sessionI < BENCHMARK_SESSIONS; sessionI++) {
+      decoding[sessionI].init(BENCHMARK_DATA_POINT_SIZE, BENCHMARK_LENGTH);
+    }
+    for (reader_i = 0; mode == 1 && reader_i < readers; reader_i++) {
+      threads.push_back(std::thread([&, reader_i]() {
+        std::mt19937 readerRng(100 + reader_i);
+        uint8_t values[BENCHMARK_SNAPSHOT_READ * BENCHMARK_DATA_POINT_SIZE], phases[BENCHMARK_SNAPSHOT_READ];
+        uint32_t newest, j, k, readFcntup;
+        while (running.load(std::memory_order_relaxed)) {
+          DaReSnapshot *snapshot = decoding[readerRng() % BENCHMARK_SESSIONS].getSnapshot();
+          newest = snapshot->readNewest(BENCHMARK_SNAPSHOT_READ, values, phases);
+          for (j = 0; j < BENCHMARK_SNAPSHOT_READ; j++) {
+            readFcntup = newest - (BENCHMARK_SNAPSHOT_READ - 1) + j;
+            if (phases[j] == 0) {
+              continue;
+            }
+            pointsRead++;
+            for (k = 0; k < BENCHMARK_DATA_POINT_SIZE; k++) {
+              if (values[j * BENCHMARK_DATA_POINT_SIZE + k] != frames[(readFcntup - 1) * frameSize + 1 + k]) {
+                wrong++;
+                break;
+              }
+            }
+          }
+          reads++;
+        }
+      }));
+    }
+
+    ingestUs = 0;
+    decoded = 0;
+    for (fcntup = 1; fcntup <= BENCHMARK_LENGTH; fcntup++) {
+      for (sessionI = 0; sessionI < BENCHMARK_SESSIONS; sessionI++) {
+        if (lost[sessionI * BENCHMARK_LENGTH + fcntup - 1]) {
+          continue;
+        }
+        std::copy(frames.begin() + (fcntup - 1) * frameSize, frames.begin() + fcntup * frameSize, payloadCopy);
+        payload.payload = payloadCopy;
+        payload.payloadSize = (uint8_t)frameSize;
+
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        decoding[sessionI].decode(payload, fcntup);
+        ingestUs += std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+        decoded++;
+      }
+    }
+    running = false;
+    for (reader_i = 0; reader_i < threads.size(); reader_i++) {
+      threads[reader_i].join();
+    }
+    for (sessionI = 0; sessionI < BENCHMARK_SESSIONS; sessionI++) {
+      decoding[sessionI].destroy();
+    }
+    std::cout << ((mode == 0) ? 0 : readers) << "\t\t" << ingestUs / decoded << "\t\t\t" << reads << "\t"
+      << pointsRead << "\t\t\t" << wrong << std::endl;
+  }
+}
+
+/*
+ * Counts the data points delivered by all compact sessions, and checks them against the data points that were sent
+ */
+struct SessionCheck {
+  const std::vector<uint8_t> *truth;
+  uint64_t delivered = 0;
+  uint64_t received = 0;
+  uint64_t wrong = 0;
+};
+
+static void checkSessionDelivery(void *context, uint32_t fcntup, uint8_t *dataPoint, bool received, uint8_t /*phase*/, uint32_t /*delay*/) {
+  SessionCheck *check = (SessionCheck *)context;
+  check->delivered++;
+  if (received) {
+    check->received++;
+    if (!std::equal(dataPoint, dataPoint + BENCHMARK_DATA_POINT_SIZE, check->truth->begin() + (fcntup - 1) * BENCHMARK_DATA_POINT_SIZE)) {
+      check->wrong++;
+    }
+  }
+}
+
+/*
+ * Decode a large number of compact sessions with interleaved frames, and report their memory use next to that of
+ * DaReDecode for the same frames
+ * @param sessions - number of sessions
+ * @param framesPerSession - frames sent by every session
+ */
+void sessionBenchmark(uint32_t sessions, uint32_t framesPerSession) {
+  std::mt19937 rng(1);
+  std::uniform_real_distribution<double> uniform(0.0, 1.0);
+  DaRe::R_VALUE R = DaRe::R_1_3;
+  DaRe::W_VALUE W = DaRe::W_16;
+  double p_badToGood = 0.25, p_goodToBad = p_badToGood * 30 / (100.0 - 30); // p_e = 30%
+  std::vector<uint8_t> frames, truth(framesPerSession * BENCHMARK_DATA_POINT_SIZE);
+  std::vector<bool> bad(sessions, false);
+  std::vector<DaReSession> compact(sessions);
+  uint8_t payloadCopy[1 + 2 * BENCHMARK_DATA_POINT_SIZE * 5];
+  uint32_t fcntup, frameSize = 1 + BENCHMARK_DATA_POINT_SIZE * DaRe::getR(R), i, sessionI;
+  size_t bytes, peakBytes = 0;
+  uint64_t decoded = 0;
+  double decodeUs = 0;
+  SessionCheck check;
+
+  DaRe::Payload payload;
+  DaReEncode encoding;
+  encoding.init(&payload, BENCHMARK_DATA_POINT_SIZE, DaRe::R_1_5, DaRe::W_64);
+  encoding.set(R, W);
+  frames.resize(framesPerSession * frameSize);
+  for (fcntup = 1; fcntup <= framesPerSession; fcntup++) {
+    for (i = 0; i < BENCHMARK_DATA_POINT_SIZE; i++) {
+      truth[(fcntup - 1) * BENCHMARK_DATA_POINT_SIZE + i] = (uint8_t)rng();
+    }
+    encoding.encode(&payload, &truth[(fcntup - 1) * BENCHMARK_DATA_POINT_SIZE], fcntup);
+    std::copy(payload.payload, payload.payload + frameSize, frames.begin() + (fcntup - 1) * frameSize);
+  }
+  encoding.destroy();
+
+  check.truth = &truth;
+  for (sessionI = 0; sessionI < sessions; sessionI++) {
+    compact[sessionI].init(BENCHMARK_DATA_POINT_SIZE);
+    compact[sessionI].setDeliveryCallback(checkSessionDelivery, &check);
+  }
+  bytes = 0;
+  for (sessionI = 0; sessionI < sessions; sessionI++) {
+    bytes += compact[sessionI].memoryUsage();
+  }
+  std::cout << "idle session: " << (double)bytes / sessions << " bytes" << std::endl;
+
+  // the losses are drawn on the fly, every session has its own bursty loss pattern
+  for (fcntup = 1; fcntup <= framesPerSession; fcntup++) {
+    for (sessionI = 0; sessionI < sessions; sessionI++) {
+      bad[sessionI] = bad[sessionI] ? (uniform(rng) >= p_badToGood) : (uniform(rng) < p_goodToBad);
+      if (bad[sessionI]) {
+        continue;
+      }
+      std::copy(frames.begin() + (fcntup - 1) * frameSize, frames.begin() + fcntup * frameSize, payloadCopy);
+      payload.payload = payloadCopy;
+      payload.payloadSize = (uint8_t)frameSize;
+      std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+      compact[sessionI].decode(payload, fcntup);
+      decodeUs += std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+      decoded++;
+    }
+    if (fcntup % 100 == 0) {
+      bytes = 0;
+      for (sessionI = 0; sessionI < sessions; sessionI++) {
+        bytes += compact[sessionI].memoryUsage();
+      }
+      peakBytes = std::max(peakBytes, bytes);
+    }
+  }
+  for (sessionI = 0; sessionI < sessions; sessionI++) {
+    compact[sessionI].flush();
+    compact[sessionI].destroy();
+  }
+
+  // one DaReDecode with the same frames, for comparison
+  DaReDecode decoding;
+  decoding.init(BENCHMARK_DATA_POINT_SIZE, framesPerSession);
+  for (fcntup = 1; fcntup <= framesPerSession; fcntup++) {
+    if (uniform(rng) * 100 >= 30) {
+      std::copy(frames.begin() + (fcntup - 1) * frameSize, frames.begin() + fcntup * frameSize, payloadCopy);
+      payload.payload = payloadCopy;
+      payload.payloadSize = (uint8_t)frameSize;
+      decoding.decode(payload, fcntup);
+    }
+  }
+
+  std::cout << "peak: " << (double)peakBytes / sessions << " bytes per session, " << peakBytes / (1024 * 1024) << " MiB for "
+    << sessions << " sessions" << std::endl;
+  std::cout << "DaReDecode with " << framesPerSession << " frames: " << decoding.memoryUsage() << " bytes" << std::endl;
+  std::cout << "decode: " << decodeUs / decoded << " us/frame, p_rr " << (double)100 * check.received / check.delivered
+    << ", " << check.delivered << " data points delivered, " << check.wrong << " wrong" << std::endl;
+  decoding.destroy();
+}
+
+/*
+ * Compare the ingest CPU time of copying every payload and decoding it with decode(), with decoding the received frames
+ * of a session in batches with decodeBatch(), straight from the read-only receive buffer
+ * @param R - code rate
+ * @param W - window size
+ * @param p_e_percent - mean frame loss probability in percent, with bursty losses
+ * @param framesPerBatch - number of frame counters per batch
+ */
+void batchBenchmark(DaRe::R_VALUE R, DaRe::W_VALUE W, int p_e_percent, uint32_t framesPerBatch) {
+  std::mt19937 rng(1);
+  std::uniform_real_distribution<double> uniform(0.0, 1.0);
+  double p_badToGood = 0.25, p_goodToBad = p_badToGood * p_e_percent / (100.0 - p_e_percent);
+  std::vector<uint8_t> frames;
+  std::vector<bool> lost(BENCHMARK_LENGTH * BENCHMARK_SESSIONS);
+  std::vector<bool> singleReceived(BENCHMARK_LENGTH * BENCHMARK_SESSIONS);
+  std::vector<DaReDecode::Frame> batch;
+  uint8_t payloadCopy[1 + 2 * BENCHMARK_DATA_POINT_SIZE * 5];
+  uint8_t dataPoint[BENCHMARK_DATA_POINT_SIZE];
+  uint32_t fcntup, firstFcntup, frameSize = 1 + BENCHMARK_DATA_POINT_SIZE * DaRe::getR(R), i, sessionI, decoded, differences;
+  double ingestUs;
+  bool bad;
+  int mode;
+
+  DaRe::Payload payload;
+  DaReEncode encoding;
+  encoding.init(&payload, BENCHMARK_DATA_POINT_SIZE, DaRe::R_1_5, DaRe::W_64);
+  encoding.set(R, W);
+  frames.resize(BENCHMARK_LENGTH * frameSize);
+  for (fcntup = 1; fcntup <= BENCHMARK_LENGTH; fcntup++) {
+    for (i = 0; i < BENCHMARK_DATA_POINT_SIZE; i++) {
+      dataPoint[i] = (uint8_t)rng();
+    }
+    encoding.encode(&payload, dataPoint, fcntup);
+    std::copy(payload.payload, payload.payload + frameSize, frames.begin() + (fcntup - 1) * frameSize);
+  }
+  encoding.destroy();
+  for (sessionI = 0; sessionI < BENCHMARK_SESSIONS; sessionI++) {
+    bad = false;
+    for (fcntup = 1; fcntup <= BENCHMARK_LENGTH; fcntup++) {
+      bad = bad ? (uniform(rng) >= p_badToGood) : (uniform(rng) < p_goodToBad);
+      lost[sessionI * BENCHMARK_LENGTH + fcntup - 1] = bad;
+    }
+  }
+
+  std::cout << "mode 	ingest [us/frame] 	differences" << std::endl;
+  for (mode = 0; mode < 2; mode++) {
+    std::vector<DaReDecode> decoding;
+    decoding.assign(BENCHMARK_SESSIONS, DaReDecode());
+    for (sessionI = 0; sessionI < BENCHMARK_SESSIONS; sessionI++) {
+      decoding[sessionI].init(BENCHMARK_DATA_POINT_SIZE, BENCHMARK_LENGTH);
+    }
+    ingestUs = 0;
+    decoded = 0;
+
+    for (firstFcntup = 1; firstFcntup <= BENCHMARK_LENGTH; firstFcntup += framesPerBatch) {
+      for (sessionI = 0; sessionI < BENCHMARK_SESSIONS; sessionI++) {
+        batch.clear();
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        for (fcntup = firstFcntup; fcntup < firstFcntup + framesPerBatch && fcntup <= BENCHMARK_LENGTH; fcntup++) {
+          if (lost[sessionI * BENCHMARK_LENGTH + fcntup - 1]) {
+            continue;
+          }
+          if (mode == 0) {
+            // decode() used to reduce the parity checks in the payload, so every payload was copied first
+            std::copy(frames.begin() + (fcntup - 1) * frameSize, frames.begin() + fcntup * frameSize, payloadCopy);
+            payload.payload = payloadCopy;
+            payload.payloadSize = (uint8_t)frameSize;
+            decoding[sessionI].decode(payload, fcntup);
+          } else {
+            DaReDecode::Frame frame;
+            frame.fcntup = fcntup;
+            frame.payload = &frames[(fcntup - 1) * frameSize];
+            frame.payloadSize = (uint8_t)frameSize;
+            batch.push_back(frame);
+          }
+          decoded++;
+        }
+        if (mode == 1) {
+          decoding[sessionI].decodeBatch(batch.data(), batch.size());
+        }
+        ingestUs += std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+      }
+    }
+
+    differences = 0;
+    for (sessionI = 0; sessionI < BENCHMARK_SESSIONS; sessionI++) {
+      decoding[sessionI].flushBuffers();
+      for (fcntup = 1; fcntup <= BENCHMARK_LENGTH; fcntup++) {
+        bool received = decoding[sessionI].isReceived(fcntup);
+        if (mode == 0) {
+          singleReceived[sessionI * BENCHMARK_LENGTH + fcntup - 1] = received;
+        } else if (received != singleReceived[sessionI * BENCHMARK_LENGTH + fcntup - 1]) {
+          differences++;
+        }
+      }
+      decoding[sessionI].destroy();
+    }
+    std::cout << ((mode == 0) ? "single" : "batch") << "\t" << ingestUs / decoded << "\t\t\t" << differences << std::endl;
+  }
+}
+
+/*
+ * Compare the ingest CPU time of sessions that decode on their own with sessions that share a plan cache, first with
+ * an empty cache and then with the cache the first run left behind. All sessions receive the same frames with their
+ * own short loss bursts
+ * @param R - code rate
+ * @param W - window size
+ * @param p_e_percent - mean frame loss probability in percent, with bursts of 2 frames on average
+ * @param sessions - number of sessions
+ */
+void planCacheBenchmark(DaRe::R_VALUE R, DaRe::W_VALUE W, int p_e_percent, uint32_t sessions) {
+  static const char *modes[] = { "general", "cold cache", "warm cache" };
+  std::mt19937 rng(1);
+  std::uniform_real_distribution<double> uniform(0.0, 1.0);
+  double p_badToGood = 0.5, p_goodToBad = p_badToGood * p_e_percent / (100.0 - p_e_percent);
+  std::vector<uint8_t> frames;
+  std::vector<bool> lost(BENCHMARK_LENGTH * sessions);
+  std::vector<bool> generalReceived(BENCHMARK_LENGTH * sessions);
+  uint8_t payloadCopy[1 + 2 * BENCHMARK_DATA_POINT_SIZE * 5];
+  uint8_t dataPoint[BENCHMARK_DATA_POINT_SIZE];
+  uint32_t fcntup, frameSize = 1 + BENCHMARK_DATA_POINT_SIZE * DaRe::getR(R), i, sessionI, decoded, differences;
+  uint64_t hits, misses;
+  double ingestUs;
+  bool bad;
+  int mode;
+
+  DaRe::Payload payload;
+  DaReEncode encoding;
+  encoding.init(&payload, BENCHMARK_DATA_POINT_SIZE, DaRe::R_1_5, DaRe::W_64);
+  encoding.set(R, W);
+  frames.resize(BENCHMARK_LENGTH * frameSize);
+  for (fcntup = 1; fcntup <= BENCHMARK_LENGTH; fcntup++) {
+    for (i = 0; i < BENCHMARK_DATA_POINT_SIZE; i++) {
+      dataPoint[i] = (uint8_t)rng();
+    }
+    encoding.encode(&payload, dataPoint, fcntup);
+    std::copy(payload.payload, payload.payload + frameSize, frames.begin() + (fcntup - 1) * frameSize);
+  }
+  encoding.destroy();
+  for (sessionI = 0; sessionI < sessions; sessionI++) {
+    bad = false;
+    for (fcntup = 1; fcntup <= BENCHMARK_LENGTH; fcntup++) {
+      bad = bad ? (uniform(rng) >= p_badToGood) : (uniform(rng) < p_goodToBad);
+      lost[sessionI * BENCHMARK_LENGTH + fcntup - 1] = bad;
+    }
+  }
+
+  DaRePlanCache planCache;
+  planCache.init();
+  std::cout << "mode \t\tingest [us/frame] \thits [%] \tplans \tdifferences" << std::endl;
+  for (mode = 0; mode < 3; mode++) {
+    std::vector<DaReDecode> decoding;
+    decoding.assign(sessions, DaReDecode());
+    for (sessionI = 0; sessionI < sessions; sessionI++) {
+      decoding[sessionI].init(BENCHMARK_DATA_POINT_SIZE, BENCHMARK_LENGTH);
+      decoding[sessionI].setPlanCache((mode > 0) ? &planCache : NULL);
+    }
+    hits = planCache.getHits();
+    misses = planCache.getMisses();
+    ingestUs = 0;
+    decoded = 0;
+
+    for (fcntup = 1; fcntup <= BENCHMARK_LENGTH; fcntup++) {
+      for (sessionI = 0; sessionI < sessions; sessionI++) {
+        if (lost[sessionI * BENCHMARK_LENGTH + fcntup - 1]) {
+          continue;
+        }
+        std::copy(frames.begin() + (fcntup - 1) * frameSize, frames.begin() + fcntup * frameSize, payloadCopy);
+        payload.payload = payloadCopy;
+        payload.payloadSize = (uint8_t)frameSize;
+
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        decoding[sessionI].decode(payload, fcntup);
+        ingestUs += std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+        decoded++;
+      }
+    }
+    hits = planCache.getHits() - hits;
+    misses = planCache.getMisses() - misses;
+
+    differences = 0;
+    for (sessionI = 0; sessionI < sessions; sessionI++) {
+      decoding[sessionI].flushBuffers();
+      for (fcntup = 1; fcntup <= BENCHMARK_LENGTH; fcntup++) {
+        bool received = decoding[sessionI].isReceived(fcntup);
+        if (mode == 0) {
+          generalReceived[sessionI * BENCHMARK_LENGTH + fcntup - 1] = received;
+        } else if (received != generalReceived[sessionI * BENCHMARK_LENGTH + fcntup - 1]) {
+          differences++;
+        }
+      }
+      decoding[sessionI].destroy();
+    }
+    std::cout << modes[mode] << "\t" << ((mode == 0) ? "\t" : "") << ingestUs / decoded << "\t\t\t"
+      << ((hits + misses > 0) ? (double)100 * hits / (hits + misses) : 0) << "\t\t" << planCache.size() << "\t" << differences << std::endl;
+  }
+  planCache.destroy();
+}
+
+/*
+ * Memory of the pending parity checks of many sessions through a network-wide outage, without a limit and with a
+ * shared DaReMemoryBudget. Every fourth session has priority 4. All frames of all sessions are lost during the
+ * outage, the frames after it bring parity checks over the lost data points to every session at once
+ * @param R - code rate
+ * @param W - window size
+ * @param p_e_percent - mean frame loss probability in percent outside the outage, with bursty losses
+ * @param limitKiB - the budget
+ * @param sessions - number of sessions
+ */
+void budgetBenchmark(DaRe::R_VALUE R, DaRe::W_VALUE W, int p_e_percent, uint32_t limitKiB, uint32_t sessions) {
+  std::mt19937 rng(1);
+  std::uniform_real_distribution<double> uniform(0.0, 1.0);
+  double p_badToGood = 0.25, p_goodToBad = p_badToGood * p_e_percent / (100.0 - p_e_percent);
+  std::vector<uint8_t> frames;
+  std::vector<bool> lost(BENCHMARK_LENGTH * sessions);
+  uint8_t payloadCopy[1 + 2 * BENCHMARK_DATA_POINT_SIZE * 5];
+  uint8_t dataPoint[BENCHMARK_DATA_POINT_SIZE];
+  uint32_t fcntup, frameSize = 1 + BENCHMARK_DATA_POINT_SIZE * DaRe::getR(R), i, sessionI, priorityClass;
+  uint32_t outageStart = BENCHMARK_LENGTH / 2, outageEnd = outageStart + BENCHMARK_BUDGET_OUTAGE;
+  uint32_t lostCount[2], recoveredCount[2];
+  double ingestUs;
+  bool bad;
+  int mode;
+
+  DaRe::Payload payload;
+  DaReEncode encoding;
+  encoding.init(&payload, BENCHMARK_DATA_POINT_SIZE, DaRe::R_1_5, DaRe::W_64);
+  encoding.set(R, W);
+  frames.resize(BENCHMARK_LENGTH * frameSize);
+  for (fcntup = 1; fcntup <= BENCHMARK_LENGTH; fcntup++) {
+    for (i = 0; i < BENCHMARK_DATA_POINT_SIZE; i++) {
+      dataPoint[i] = (uint8_t)rng();
+    }
+    encoding.encode(&payload, dataPoint, fcntup);
+    std::copy(payload.payload, payload.payload + frameSize, frames.begin() + (fcntup - 1) * frameSize);
+  }
+  encoding.destroy();
+  for (sessionI = 0; sessionI < sessions; sessionI++) {
+    bad = false;
+    for (fcntup = 1; fcntup <= BENCHMARK_LENGTH; fcntup++) {
+      bad = bad ? (uniform(rng) >= p_badToGood) : (uniform(rng) < p_goodToBad);
+      lost[sessionI * BENCHMARK_LENGTH + fcntup - 1] = bad || (fcntup > outageStart && fcntup <= outageEnd);
+    }
+  }
+
+  std::cout << "mode \tpeak [KiB] \tevictions \tingest [us/frame] \trecovered normal [%] \trecovered priority [%]" << std::endl;
+  for (mode = 0; mode < 2; mode++) {
+    std::vector<DaReDecode> decoding;
+    DaReMemoryBudget budget;
+    // without a limit, the budget only keeps count
+    budget.init((mode == 0) ? SIZE_MAX : (size_t)limitKiB * 1024);
+    decoding.assign(sessions, DaReDecode());
+    for (sessionI = 0; sessionI < sessions; sessionI++) {
+      decoding[sessionI].init(BENCHMARK_DATA_POINT_SIZE, BENCHMARK_LENGTH);
+      decoding[sessionI].setMemoryBudget(&budget, (sessionI % 4 == 0) ? 4.0 : 1.0);
+    }
+
+    ingestUs = 0;
+    for (fcntup = 1; fcntup <= BENCHMARK_LENGTH; fcntup++) {
+      for (sessionI = 0; sessionI < sessions; sessionI++) {
+        if (lost[sessionI * BENCHMARK_LENGTH + fcntup - 1]) {
+          continue;
+        }
+        std::copy(frames.begin() + (fcntup - 1) * frameSize, frames.begin() + fcntup * frameSize, payloadCopy);
+        payload.payload = payloadCopy;
+        payload.payloadSize = (uint8_t)frameSize;
+
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        decoding[sessionI].decode(payload, fcntup);
+        ingestUs += std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+      }
+    }
+
+    lostCount[0] = lostCount[1] = recoveredCount[0] = recoveredCount[1] = 0;
+    for (sessionI = 0; sessionI < sessions; sessionI++) {
+      decoding[sessionI].flushBuffers();
+      priorityClass = (sessionI % 4 == 0) ? 1 : 0;
+      for (fcntup = 1; fcntup <= BENCHMARK_LENGTH; fcntup++) {
+        if (lost[sessionI * BENCHMARK_LENGTH + fcntup - 1]) {
+          lostCount[priorityClass]++;
+          recoveredCount[priorityClass] += decoding[sessionI].isReceived(fcntup) ? 1 : 0;
+        }
+      }
+      decoding[sessionI].destroy();
+    }
+    std::cout << ((mode == 0) ? "none" : "budget") << "\t" << budget.getPeak() / 1024.0 << "\t\t" << budget.getEvictions() << "\t\t"
+      << ingestUs / (BENCHMARK_LENGTH * sessions) << "\t\t\t" << (double)100 * recoveredCount[0] / lostCount[0] << "\t\t\t"
+      << (double)100 * recoveredCount[1] / lostCount[1] << std::endl;
+    budget.destroy();
+  }
+}
+
+static void checkStoreDelivery(void *context, uint32_t /*deviceId*/, uint32_t fcntup, uint8_t *dataPoint, bool received, uint8_t phase, uint32_t delay) {
+  checkSessionDelivery(context, fcntup, dataPoint, received, phase, delay);
+}
+
+/*
+ * Decode the frames of a fleet of devices that each send a frame per round in random order, once with all sessions in
+ * memory and once with a DaReSessionStore that keeps only a part of them in memory. The store gets a prefetch hint a
+ * few frames before every frame, and is closed and opened again before the sessions are flushed at the end
+ * @param devices - number of devices
+ * @param cachedSessions - number of sessions the store keeps in memory
+ * @param path - file of the store, it is removed at the end
+ */
+void sessionStoreBenchmark(uint32_t devices, uint32_t cachedSessions, const char *path) {
+  std::mt19937 rng(1);
+  std::uniform_real_distribution<double> uniform(0.0, 1.0);
+  DaRe::R_VALUE R = DaRe::R_1_3;
+  DaRe::W_VALUE W = DaRe::W_16;
+  double p_badToGood = 0.25, p_goodToBad = p_badToGood * 20 / (100.0 - 20); // p_e = 20%
+  std::vector<uint8_t> frames, truth(BENCHMARK_STORE_FRAMES * BENCHMARK_DATA_POINT_SIZE);
+  std::vector<bool> lost(devices * BENCHMARK_STORE_FRAMES);
+  std::vector<uint32_t> order(devices);
+  uint8_t payloadCopy[1 + 2 * BENCHMARK_DATA_POINT_SIZE * 5];
+  uint32_t fcntup, frameSize = 1 + BENCHMARK_DATA_POINT_SIZE * DaRe::getR(R), i, deviceId;
+  size_t bytes, peakBytes;
+  uint64_t decoded;
+  double decodeUs;
+  bool bad;
+  int mode;
+
+  DaRe::Payload payload;
+  DaReEncode encoding;
+  encoding.init(&payload, BENCHMARK_DATA_POINT_SIZE, DaRe::R_1_5, DaRe::W_64);
+  encoding.set(R, W);
+  frames.resize(BENCHMARK_STORE_FRAMES * frameSize);
+  for (fcntup = 1; fcntup <= BENCHMARK_STORE_FRAMES; fcntup++) {
+    for (i = 0; i < BENCHMARK_DATA_POINT_SIZE; i++) {
+      truth[(fcntup - 1) * BENCHMARK_DATA_POINT_SIZE + i] = (uint8_t)rng();
+    }
+    encoding.encode(&payload, &truth[(fcntup - 1) * BENCHMARK_DATA_POINT_SIZE], fcntup);
+    std::copy(payload.payload, payload.payload + frameSize, frames.begin() + (fcntup - 1) * frameSize);
+  }
+  encoding.destroy();
+  for (deviceId = 0; deviceId < devices; deviceId++) {
+    bad = false;
+    for (fcntup = 1; fcntup <= BENCHMARK_STORE_FRAMES; fcntup++) {
+      bad = bad ? (uniform(rng) >= p_badToGood) : (uniform(rng) < p_goodToBad);
+      lost[deviceId * BENCHMARK_STORE_FRAMES + fcntup - 1] = bad;
+    }
+    order[deviceId] = deviceId;
+  }
+
+  std::cout << "mode \t\tdecode [us/frame] \tpeak memory [KiB] \tfaults \twrites \tprefetches \tfile [KiB] \tcompactions \treceived \twrong" << std::endl;
+  for (mode = 0; mode < 2; mode++) {
+    std::vector<DaReSession> sessions;
+    DaReSessionStore store;
+    SessionCheck check;
+    std::mt19937 orderRng(2);
+    check.truth = &truth;
+    if (mode == 0) {
+      sessions.assign(devices, DaReSession());
+      for (deviceId = 0; deviceId < devices; deviceId++) {
+        sessions[deviceId].init(BENCHMARK_DATA_POINT_SIZE);
+        sessions[deviceId].setDeliveryCallback(checkSessionDelivery, &check);
+      }
+    } else {
+      std::remove(path);
+      if (!store.init(path, BENCHMARK_DATA_POINT_SIZE, cachedSessions)) {
+        return;
+      }
+      store.setDeliveryCallback(checkStoreDelivery, &check);
+    }
+
+    decodeUs = 0;
+    decoded = 0;
+    peakBytes = 0;
+    for (fcntup = 1; fcntup <= BENCHMARK_STORE_FRAMES; fcntup++) {
+      std::shuffle(order.begin(), order.end(), orderRng);
+      for (i = 0; i < devices; i++) {
+        deviceId = order[i];
+        if (mode == 1 && i + BENCHMARK_STORE_PREFETCH < devices) {
+          store.prefetch(order[i + BENCHMARK_STORE_PREFETCH]);
+        }
+        if (lost[deviceId * BENCHMARK_STORE_FRAMES + fcntup - 1]) {
+          continue;
+        }
+        std::copy(frames.begin() + (fcntup - 1) * frameSize, frames.begin() + fcntup * frameSize, payloadCopy);
+        payload.payload = payloadCopy;
+        payload.payloadSize = (uint8_t)frameSize;
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        if (mode == 0) {
+          sessions[deviceId].decode(payload, fcntup);
+        } else if (!store.decode(deviceId, payload, fcntup)) {
+          std::cout << "Frame " << fcntup << " of device " << deviceId << " refused, " << path << " cannot grow" << std::endl;
+          store.destroy();
+          return;
+        }
+        decodeUs += std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+        decoded++;
+      }
+      bytes = 0;
+      if (mode == 0) {
+        for (deviceId = 0; deviceId < devices; deviceId++) {
+          bytes += sessions[deviceId].memoryUsage();
+        }
+      } else {
+        bytes = store.memoryUsage();
+      }
+      peakBytes = std::max(peakBytes, bytes);
+    }
+
+    if (mode == 0) {
+      for (deviceId = 0; deviceId < devices; deviceId++) {
+        sessions[deviceId].flush();
+        sessions[deviceId].destroy();
+      }
+      std::cout << "in memory\t" << decodeUs / decoded << "\t\t\t" << peakBytes / 1024.0 << "\t\t\t-\t-\t-\t\t-\t\t-\t\t" << check.received << "\t\t" << check.wrong << std::endl;
+      continue;
+    }
+    uint32_t faults = store.getFaults(), writes = store.getWrites(), prefetches = store.getPrefetches(), compactions = store.getCompactions();
+    uint64_t fileBytes = store.getFileBytes();
+    // the sessions survive closing the store
+    store.destroy();
+    if (!store.init(path, BENCHMARK_DATA_POINT_SIZE, cachedSessions)) {
+      return;
+    }
+    store.setDeliveryCallback(checkStoreDelivery, &check);
+    for (deviceId = 0; deviceId < devices; deviceId++) {
+      DaReSession *session = store.getSession(deviceId);
+      if (session == NULL) {
+        std::cout << "Session of device " << deviceId << " refused, " << path << " cannot grow" << std::endl;
+        break;
+      }
+      session->flush();
+    }
+    store.destroy();
+    std::remove(path);
+    std::cout << "store\t\t" << decodeUs / decoded << "\t\t\t" << peakBytes / 1024.0 << "\t\t\t" << faults << "\t" << writes << "\t"
+      << prefetches << "\t\t" << fileBytes / 1024.0 << "\t\t" << compactions << "\t\t" << check.received << "\t\t" << check.wrong << std::endl;
+  }
+}
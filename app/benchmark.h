@@ -0,0 +1,28 @@
+/*
+/ _____)             _              | |
+( (____  _____ ____ _| |_ _____  ____| |__
+\____ \| ___ |    (_   _) ___ |/ ___)  _ \
+_____) ) ____| | | || |_| ____( (___| | | |
+(______/|_____)_|_|_| \__)_____)\____)_| |_|
+(C)2017 Semtech
+
+Description: Benchmarks of the DaRe decoder
+License: Revised BSD License, see LICENSE file included in the project
+By: Paul Marcelis
+*/
+#include "DaRe.h"
+
+#ifndef __DARE_BENCHMARK_H
+#define __DARE_BENCHMARK_H
+
+void latencyBenchmark(DaRe::R_VALUE R, DaRe::W_VALUE W, int p_e_percent, uint32_t budgetMicroseconds);
+void columnStoreBenchmark(const char *path);
+void snapshotBenchmark(unsigned int readers);
+void sessionBenchmark(uint32_t sessions, uint32_t framesPerSession);
+void lazyBenchmark(DaRe::R_VALUE R, DaRe::W_VALUE W, int p_e_percent, uint32_t framesPerQuery);
+void batchBenchmark(DaRe::R_VALUE R, DaRe::W_VALUE W, int p_e_percent, uint32_t framesPerBatch);
+void planCacheBenchmark(DaRe::R_VALUE R, DaRe::W_VALUE W, int p_e_percent, uint32_t sessions);
+void sessionStoreBenchmark(uint32_t devices, uint32_t cachedSessions, const char *path);
+void budgetBenchmark(DaRe::R_VALUE R, DaRe::W_VALUE W, int p_e_percent, uint32_t limitKiB, uint32_t sessions);
+
+#endif
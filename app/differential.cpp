@@ -0,0 +1,645 @@
+/*
+/ _____)             _              | |
+( (____  _____ ____ _| |_ _____  ____| |__
+\____ \| ___ |    (_   _) ___ |/ ___)  _ \
+_____) ) ____| | | || |_| ____( (___| | | |
+(______/|_____)_|_|_| \__)_____)\____)_| |_|
+(C)2017 Semtech
+
+Description: Differential verification of decoder variants against the reference decoder
+License: Revised BSD License, see LICENSE file included in the project
+By: Paul Marcelis
+*/
+
+#include <iostream>
+#include <vector>
+#include <random>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+#include "differential.h"
+#include "DaReEncode.h"
+#include "DaReDecode.h"
+#include "DaReVerifier.h"
+#include "DaReReorder.h"
+#include "DaReSession.h"
+#include "DaReSessionStore.h"
+
+#define DIFFERENTIAL_MAX_LENGTH 3000 // maximal number of frames in one trial
+#define DIFFERENTIAL_MAX_DATA_POINT_SIZE 4
+#define DIFFERENTIAL_DEGREE_TABLE 15 // degree table number used by the trials with a random degree table
+#define DIFFERENTIAL_BUDGET_CHECKS 6 // parity checks the decoder with a memory budget may hold
+#define DIFFERENTIAL_MAX_K 4 // maximal number of readings per frame in the trials that aggregate readings
+#define DIFFERENTIAL_STORE_FILE "differential.sessions" // name of the temporary file of the session store variant
+
+/*
+ * Create an empty file with a unique name in the temporary directory, so that harnesses running side by side, or in a
+ * read-only working directory, do not share the file
+ * @param name - prefix of the file name
+ * @return the path of the file, to be removed by the caller
+ */
+static std::string getTemporaryPath(const char *name) {
+#ifdef _WIN32
+  char directory[MAX_PATH + 1], path[MAX_PATH + 1];
+  if (GetTempPathA(sizeof(directory), directory) == 0 || GetTempFileNameA(directory, "dar", 0, path) == 0) {
+    return name;
+  }
+  return path;
+#else
+  const char *directory = getenv("TMPDIR");
+  std::string path = std::string((directory != NULL && *directory != '\0') ? directory : "/tmp") + "/" + name + ".XXXXXX";
+  int file = mkstemp(&path[0]);
+  if (file < 0) {
+    return name;
+  }
+  close(file);
+  return path;
+#endif
+}
+
+/*
+ * The reference decoder, with the ground truth oracle attached
+ */
+class ReferenceVariant : public DecoderVariant {
+  DaReDecode decoding;
+  DaReVerifier *verifier;
+public:
+  ReferenceVariant(DaReVerifier *verifierIn) : verifier(verifierIn) {}
+  const char *name() { return "reference"; }
+  void init(uint8_t dataPointSize, uint32_t length, DaRe::S_VALUE strategy) {
+    decoding.init(dataPointSize, length);
+    decoding.setStrategy(strategy);
+    decoding.setVerifier(verifier);
+  }
+  void decode(DaRe::Payload payload, uint32_t fcntup) { decoding.decode(payload, fcntup); }
+  void finish() { decoding.flushBuffers(); }
+  bool isReceived(uint32_t fcntup) { return decoding.isReceived(fcntup); }
+  uint8_t *getDataPoint(uint32_t fcntup) { return decoding.getDataPoint(fcntup); }
+  void destroy() { decoding.destroy(); }
+};
+
+/*
+ * The production decoder, which runs without any knowledge of the ground truth
+ */
+class ProductionVariant : public DecoderVariant {
+  DaReDecode decoding;
+public:
+  const char *name() { return "production"; }
+  void init(uint8_t dataPointSize, uint32_t length, DaRe::S_VALUE strategy) {
+    decoding.init(dataPointSize, length);
+    decoding.setStrategy(strategy);
+  }
+  void decode(DaRe::Payload payload, uint32_t fcntup) { decoding.decode(payload, fcntup); }
+  void finish() { decoding.flushBuffers(); }
+  bool isReceived(uint32_t fcntup) { return decoding.isReceived(fcntup); }
+  uint8_t *getDataPoint(uint32_t fcntup) { return decoding.getDataPoint(fcntup); }
+  void destroy() { decoding.destroy(); }
+};
+
+/*
+ * Decoders that share one plan cache, which is kept over all trials so that the trials also hit plans made by earlier
+ * trials with other data point sizes and loss patterns
+ */
+class PlanCacheVariant : public DecoderVariant {
+  DaReDecode decoding;
+  DaRePlanCache *planCache;
+public:
+  PlanCacheVariant(DaRePlanCache *planCacheIn) : planCache(planCacheIn) {}
+  const char *name() { return "plan-cache"; }
+  void init(uint8_t dataPointSize, uint32_t length, DaRe::S_VALUE strategy) {
+    decoding.init(dataPointSize, length);
+    decoding.setStrategy(strategy);
+    decoding.setPlanCache(planCache);
+  }
+  void decode(DaRe::Payload payload, uint32_t fcntup) { decoding.decode(payload, fcntup); }
+  void finish() { decoding.flushBuffers(); }
+  bool isReceived(uint32_t fcntup) { return decoding.isReceived(fcntup); }
+  uint8_t *getDataPoint(uint32_t fcntup) { return decoding.getDataPoint(fcntup); }
+  void destroy() { decoding.destroy(); }
+};
+
+/*
+ * The decoder under a memory budget of a few parity checks, which evicts buffered parity checks long before the
+ * buffer pool would, so it may recover less. No bound holds on the set: any buffer of the reference can be evicted
+ * before it becomes solvable, so the deficit can be every data point the reference decoded from buffers, and the
+ * budget evicts by recovery value where the pool evicts by age, so it can keep a parity check the reference lost and
+ * recover more. Only the values are checked
+ */
+class BudgetVariant : public DecoderVariant {
+  DaReDecode decoding;
+  DaReMemoryBudget budget;
+public:
+  const char *name() { return "budget"; }
+  bool sameRecoveredSet() { return false; }
+  bool mayRecoverMore() { return true; }
+  void init(uint8_t dataPointSize, uint32_t length, DaRe::S_VALUE strategy) {
+    decoding.init(dataPointSize, length);
+    decoding.setStrategy(strategy);
+    budget.init(DIFFERENTIAL_BUDGET_CHECKS * (sizeof(DaReBufferPool::buffer) + dataPointSize + DARE_MAX_W));
+    decoding.setMemoryBudget(&budget);
+  }
+  void decode(DaRe::Payload payload, uint32_t fcntup) { decoding.decode(payload, fcntup); }
+  void finish() { decoding.flushBuffers(); }
+  bool isReceived(uint32_t fcntup) { return decoding.isReceived(fcntup); }
+  uint8_t *getDataPoint(uint32_t fcntup) { return decoding.getDataPoint(fcntup); }
+  void destroy() {
+    decoding.destroy();
+    budget.destroy();
+  }
+};
+
+/*
+ * The decoder with deferred elimination, where the elimination of several frames is coalesced. With a time budget the
+ * elimination is run in calls of that budget until it completes, as the worker does. Every call has to make progress,
+ * a call that recovers nothing must complete the elimination, so more calls than data points mean it stalled
+ */
+class DeferredVariant : public DecoderVariant {
+  DaReDecode decoding;
+  uint32_t framesPerElimination;
+  uint32_t budgetMicroseconds;
+  uint32_t length = 0;
+  uint32_t frames = 0;
+  bool aggregated = false;
+  bool stalled = false;
+public:
+  DeferredVariant(uint32_t framesPerEliminationIn, uint32_t budgetMicrosecondsIn = 0) : framesPerElimination(framesPerEliminationIn), budgetMicroseconds(budgetMicrosecondsIn) {}
+  const char *name() { return (budgetMicroseconds > 0) ? "deferred-budget" : ((framesPerElimination == 1) ? "deferred" : "deferred-coalesced"); }
+  // coalescing changes which parity checks meet in the buffers, a frame of k readings coalesces k of them. That can
+  // also keep a parity check that the reference evicted, so it may recover more
+  bool sameRecoveredSet() { return framesPerElimination == 1 && !aggregated; }
+  bool mayRecoverMore() { return true; }
+  bool isConsistent() { return !stalled; }
+  void init(uint8_t dataPointSize, uint32_t lengthIn, DaRe::S_VALUE strategy) {
+    length = lengthIn;
+    decoding.init(dataPointSize, length);
+    decoding.setStrategy(strategy);
+    decoding.setDeferredElimination(true);
+  }
+  void decode(DaRe::Payload payload, uint32_t fcntup) {
+    aggregated |= DaRe::getK(payload.payload) > 1;
+    decoding.decode(payload, fcntup);
+    if (++frames % framesPerElimination == 0) {
+      uint32_t calls = 1;
+      while (!decoding.runElimination(budgetMicroseconds) && !stalled) {
+        stalled = ++calls > length + 1;
+      }
+    }
+  }
+  void finish() { decoding.flushBuffers(); }
+  bool isReceived(uint32_t fcntup) { return decoding.isReceived(fcntup); }
+  uint8_t *getDataPoint(uint32_t fcntup) { return decoding.getDataPoint(fcntup); }
+  void destroy() { decoding.destroy(); }
+};
+
+/*
+ * The decoder in lazy mode, where a consumer queries the newest data points every few frames, or never. The log is
+ * replayed in one go, so the buffers can end up with other parity checks than frame by frame. The replay runs before
+ * any logged data point is doomed and sees every parity check the reference saw, so it must recover at least as much;
+ * it can recover more when the reference evicted a parity check that the replay still has
+ */
+class LazyVariant : public DecoderVariant {
+  DaReDecode decoding;
+  uint32_t framesPerQuery;
+public:
+  LazyVariant(uint32_t framesPerQueryIn) : framesPerQuery(framesPerQueryIn) {}
+  const char *name() { return (framesPerQuery == 0) ? "lazy" : "lazy-query"; }
+  bool sameRecoveredSet() { return false; }
+  bool mayRecoverMore() { return true; }
+  bool mayRecoverFewer() { return false; }
+  void init(uint8_t dataPointSize, uint32_t length, DaRe::S_VALUE strategy) {
+    decoding.init(dataPointSize, length);
+    decoding.setStrategy(strategy);
+    decoding.setLazyRecovery(true);
+  }
+  void decode(DaRe::Payload payload, uint32_t fcntup) {
+    decoding.decode(payload, fcntup);
+    if (framesPerQuery > 0 && fcntup % framesPerQuery == 0) {
+      decoding.query(fcntup - framesPerQuery + 1, fcntup);
+    }
+  }
+  void finish() { decoding.flushBuffers(); }
+  bool isReceived(uint32_t fcntup) { return decoding.isReceived(fcntup); }
+  uint8_t *getDataPoint(uint32_t fcntup) { return decoding.getDataPoint(fcntup); }
+  void destroy() { decoding.destroy(); }
+};
+
+/*
+ * The decoder fed with batches of read-only frames, as a network server would hand over the frames of one uplink
+ * message. The elimination still runs frame by frame, only the delivery is batched. Every batch starts with a copy of
+ * its first frame cut one byte short, which the decoder has to drop: if it read the missing byte from the next frame in
+ * the receive buffer instead, the values would be wrong
+ */
+class BatchVariant : public DecoderVariant {
+  DaReDecode decoding;
+  uint32_t framesPerBatch;
+  std::vector<uint8_t> receiveBuffer; // the payloads of the current batch, back to back
+  std::vector<uint32_t> fcntups;
+  std::vector<uint8_t> payloadSizes;
+  uint32_t truncatedFrames = 0;
+
+  void decodePending() {
+    std::vector<DaReDecode::Frame> batch(fcntups.size());
+    size_t frame_i, offset = 0;
+    for (frame_i = 0; frame_i < batch.size(); frame_i++) {
+      batch[frame_i].fcntup = fcntups[frame_i];
+      batch[frame_i].payload = &receiveBuffer[offset];
+      batch[frame_i].payloadSize = payloadSizes[frame_i];
+      offset += payloadSizes[frame_i];
+    }
+    decoding.decodeBatch(batch.data(), batch.size());
+    receiveBuffer.clear();
+    fcntups.clear();
+    payloadSizes.clear();
+  }
+public:
+  BatchVariant(uint32_t framesPerBatchIn) : framesPerBatch(framesPerBatchIn) {}
+  const char *name() { return "batch"; }
+  void init(uint8_t dataPointSize, uint32_t length, DaRe::S_VALUE strategy) {
+    decoding.init(dataPointSize, length);
+    decoding.setStrategy(strategy);
+  }
+  bool isConsistent() { return decoding.getMalformedFrames() == truncatedFrames; }
+  void decode(DaRe::Payload payload, uint32_t fcntup) {
+    if (fcntups.empty()) {
+      receiveBuffer.insert(receiveBuffer.end(), payload.payload, payload.payload + payload.payloadSize - 1);
+      fcntups.push_back(fcntup);
+      payloadSizes.push_back(payload.payloadSize - 1);
+      truncatedFrames++;
+    }
+    receiveBuffer.insert(receiveBuffer.end(), payload.payload, payload.payload + payload.payloadSize);
+    fcntups.push_back(fcntup);
+    payloadSizes.push_back(payload.payloadSize);
+    if (fcntups.size() == framesPerBatch + 1) {
+      decodePending();
+    }
+  }
+  void finish() {
+    decodePending();
+    decoding.flushBuffers();
+  }
+  bool isReceived(uint32_t fcntup) { return decoding.isReceived(fcntup); }
+  uint8_t *getDataPoint(uint32_t fcntup) { return decoding.getDataPoint(fcntup); }
+  void destroy() { decoding.destroy(); }
+};
+
+/*
+ * The compact session, which only keeps a window and passes the data points on through the delivery callback. It
+ * ignores the parity checks of GF(256) frames, so only then it may recover less. It holds every parity check of its
+ * window where the reference can evict buffers from a small pool, so with GF(2) it may recover more but never less
+ */
+class SessionVariant : public DecoderVariant {
+  DaReSession session;
+  uint8_t dataPointSize;
+  std::vector<uint8_t> values;
+  std::vector<bool> delivered;
+
+  static void collect(void *context, uint32_t fcntup, uint8_t *dataPoint, bool received, uint8_t /*phase*/, uint32_t /*delay*/) {
+    SessionVariant *variant = (SessionVariant *)context;
+    if (received) {
+      std::copy(dataPoint, dataPoint + variant->dataPointSize, variant->values.begin() + (fcntup - 1) * variant->dataPointSize);
+      variant->delivered[fcntup - 1] = true;
+    }
+  }
+public:
+  const char *name() { return "session"; }
+  bool sameRecoveredSet() { return false; }
+  bool mayRecoverMore() { return true; }
+  bool mayRecoverFewer() { return session.getRejectedChecks() > 0; }
+  void init(uint8_t dataPointSizeIn, uint32_t length, DaRe::S_VALUE strategy) {
+    dataPointSize = dataPointSizeIn;
+    values.assign(length * dataPointSize, 0);
+    delivered.assign(length, false);
+    session.init(dataPointSize);
+    session.setStrategy(strategy);
+    session.setDeliveryCallback(collect, this);
+  }
+  void decode(DaRe::Payload payload, uint32_t fcntup) { session.decode(payload, fcntup); }
+  void finish() { session.flush(); }
+  bool isReceived(uint32_t fcntup) { return delivered[fcntup - 1]; }
+  uint8_t *getDataPoint(uint32_t fcntup) { return &values[(fcntup - 1) * dataPointSize]; }
+  void destroy() { session.destroy(); }
+};
+
+/*
+ * The compact session in a session store with room for one session in memory. A frame of a second device comes
+ * between all frames, so the session is written to the file and read back for every frame
+ */
+class SessionStoreVariant : public DecoderVariant {
+  DaReSessionStore store;
+  uint32_t rejectedChecks = 0;
+  uint32_t refusedFrames = 0;
+  std::string path;
+  uint8_t dataPointSize;
+  std::vector<uint8_t> values;
+  std::vector<bool> delivered;
+  std::vector<uint8_t> otherPayload;
+
+  static void collect(void *context, uint32_t deviceId, uint32_t fcntup, uint8_t *dataPoint, bool received, uint8_t /*phase*/, uint32_t /*delay*/) {
+    SessionStoreVariant *variant = (SessionStoreVariant *)context;
+    if (deviceId == 0 && received) {
+      std::copy(dataPoint, dataPoint + variant->dataPointSize, variant->values.begin() + (fcntup - 1) * variant->dataPointSize);
+      variant->delivered[fcntup - 1] = true;
+    }
+  }
+public:
+  const char *name() { return "session-store"; }
+  bool sameRecoveredSet() { return false; }
+  bool mayRecoverMore() { return true; }
+  bool mayRecoverFewer() { return rejectedChecks > 0; } // see SessionVariant
+  bool isConsistent() { return refusedFrames == 0; }
+  void init(uint8_t dataPointSizeIn, uint32_t length, DaRe::S_VALUE strategy) {
+    dataPointSize = dataPointSizeIn;
+    values.assign(length * dataPointSize, 0);
+    delivered.assign(length, false);
+    path = getTemporaryPath(DIFFERENTIAL_STORE_FILE);
+    store.init(path.c_str(), dataPointSize, 1);
+    store.setStrategy(strategy);
+    store.setDeliveryCallback(collect, this);
+    otherPayload.assign(1 + dataPointSize, 0); // R = 1/2 without parity checks, W = 0
+  }
+  void decode(DaRe::Payload payload, uint32_t fcntup) {
+    DaRe::Payload other;
+    if (!store.decode(0, payload, fcntup)) {
+      refusedFrames++;
+    }
+    other.payload = otherPayload.data();
+    other.payloadSize = (uint8_t)otherPayload.size();
+    if (!store.decode(1, other, fcntup)) {
+      refusedFrames++;
+    }
+  }
+  void finish() {
+    DaReSession *session = store.getSession(0);
+    if (session == NULL) {
+      refusedFrames++;
+      return;
+    }
+    session->flush();
+    rejectedChecks = session->getRejectedChecks();
+  }
+  bool isReceived(uint32_t fcntup) { return delivered[fcntup - 1]; }
+  uint8_t *getDataPoint(uint32_t fcntup) { return &values[(fcntup - 1) * dataPointSize]; }
+  void destroy() {
+    store.destroy();
+    std::remove(path.c_str());
+  }
+};
+
+/*
+ * The decoder behind a reorder window, fed with frames shuffled within blocks as parallel pipelines would deliver them.
+ * With a window deeper than the shuffle, all frames are released in order and the result must equal the reference,
+ * with a shallower window some frames arrive late
+ */
+class ReorderVariant : public DecoderVariant {
+  DaReDecode decoding;
+  DaReReorder reorder;
+  uint8_t shuffleBlock;
+  uint8_t depth;
+  std::mt19937 rng;
+  std::vector<std::pair<uint32_t, std::vector<uint8_t> > > block;
+  uint32_t now = 0;
+
+  void pushBlock() {
+    DaRe::Payload payload;
+    size_t i;
+    std::shuffle(block.begin(), block.end(), rng);
+    for (i = 0; i < block.size(); i++) {
+      payload.payload = &block[i].second[0];
+      payload.payloadSize = (uint8_t)block[i].second.size();
+      reorder.push(payload, block[i].first, now++);
+    }
+    block.clear();
+  }
+public:
+  ReorderVariant(uint8_t shuffleBlockIn, uint8_t depthIn) : shuffleBlock(shuffleBlockIn), depth(depthIn), rng(shuffleBlockIn * 31 + depthIn) {}
+  const char *name() { return (depth >= 2 * shuffleBlock) ? "reorder" : "reorder-late"; }
+  bool sameRecoveredSet() { return depth >= 2 * shuffleBlock; } // late frames come too late for some parity checks
+  bool mayRecoverMore() { return true; } // a late parity check meets other buffers than in order
+  void init(uint8_t dataPointSize, uint32_t length, DaRe::S_VALUE strategy) {
+    decoding.init(dataPointSize, length);
+    decoding.setStrategy(strategy);
+    reorder.init(&decoding, depth, DARE_REORDER_HOLD_FOREVER);
+  }
+  void decode(DaRe::Payload payload, uint32_t fcntup) {
+    block.push_back(std::make_pair(fcntup, std::vector<uint8_t>(payload.payload, payload.payload + payload.payloadSize)));
+    if (block.size() == shuffleBlock) {
+      pushBlock();
+    }
+  }
+  void finish() {
+    pushBlock();
+    reorder.flush();
+    decoding.flushBuffers();
+  }
+  bool isReceived(uint32_t fcntup) { return decoding.isReceived(fcntup); }
+  uint8_t *getDataPoint(uint32_t fcntup) { return decoding.getDataPoint(fcntup); }
+  void destroy() {
+    reorder.destroy();
+    decoding.destroy();
+  }
+};
+
+/*
+ * Draw a loss pattern, either with independent losses or with bursts (Gilbert-Elliott channel)
+ */
+static void getLossPattern(std::mt19937 &rng, std::vector<bool> &lost, uint32_t length) {
+  std::uniform_real_distribution<double> uniform(0.0, 1.0);
+  double p_e = 0.01 + 0.5 * uniform(rng);
+  bool bursty = uniform(rng) < 0.5;
+  double p_goodToBad = p_e / 4, p_badToGood = 0.25;
+  bool bad = false;
+  uint32_t i;
+
+  lost.assign(length, false);
+  for (i = 0; i < length; i++) {
+    if (bursty) {
+      bad = bad ? (uniform(rng) >= p_badToGood) : (uniform(rng) < p_goodToBad);
+      lost[i] = bad;
+    } else {
+      lost[i] = uniform(rng) < p_e;
+    }
+  }
+}
+
+/*
+ * Run the reference decoder and all decoder variants on identical randomized loss patterns
+ * and compare the recovered data point sets and values.
+ * @param trials - number of randomized runs
+ * @param seed - random seed, to be able to reproduce a failing run
+ * @return 0 if all variants agree with the reference and the ground truth, 1 otherwise
+ */
+int differentialTest(uint32_t trials, uint32_t seed) {
+  std::mt19937 rng(seed);
+  std::vector<bool> lost;
+  std::vector<uint8_t> frames, truth, aggregatedFrames;
+  std::vector<uint8_t> frameSizes;
+  uint8_t payloadCopy[2 + DIFFERENTIAL_MAX_DATA_POINT_SIZE * 5 * DIFFERENTIAL_MAX_K];
+  uint32_t trial, fcntup, failures = 0, i;
+  size_t variantI;
+  DaRePlanCache planCache;
+
+  planCache.init();
+
+  for (trial = 0; trial < trials; trial++) {
+    DaRe::R_VALUE R = (DaRe::R_VALUE)(rng() % 4);
+    DaRe::W_VALUE W = (DaRe::W_VALUE)(1 + rng() % 7);
+    DaRe::F_VALUE F = (DaRe::F_VALUE)(rng() % 2);
+    DaRe::S_VALUE S = (rng() % 4 == 0) ? DaRe::S_REPETITION : DaRe::S_DARE;
+    uint8_t dataPointSize = (uint8_t)(1 + rng() % DIFFERENTIAL_MAX_DATA_POINT_SIZE);
+    uint32_t length = 100 + rng() % (DIFFERENTIAL_MAX_LENGTH - 100);
+    uint32_t frameSize = 1 + 2 * dataPointSize * 5;
+    uint8_t degrees[DaRe::W_64 + 1], table = 0, k = 1;
+
+    // a quarter of the trials signal a random degree table in the extension byte
+    if (rng() % 4 == 0) {
+      for (i = DaRe::W_0; i <= DaRe::W_64; i++) {
+        degrees[i] = (uint8_t)(rng() % (DaRe::getW((DaRe::W_VALUE)i) + 1));
+      }
+      table = DIFFERENTIAL_DEGREE_TABLE;
+      DaRe::setDegreeTable(table, degrees);
+    }
+
+    // a quarter of the trials aggregate k readings per frame. The reference decodes the frames of one reading, the
+    // other variants the frames of k readings, with the same frames lost
+    if (rng() % 4 == 0) {
+      k = (uint8_t)(2 + rng() % (DIFFERENTIAL_MAX_K - 1));
+      length -= length % k;
+    }
+
+    DaReVerifier verifier;
+    verifier.init(dataPointSize, length);
+    std::vector<DecoderVariant *> variants;
+    variants.push_back(new ReferenceVariant(&verifier));
+    variants.push_back(new ProductionVariant());
+    variants.push_back(new DeferredVariant(1));
+    variants.push_back(new DeferredVariant(4));
+    variants.push_back(new DeferredVariant(1, 1));
+    variants.push_back(new ReorderVariant(4, 8));
+    variants.push_back(new ReorderVariant(4, 1));
+    variants.push_back(new LazyVariant(0));
+    variants.push_back(new LazyVariant(10));
+    variants.push_back(new SessionVariant());
+    variants.push_back(new BatchVariant(8));
+    variants.push_back(new PlanCacheVariant(&planCache));
+    variants.push_back(new BudgetVariant());
+    variants.push_back(new SessionStoreVariant());
+
+    // encode all frames once, all variants receive identical payloads
+    DaRe::Payload payload;
+    DaReEncode encoding;
+    encoding.init(&payload, dataPointSize, DaRe::R_1_5, DaRe::W_64);
+    encoding.set(R, W);
+    encoding.setF(F);
+    encoding.setStrategy(S);
+    encoding.setDegreeTable(table);
+    frames.assign(length * frameSize, 0);
+    frameSizes.assign(length, 0);
+    truth.assign(length * dataPointSize, 0);
+    for (fcntup = 1; fcntup <= length; fcntup++) {
+      for (i = 0; i < dataPointSize; i++) {
+        truth[(fcntup - 1) * dataPointSize + i] = (uint8_t)rng();
+      }
+      verifier.setDataPoint(fcntup, &truth[(fcntup - 1) * dataPointSize]);
+      encoding.encode(&payload, &truth[(fcntup - 1) * dataPointSize], fcntup);
+      std::copy(payload.payload, payload.payload + payload.payloadSize, frames.begin() + (fcntup - 1) * frameSize);
+      frameSizes[fcntup - 1] = payload.payloadSize;
+    }
+    encoding.destroy();
+    getLossPattern(rng, lost, length / k);
+
+    // the same data points in frames of k readings
+    uint32_t aggregatedSize = 2 + dataPointSize * DaRe::getR(R) * k;
+    if (k > 1) {
+      encoding.init(&payload, dataPointSize, DaRe::R_1_5, DaRe::W_64, k);
+      encoding.set(R, W);
+      encoding.setF(F);
+      encoding.setStrategy(S);
+      encoding.setDegreeTable(table);
+      encoding.setK(k);
+      aggregatedFrames.assign(length / k * aggregatedSize, 0);
+      for (fcntup = 1; fcntup <= length / k; fcntup++) {
+        encoding.encode(&payload, &truth[(fcntup - 1) * k * dataPointSize], fcntup);
+        std::copy(payload.payload, payload.payload + payload.payloadSize, aggregatedFrames.begin() + (fcntup - 1) * aggregatedSize);
+      }
+      encoding.destroy();
+    }
+
+    // decode with every variant, each with its own copy of the payloads since decoding is allowed to modify them
+    for (variantI = 0; variantI < variants.size(); variantI++) {
+      variants[variantI]->init(dataPointSize, length, S);
+      if (k > 1 && variantI > 0) {
+        for (fcntup = 1; fcntup <= length / k; fcntup++) {
+          if (lost[fcntup - 1]) {
+            continue;
+          }
+          std::copy(aggregatedFrames.begin() + (fcntup - 1) * aggregatedSize, aggregatedFrames.begin() + fcntup * aggregatedSize, payloadCopy);
+          payload.payload = payloadCopy;
+          payload.payloadSize = (uint8_t)aggregatedSize;
+          variants[variantI]->decode(payload, fcntup);
+        }
+        variants[variantI]->finish();
+        continue;
+      }
+      for (fcntup = 1; fcntup <= length; fcntup++) {
+        if (lost[(fcntup - 1) / k]) {
+          continue;
+        }
+        std::copy(frames.begin() + (fcntup - 1) * frameSize, frames.begin() + (fcntup - 1) * frameSize + frameSizes[fcntup - 1], payloadCopy);
+        payload.payload = payloadCopy;
+        payload.payloadSize = frameSizes[fcntup - 1];
+        variants[variantI]->decode(payload, fcntup);
+      }
+      variants[variantI]->finish();
+    }
+
+    // compare every variant with the reference, and the values with the ground truth
+    for (variantI = 0; variantI < variants.size(); variantI++) {
+      uint32_t setDifferences = 0, valueDifferences = 0, extra = 0;
+      for (fcntup = 1; fcntup <= length; fcntup++) {
+        bool received = variants[variantI]->isReceived(fcntup);
+        if (received != variants[0]->isReceived(fcntup)) {
+          setDifferences++;
+          extra += received ? 1 : 0;
+        }
+        if (received && !std::equal(truth.begin() + (fcntup - 1) * dataPointSize, truth.begin() + fcntup * dataPointSize, variants[variantI]->getDataPoint(fcntup))) {
+          valueDifferences++;
+        }
+      }
+      if (!variants[variantI]->isConsistent()) {
+        failures++;
+        std::cout << "trial " << trial << " (seed " << seed << "): " << variants[variantI]->name() << " is inconsistent" << std::endl;
+      }
+      bool allowed = !variants[variantI]->sameRecoveredSet() && (extra == 0 || variants[variantI]->mayRecoverMore())
+        && (setDifferences == extra || variants[variantI]->mayRecoverFewer());
+      if (allowed && valueDifferences == 0) {
+        if (setDifferences > 0) {
+          std::cout << "trial " << trial << ": " << variants[variantI]->name() << " recovered " << extra << " more and "
+            << (setDifferences - extra) << " fewer data points (allowed)" << std::endl;
+        }
+      } else if (setDifferences > 0 || valueDifferences > 0) {
+        failures++;
+        std::cout << "trial " << trial << " (seed " << seed << "): " << variants[variantI]->name()
+          << " R=" << (int)DaRe::getR(R) << " W=" << (int)DaRe::getW(W) << " F=" << (int)F << " S=" << (int)S << " table=" << (int)table << " k=" << (int)k << " size=" << (int)dataPointSize << " length=" << length
+          << ": " << extra << " more and " << (setDifferences - extra) << " fewer data points, " << valueDifferences << " wrong values" << std::endl;
+      }
+    }
+
+    for (variantI = 0; variantI < variants.size(); variantI++) {
+      variants[variantI]->destroy();
+      delete variants[variantI];
+    }
+    verifier.destroy();
+  }
+
+  std::cout << trials << " trials, " << failures << " failures, " << planCache.getHits() << " plan cache hits, " << planCache.getMisses() << " misses" << std::endl;
+  planCache.destroy();
+  return (failures == 0) ? 0 : 1;
+}
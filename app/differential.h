@@ -0,0 +1,39 @@
+/*
+/ _____)             _              | |
+( (____  _____ ____ _| |_ _____  ____| |__
+\____ \| ___ |    (_   _) ___ |/ ___)  _ \
+_____) ) ____| | | || |_| ____( (___| | | |
+(______/|_____)_|_|_| \__)_____)\____)_| |_|
+(C)2017 Semtech
+
+Description: Differential verification of decoder variants against the reference decoder
+License: Revised BSD License, see LICENSE file included in the project
+By: Paul Marcelis
+*/
+#include "DaRe.h"
+
+#ifndef __DARE_DIFFERENTIAL_H
+#define __DARE_DIFFERENTIAL_H
+
+/*
+ * Interface a decoder variant has to implement to be compared with the reference decoder
+ */
+class DecoderVariant {
+public:
+  virtual ~DecoderVariant() {}
+  virtual const char *name() = 0;
+  virtual bool sameRecoveredSet() { return true; } // false if the variant may legitimately recover a different set, values must still be correct
+  virtual bool mayRecoverMore() { return false; } // with a different set, whether it may hold data points the reference does not
+  virtual bool mayRecoverFewer() { return true; } // with a different set, whether it may miss data points the reference has
+  virtual bool isConsistent() { return true; } // false if the counters of the variant disagree with what it was fed
+  virtual void init(uint8_t dataPointSize, uint32_t length, DaRe::S_VALUE strategy) = 0;
+  virtual void decode(DaRe::Payload payload, uint32_t fcntup) = 0;
+  virtual void finish() = 0;
+  virtual bool isReceived(uint32_t fcntup) = 0;
+  virtual uint8_t *getDataPoint(uint32_t fcntup) = 0;
+  virtual void destroy() = 0;
+};
+
+int differentialTest(uint32_t trials, uint32_t seed);
+
+#endif
@@ -11,67 +11,425 @@ License: Revised BSD License, see LICENSE file included in the project
 By: Paul Marcelis
 */
 
+#include <algorithm>
 #include <iostream>
+#include <vector>
+#include <string.h>
+#include <stdlib.h>
 #include <time.h>
 #include "utilities.h"
 #include "DaRe.h" // the DEBUG flag in this file determines the simulation output
 #include "DaReEncode.h"
 #include "DaReDecode.h"
+#include "DaReVerifier.h"
+#include "DaRePrecode.h"
+#include "differential.h"
+#include "worstcase.h"
+#include "benchmark.h"
+#include "packetforwarder.h"
+#include "sequential.h"
+#include "rareevent.h"
+#include "tuner.h"
+#include "network.h"
+#include "airtime.h"
 
 #define SIMULATION_LENGTH 100000 // Number of frames to send for one run
 #define DATA_POINT_SIZE 2
 
 uint8_t *getDataPoint();
-void simulation(DaRe::R_VALUE, DaRe::W_VALUE, int);
+void simulation(DaRe::R_VALUE, DaRe::W_VALUE, int, DaRe::F_VALUE = DaRe::F_GF2, DaRe::S_VALUE = DaRe::S_DARE, uint8_t = 1);
+void compareFields();
+void compareStrategies();
+void comparePrecoding(int, uint32_t);
+void compareAirtime(int);
+void compareAggregation(int, DaRe::R_VALUE, DaRe::W_VALUE);
 
-int main() {
+LoRaAirtime modulation; // the modulation of the simulated frames, for their time on air
+
+int main(int argc, char *argv[]) {
   // Set random seed
   srand((unsigned int)time(NULL));
 
+  // differential verification of the decoder variants: verify [trials] [seed]
+  if (argc > 1 && strcmp(argv[1], "verify") == 0) {
+    uint32_t trials = (argc > 2) ? (uint32_t)atoi(argv[2]) : 200;
+    uint32_t seed = (argc > 3) ? (uint32_t)atoi(argv[3]) : (uint32_t)time(NULL);
+    return differentialTest(trials, seed);
+  }
+
+  // emulated devices sending PUSH_DATA packets to localhost: loadgen [devices] [frames/s] [seconds] [R] [W] [p_e] [port]
+  if (argc > 1 && strcmp(argv[1], "loadgen") == 0) {
+    uint32_t devices = (argc > 2) ? (uint32_t)atoi(argv[2]) : 1000;
+    double framesPerSecond = (argc > 3) ? atof(argv[3]) : 10000;
+    uint32_t seconds = (argc > 4) ? (uint32_t)atoi(argv[4]) : 10;
+    int R = (argc > 5) ? atoi(argv[5]) : 3, W = (argc > 6) ? atoi(argv[6]) : 16;
+    int p_e = (argc > 7) ? atoi(argv[7]) : 30;
+    uint16_t port = (argc > 8) ? (uint16_t)atoi(argv[8]) : PF_DEFAULT_PORT;
+    DaRe::R_VALUE Rv = DaRe::R_1_2;
+    DaRe::W_VALUE Wv = DaRe::W_1;
+    while (Rv < DaRe::R_1_5 && DaRe::getR(Rv) < R) Rv = (DaRe::R_VALUE)(Rv + 1);
+    while (Wv < DaRe::W_64 && DaRe::getW(Wv) < W) Wv = (DaRe::W_VALUE)(Wv + 1);
+    loadGenerator(devices, framesPerSecond, seconds, Rv, Wv, p_e, port);
+    return 0;
+  }
+
+  // network server front-end decoding the PUSH_DATA packets: ingest [port] [frames per device]
+  if (argc > 1 && strcmp(argv[1], "ingest") == 0) {
+    ingest((argc > 2) ? (uint16_t)atoi(argv[2]) : PF_DEFAULT_PORT, (argc > 3) ? (uint32_t)atoi(argv[3]) : 100000);
+    return 0;
+  }
+
   // Start!
   std::cout << "DaRe Coding for LoRaWAN" << std::endl;
   std::cout << "Data point size: " << DATA_POINT_SIZE << " bytes" << std::endl;
     
   std::cout << std::endl;
-  std::cout << "R \tW \tp_e \tp_rr \trec \tphase1 \tphase2 \tphase3 \tphase4 \tphase5 \tavg_delay \tvar_delay" << std::endl;
+
+  // decode latency with inline and with deferred elimination: latency [budget in us]
+  if (argc > 1 && strcmp(argv[1], "latency") == 0) {
+    latencyBenchmark(DaRe::R_1_4, DaRe::W_64, 30, (argc > 2) ? (uint32_t)atoi(argv[2]) : 200);
+    return 0;
+  }
+
+  // simulations that stop at a given precision: sequential [p_rr precision] [delay precision] [max frames]
+  if (argc > 1 && strcmp(argv[1], "sequential") == 0) {
+    sequentialSweep((argc > 2) ? atof(argv[2]) : 0.5, (argc > 3) ? atof(argv[3]) : 0.1, (argc > 4) ? (uint32_t)atoi(argv[4]) : SIMULATION_LENGTH);
+    return 0;
+  }
+
+  // residual loss rate at low frame loss rates with importance sampling: rare [p_e] [episodes]
+  if (argc > 1 && strcmp(argv[1], "rare") == 0) {
+    rareEventSimulation(DaRe::R_1_3, DaRe::W_16, (argc > 2) ? atof(argv[2]) : 3, (argc > 3) ? (uint32_t)atoi(argv[3]) : 100000, 1);
+    return 0;
+  }
+
+  // compare DaRe with repetition coding at equal payload size
+  if (argc > 1 && strcmp(argv[1], "strategies") == 0) {
+    compareStrategies();
+    return 0;
+  }
+
+  // write the delivered data points to a memory-mapped column store: store [file]
+  if (argc > 1 && strcmp(argv[1], "store") == 0) {
+    columnStoreBenchmark((argc > 2) ? argv[2] : "dare_columns.bin");
+    return 0;
+  }
+
+  // collisions between many devices at one gateway: network [devices] [hours] [period s] [radius m]
+  if (argc > 1 && strcmp(argv[1], "network") == 0) {
+    networkSweep((argc > 2) ? (uint32_t)atoi(argv[2]) : 100000, (argc > 3) ? atof(argv[3]) : 24, (argc > 4) ? atof(argv[4]) : 600,
+      (argc > 5) ? atof(argv[5]) : 5000);
+    return 0;
+  }
+
+  // memory use of many compact sessions: sessions [count] [frames per session]
+  if (argc > 1 && strcmp(argv[1], "sessions") == 0) {
+    sessionBenchmark((argc > 2) ? (uint32_t)atoi(argv[2]) : 100000, (argc > 3) ? (uint32_t)atoi(argv[3]) : 200);
+    return 0;
+  }
+
+  // read the newest data points from other threads while decoding: snapshot [readers]
+  if (argc > 1 && strcmp(argv[1], "snapshot") == 0) {
+    snapshotBenchmark((argc > 2) ? (unsigned int)atoi(argv[2]) : 2);
+    return 0;
+  }
+
+  // ingest CPU time of eager and lazy recovery: lazy [p_e] [frames per query]
+  if (argc > 1 && strcmp(argv[1], "lazy") == 0) {
+    lazyBenchmark(DaRe::R_1_3, DaRe::W_16, (argc > 2) ? atoi(argv[2]) : 30, (argc > 3) ? (uint32_t)atoi(argv[3]) : 500);
+    return 0;
+  }
+
+  // ingest CPU time of single frames and batches of read-only frames: batch [p_e] [frames per batch]
+  if (argc > 1 && strcmp(argv[1], "batch") == 0) {
+    batchBenchmark(DaRe::R_1_3, DaRe::W_16, (argc > 2) ? atoi(argv[2]) : 30, (argc > 3) ? (uint32_t)atoi(argv[3]) : 16);
+    return 0;
+  }
+
+  // ingest CPU time with and without a plan cache shared by the sessions: plans [p_e] [sessions]
+  if (argc > 1 && strcmp(argv[1], "plans") == 0) {
+    planCacheBenchmark(DaRe::R_1_3, DaRe::W_16, (argc > 2) ? atoi(argv[2]) : 10, (argc > 3) ? (uint32_t)atoi(argv[3]) : 200);
+    return 0;
+  }
+
+  // memory of the pending parity checks of all sessions through an outage, with and without a budget: budget [KiB] [p_e] [sessions]
+  if (argc > 1 && strcmp(argv[1], "budget") == 0) {
+    budgetBenchmark(DaRe::R_1_3, DaRe::W_32, (argc > 3) ? atoi(argv[3]) : 10, (argc > 2) ? (uint32_t)atoi(argv[2]) : 128,
+      (argc > 4) ? (uint32_t)atoi(argv[4]) : 200);
+    return 0;
+  }
+
+  // a fleet of sessions with only a part of them in memory: sessionstore [devices] [sessions in memory] [file]
+  if (argc > 1 && strcmp(argv[1], "sessionstore") == 0) {
+    sessionStoreBenchmark((argc > 2) ? (uint32_t)atoi(argv[2]) : 20000, (argc > 3) ? (uint32_t)atoi(argv[3]) : 1000,
+      (argc > 4) ? argv[4] : "sessions.dare");
+    return 0;
+  }
+
+  // genetic search for the slowest loss patterns: worst [generations] [population] [file] [seed], or worst replay [file]
+  if (argc > 1 && strcmp(argv[1], "worst") == 0) {
+    if (argc > 2 && strcmp(argv[2], "replay") == 0) {
+      return worstCaseReplay((argc > 3) ? argv[3] : "worstcase.txt");
+    }
+    worstCaseSearch((argc > 2) ? (uint32_t)atoi(argv[2]) : 30, (argc > 3) ? (uint32_t)atoi(argv[3]) : 24,
+      (argc > 4) ? argv[4] : "worstcase.txt", (argc > 5) ? (uint32_t)atoi(argv[5]) : 1);
+    return 0;
+  }
+
+  // search the degree per window size: tune [R] [threads] [delay weight] [cpu weight]
+  if (argc > 1 && strcmp(argv[1], "tune") == 0) {
+    degreeTuner((DaRe::R_VALUE)(((argc > 2) ? atoi(argv[2]) : 3) - 2), (argc > 3) ? (unsigned int)atoi(argv[3]) : 4,
+      (argc > 4) ? atof(argv[4]) : 0.1, (argc > 5) ? atof(argv[5]) : 0.1);
+    return 0;
+  }
+
+  // bytes on air per delivered reading with and without pre-coding: precode [p_e] [key interval]
+  if (argc > 1 && strcmp(argv[1], "precode") == 0) {
+    comparePrecoding((argc > 2) ? atoi(argv[2]) : 30, (argc > 3) ? (uint32_t)atoi(argv[3]) : 32);
+    return 0;
+  }
+
+  // time on air and duty cycle of the code rates: airtime [SF] [bandwidth kHz] [coding rate 1-4] [p_e] [implicit header]
+  if (argc > 1 && strcmp(argv[1], "airtime") == 0) {
+    modulation.init((argc > 2) ? (uint8_t)atoi(argv[2]) : 7, (argc > 3) ? (uint32_t)atoi(argv[3]) * 1000 : 125000,
+      (argc > 4) ? (uint8_t)atoi(argv[4]) : 1, !(argc > 6 && atoi(argv[6]) != 0));
+    compareAirtime((argc > 5) ? atoi(argv[5]) : 30);
+    return 0;
+  }
+
+  // several readings per frame, coded per reading: aggregate [p_e] [R] [W]
+  if (argc > 1 && strcmp(argv[1], "aggregate") == 0) {
+    int R = (argc > 3) ? atoi(argv[3]) : 2, W = (argc > 4) ? atoi(argv[4]) : 16;
+    DaRe::R_VALUE Rv = DaRe::R_1_2;
+    DaRe::W_VALUE Wv = DaRe::W_1;
+    while (Rv < DaRe::R_1_5 && DaRe::getR(Rv) < R) Rv = (DaRe::R_VALUE)(Rv + 1);
+    while (Wv < DaRe::W_64 && DaRe::getW(Wv) < W) Wv = (DaRe::W_VALUE)(Wv + 1);
+    compareAggregation((argc > 2) ? atoi(argv[2]) : 30, Rv, Wv);
+    return 0;
+  }
+
+  // compare plain XOR parity checks with GF(256) coefficients at equal payload size
+  if (argc > 1 && strcmp(argv[1], "fields") == 0) {
+    compareFields();
+    return 0;
+  }
+
+  std::cout << "R \tW \tF \tS \tp_e \tPHY \ttoa [ms] \tms/dp \tperiod [s] \tp_rr \trec \tphase1 \tphase2 \tphase3 \tphase4 \tphase5 \tavg_delay \tvar_delay" << std::endl;
 
 
   simulation(DaRe::R_1_2, DaRe::W_8, 10);
   return hang();
 }
 
-// if the p_e_percent parameter gives the percentage of frames to drop randomly.
-void simulation(DaRe::R_VALUE R, DaRe::W_VALUE W, int p_e_percent) {
-  uint32_t framesReceived = 0, fcntup;
+/*
+ * Sweep over R, W and p_e with both fields. The field is signalled in the header byte, so the payload size is equal for both
+ */
+void compareFields() {
+  DaRe::R_VALUE Rs[] = { DaRe::R_1_2, DaRe::R_1_3 };
+  DaRe::W_VALUE Ws[] = { DaRe::W_8, DaRe::W_16, DaRe::W_32 };
+  int p_es[] = { 10, 30, 50 };
+  int R_i, W_i, p_e_i;
+
+  std::cout << "R \tW \tF \tS \tp_e \tPHY \ttoa [ms] \tms/dp \tperiod [s] \tp_rr \trec \tphase1 \tphase2 \tphase3 \tphase4 \tphase5 \tavg_delay \tvar_delay" << std::endl;
+  for (R_i = 0; R_i < 2; R_i++) {
+    for (W_i = 0; W_i < 3; W_i++) {
+      for (p_e_i = 0; p_e_i < 3; p_e_i++) {
+        simulation(Rs[R_i], Ws[W_i], p_es[p_e_i], DaRe::F_GF2);
+        simulation(Rs[R_i], Ws[W_i], p_es[p_e_i], DaRe::F_GF256);
+      }
+    }
+  }
+}
+
+/*
+ * Sweep over R and p_e with DaRe and repetition coding, both strategies in one run
+ */
+void compareStrategies() {
+  DaRe::R_VALUE Rs[] = { DaRe::R_1_2, DaRe::R_1_3, DaRe::R_1_5 };
+  int p_es[] = { 10, 30, 50 };
+  int R_i, p_e_i;
+
+  std::cout << "R \tW \tF \tS \tp_e \tPHY \ttoa [ms] \tms/dp \tperiod [s] \tp_rr \trec \tphase1 \tphase2 \tphase3 \tphase4 \tphase5 \tavg_delay \tvar_delay" << std::endl;
+  for (R_i = 0; R_i < 3; R_i++) {
+    for (p_e_i = 0; p_e_i < 3; p_e_i++) {
+      simulation(Rs[R_i], DaRe::W_16, p_es[p_e_i], DaRe::F_GF2, DaRe::S_DARE);
+      simulation(Rs[R_i], DaRe::W_16, p_es[p_e_i], DaRe::F_GF2, DaRe::S_REPETITION);
+    }
+  }
+}
+
+// the network server side of the pre-coding simulation, fed by the delivery callback of the decoder
+struct PrecodeReceiver {
+  DaRePrecode precode;
+  std::vector<uint32_t> *readings; // all readings of the sensor
+  std::vector<uint32_t> *firstReading; // index of the first reading in the data point of each frame
+  uint32_t delivered, wrong;
+};
+
+void precodeDelivery(void *context, uint32_t fcntup, uint8_t *dataPoint, bool received, uint8_t /*phase*/, uint32_t /*delay*/) {
+  PrecodeReceiver *receiver = (PrecodeReceiver *)context;
+  uint32_t readings[8];
+  uint8_t count, reading_i;
+
+  count = receiver->precode.unpack(fcntup, dataPoint, received, readings);
+  for (reading_i = 0; reading_i < count; reading_i++) {
+    receiver->delivered++;
+    if (readings[reading_i] != (*receiver->readings)[(*receiver->firstReading)[fcntup - 1] + reading_i]) {
+      receiver->wrong++;
+    }
+  }
+}
+
+/*
+ * Send a slowly changing 16-bit sensor reading through the pre-coding, DaRe coding and a channel with random losses
+ * @param bits - low bits of a reading in a data point, 16 sends the readings in full
+ * @param readingsPerDataPoint - number of readings packed in one data point
+ * @param keyInterval - frames between key data points
+ * @param p_e_percent - percentage of frames lost
+ */
+void precodeSimulation(uint8_t bits, uint8_t readingsPerDataPoint, uint32_t keyInterval, int p_e_percent) {
+  std::vector<uint32_t> readings(SIMULATION_LENGTH), firstReading;
+  uint8_t dataPoints[2 * 8];
+  uint32_t reading_i, fcntup = 0, frameBytes = 0;
+  uint8_t written, dataPoint_i;
+  int32_t reading = 2000;
+  DaRePrecode precode;
+  PrecodeReceiver receiver;
+  DaRe::Payload payload;
+  DaReEncode encoding;
+  DaReDecode decoding;
+
+  precode.init(16, bits, readingsPerDataPoint, keyInterval);
+  receiver.precode.init(16, bits, readingsPerDataPoint, keyInterval);
+  receiver.readings = &readings;
+  receiver.firstReading = &firstReading;
+  receiver.delivered = 0;
+  receiver.wrong = 0;
+  encoding.init(&payload, precode.getDataPointSize(), DaRe::R_1_5, DaRe::W_64);
+  encoding.set(DaRe::R_1_3, DaRe::W_16);
+  decoding.init(precode.getDataPointSize(), 2 * SIMULATION_LENGTH);
+  decoding.setDeliveryCallback(precodeDelivery, &receiver);
+
+  // a random walk, as a temperature in steps of 0.01 degree
+  for (reading_i = 0; reading_i < SIMULATION_LENGTH; reading_i++) {
+    reading += (rand() % 7) - 3;
+    readings[reading_i] = (uint32_t)reading & 0xffff;
+    written = precode.pack(readings[reading_i], dataPoints);
+    for (dataPoint_i = 0; dataPoint_i < written; dataPoint_i++) {
+      fcntup++;
+      firstReading.push_back(reading_i + 1 - readingsPerDataPoint);
+      encoding.encode(&payload, &dataPoints[dataPoint_i * precode.getDataPointSize()], fcntup);
+      frameBytes += payload.payloadSize + AIRTIME_LORAWAN_OVERHEAD;
+      if ((rand() % 1000) >= p_e_percent * 10) {
+        decoding.decode(payload, fcntup);
+      }
+    }
+  }
+  decoding.flushBuffers();
+
+  std::cout << (int)bits << "\t" << (int)readingsPerDataPoint << "\t" << keyInterval << "\t" << (int)precode.getDataPointSize() << "\t"
+    << fcntup << "\t" << (double)frameBytes / fcntup << "\t" << (double)100 * receiver.delivered / SIMULATION_LENGTH << "\t"
+    << receiver.wrong << "\t";
+  if (receiver.delivered > receiver.wrong) {
+    std::cout << (double)frameBytes / (receiver.delivered - receiver.wrong) << std::endl;
+  } else {
+    std::cout << "-" << std::endl;
+  }
+
+  encoding.destroy();
+  decoding.destroy();
+  precode.destroy();
+  receiver.precode.destroy();
+}
+
+/*
+ * Compare sending 16-bit readings in full with sending only their low bits, one or several readings per data point
+ */
+void comparePrecoding(int p_e_percent, uint32_t keyInterval) {
+  std::cout << "bits \treadings \tkey \tsize \tframes \tbytes/frame \tdelivered \twrong \tbytes/reading" << std::endl;
+  precodeSimulation(16, 1, 0, p_e_percent);
+  precodeSimulation(8, 1, keyInterval, p_e_percent);
+  precodeSimulation(6, 4, keyInterval, p_e_percent);
+  precodeSimulation(4, 4, keyInterval, p_e_percent);
+}
+
+/*
+ * Sweep over R at one loss rate with the modulation settings, a higher R recovers more data points but every frame
+ * takes longer on air, so the duty cycle allows fewer of them
+ */
+void compareAirtime(int p_e_percent) {
+  DaRe::R_VALUE Rs[] = { DaRe::R_1_2, DaRe::R_1_3, DaRe::R_1_4, DaRe::R_1_5 };
+  int R_i;
+
+  std::cout << "SF" << (int)modulation.getSF() << ", " << modulation.getBandwidth() / 1000 << " kHz, CR 4/" << 4 + (int)modulation.getCodingRate()
+    << ", duty cycle " << 100 * AIRTIME_DUTY_CYCLE << "%" << std::endl;
+  std::cout << "R \tW \tF \tS \tp_e \tPHY \ttoa [ms] \tms/dp \tperiod [s] \tp_rr \trec \tphase1 \tphase2 \tphase3 \tphase4 \tphase5 \tavg_delay \tvar_delay" << std::endl;
+  for (R_i = 0; R_i < 4; R_i++) {
+    simulation(Rs[R_i], DaRe::W_16, p_e_percent);
+  }
+}
+
+/*
+ * Sweep over the number of readings per frame at one loss rate. Every frame has one header and one LoRaWAN overhead for
+ * k readings, so the time on air per reading drops, but a lost frame loses k readings at once
+ */
+void compareAggregation(int p_e_percent, DaRe::R_VALUE R, DaRe::W_VALUE W) {
+  uint8_t ks[] = { 1, 2, 4, 8 };
+  int k_i;
+
+  std::cout << "k \tR \tW \tF \tS \tp_e \tPHY \ttoa [ms] \tms/dp \tperiod [s] \tp_rr \trec \tphase1 \tphase2 \tphase3 \tphase4 \tphase5 \tavg_delay \tvar_delay" << std::endl;
+  for (k_i = 0; k_i < 4; k_i++) {
+    std::cout << (int)ks[k_i] << "\t";
+    simulation(R, W, p_e_percent, DaRe::F_GF2, DaRe::S_DARE, ks[k_i]);
+  }
+}
+
+// if the p_e_percent parameter gives the percentage of frames to drop randomly. With k readings per frame, the
+// simulation sends SIMULATION_LENGTH readings in SIMULATION_LENGTH / k frames, the delays are in readings
+void simulation(DaRe::R_VALUE R, DaRe::W_VALUE W, int p_e_percent, DaRe::F_VALUE F, DaRe::S_VALUE S, uint8_t k) {
+  uint32_t framesReceived = 0, fcntup, delivered = 0, phyPayloadSize = 0, frames = SIMULATION_LENGTH / k, reading_i;
+  double airtime = 0;
   uint8_t *dataPoint;
+  std::vector<uint8_t> readings(DATA_POINT_SIZE * k);
   DaRe::Payload payload;
   DaReEncode encoding;
   DaReDecode decoding;
+  DaReVerifier verifier;
 
   // Initialisation of encoder and decoder
-  encoding.init(&payload, DATA_POINT_SIZE, DaRe::R_1_5, DaRe::W_64);
+  encoding.init(&payload, DATA_POINT_SIZE, DaRe::R_1_5, DaRe::W_64, k);
   encoding.set(R, W);
+  encoding.setK(k);
+  encoding.setF(F);
+  encoding.setStrategy(S);
   decoding.init(DATA_POINT_SIZE, SIMULATION_LENGTH);
+  decoding.setStrategy(S);
+  verifier.init(DATA_POINT_SIZE, SIMULATION_LENGTH);
+  decoding.setVerifier(&verifier);
 
-  // simulate SIMULATION_LENGTH frames
-  for (fcntup = 1; fcntup <= SIMULATION_LENGTH; fcntup++) {
-    // get a random value
-    dataPoint = getDataPoint();
+  // simulate the frames
+  for (fcntup = 1; fcntup <= frames; fcntup++) {
+    for (reading_i = 0; reading_i < k; reading_i++) {
+      // get a random value
+      dataPoint = getDataPoint();
 
 #if DEBUG >= 2
-    std::cout << std::endl << "-------- fcntup " << fcntup << ", d[" << (fcntup - 1) << "] --------";
-    std::cout << std::endl << "Data: ";
-    displayCharArray(dataPoint, DATA_POINT_SIZE, 1, ' ');
-    std::cout << std::endl;
+      std::cout << std::endl << "-------- fcntup " << fcntup << ", d[" << ((fcntup - 1) * k + reading_i) << "] --------";
+      std::cout << std::endl << "Data: ";
+      displayCharArray(dataPoint, DATA_POINT_SIZE, 1, ' ');
+      std::cout << std::endl;
 #endif
 
-#if DEBUG >= 0
-    // Pass original data unit to decover to be able to compare results for debugging
-    decoding.debugData(fcntup, dataPoint);
-#endif
+      // Pass original data unit to the verifier to be able to compare results for debugging
+      verifier.setDataPoint((fcntup - 1) * k + reading_i + 1, dataPoint);
+      std::copy(dataPoint, dataPoint + DATA_POINT_SIZE, &readings[DATA_POINT_SIZE * reading_i]);
+      delete[] dataPoint;
+    }
 
     // encode
-    encoding.encode(&payload, dataPoint, fcntup);
+    encoding.encode(&payload, readings.data(), fcntup);
+    airtime += modulation.frameTimeOnAir(payload.payloadSize);
+    phyPayloadSize = AIRTIME_LORAWAN_OVERHEAD + payload.payloadSize;
 
 
 #if DEBUG >= 2
@@ -95,18 +453,35 @@ void simulation(DaRe::R_VALUE R, DaRe::W_VALUE W, int p_e_percent) {
     framesReceived++;
   }
   decoding.flushBuffers();
+  for (fcntup = 1; fcntup <= SIMULATION_LENGTH; fcntup++) {
+    delivered += decoding.isReceived(fcntup) ? 1 : 0;
+  }
 
+  // the time on air per delivered data point, and the shortest period between frames the duty cycle allows
 #if DEBUG >= 1
   std::cout << std::endl
     << "Send: \t\t" << SIMULATION_LENGTH << std::endl
+    << "PHY payload: \t" << phyPayloadSize << " bytes" << std::endl
+    << "Readings/frame: " << (int)k << std::endl
+    << "Time on air: \t" << 1000 * airtime / frames << " ms per frame, " << 1000 * airtime / delivered << " ms per data point" << std::endl
+    << "Period: \t" << airtime / frames / AIRTIME_DUTY_CYCLE << " s at the duty-cycle limit" << std::endl
+    << "F: \t\t" << ((F == DaRe::F_GF256) ? "GF(256)" : "GF(2)") << std::endl
+    << "S: \t\t" << ((S == DaRe::S_REPETITION) ? RepetitionStrategy::name() : DaReStrategy::name()) << std::endl
     << "p_e: \t\t" << p_e_percent << std::endl;
 #else
-  std::cout << (int)DaRe::getR(R) << "\t" << (int)DaRe::getW(W) << "\t" << p_e_percent << "\t";
+  std::cout << (int)DaRe::getR(R) << "\t" << (int)DaRe::getW(W) << "\t" << ((F == DaRe::F_GF256) ? 256 : 2) << "\t"
+    << ((S == DaRe::S_REPETITION) ? RepetitionStrategy::name() : DaReStrategy::name()) << "\t" << p_e_percent << "\t"
+    << phyPayloadSize << "\t" << 1000 * airtime / frames << "\t\t" << 1000 * airtime / delivered << "\t"
+    << airtime / frames / AIRTIME_DUTY_CYCLE << "\t\t";
 #endif
   decoding.displayResults();
+  if (verifier.getMismatches() > 0) {
+    std::cout << "Wrongly decoded data points: " << verifier.getMismatches() << std::endl;
+  }
 
   encoding.destroy();
   decoding.destroy();
+  verifier.destroy();
 }
 
 uint8_t *getDataPoint() {
@@ -0,0 +1,221 @@
+/*
+/ _____)             _              | |
+( (____  _____ ____ _| |_ _____  ____| |__
+\____ \| ___ |    (_   _) ___ |/ ___)  _ \
+_____) ) ____| | | || |_| ____( (___| | | |
+(______/|_____)_|_|_| \__)_____)\____)_| |_|
+(C)2017 Semtech
+
+Description: Discrete-event simulation of a LoRaWAN network, with frame losses from collisions at the gateway
+License: Revised BSD License, see LICENSE file included in the project
+By: Paul Marcelis
+*/
+
+#include <iostream>
+#include <vector>
+#include <queue>
+#include <random>
+#include <chrono>
+#include <cmath>
+#include "network.h"
+#include "DaReEncode.h"
+#include "DaReSession.h"
+
+#define NETWORK_SF_MIN 7
+#define NETWORK_SF_MAX 12
+
+/*
+ * gateway sensitivity in dBm for SF7 to SF12 at 125 kHz
+ */
+static const double sensitivity[] = { -123.0, -126.0, -129.0, -132.0, -134.5, -137.0 };
+
+/*
+ * A virtual device with its own encoder, and the decoder session on the network server
+ */
+struct NetworkDevice {
+  DaReEncode encoding;
+  DaRe::Payload payload;
+  DaReSession session;
+  uint32_t fcntup = 0;
+  uint8_t SF;
+  double rssi; // dBm at the gateway
+};
+
+/*
+ * A frame on the air, with the channel and spreading factor it occupies
+ */
+struct Transmission {
+  uint32_t device;
+  double rssi;
+  bool destroyed;
+};
+
+/*
+ * Start or end of a frame. The queue is ordered on time, the earliest event first
+ */
+struct NetworkEvent {
+  double time;
+  uint32_t device;
+  uint8_t channel;
+  bool end;
+  bool operator>(const NetworkEvent &other) const { return time > other.time; }
+};
+
+/*
+ * Counts the data points the sessions deliver
+ */
+struct NetworkStatistics {
+  uint64_t delivered = 0;
+  uint64_t recovered = 0;
+};
+
+static void countDelivery(void *context, uint32_t /*fcntup*/, uint8_t * /*dataPoint*/, bool received, uint8_t /*phase*/, uint32_t /*delay*/) {
+  NetworkStatistics *statistics = (NetworkStatistics *)context;
+  statistics->delivered++;
+  if (received) {
+    statistics->recovered++;
+  }
+}
+
+/*
+ * Simulate a network of devices around one gateway. Every device sends a data point every period (with 10% jitter),
+ * encoded with DaRe at code rate R, on a random channel, with the lowest spreading factor its path loss allows. Frames
+ * on the same channel and spreading factor that overlap in time collide, the stronger one survives if it is
+ * NETWORK_CAPTURE_DB stronger than every other one. The surviving frames are decoded by a session per device
+ * @param devices - number of devices
+ * @param hours - simulated time
+ * @param period - mean time between the frames of a device, in seconds
+ * @param radius - the devices are spread uniformly over a disc around the gateway, in meters
+ * @param R - code rate, 1 for the data points without coding
+ * @param W - window size
+ * @param seed - random seed of positions, timing and channels
+ */
+void networkSimulation(uint32_t devices, double hours, double period, double radius, int R, DaRe::W_VALUE W, uint32_t seed) {
+  std::mt19937 rng(seed);
+  std::uniform_real_distribution<double> uniform(0.0, 1.0);
+  std::priority_queue<NetworkEvent, std::vector<NetworkEvent>, std::greater<NetworkEvent> > events;
+  std::vector<NetworkDevice> network(devices);
+  std::vector<Transmission> onAir[NETWORK_CHANNELS][NETWORK_SF_MAX - NETWORK_SF_MIN + 1];
+  double duration = hours * 3600, toa[NETWORK_SF_MAX - NETWORK_SF_MIN + 1], airtime = 0, distance, pathLoss;
+  uint32_t deviceI, payloadSize = (R > 1) ? 1 + NETWORK_DATA_POINT_SIZE * R : NETWORK_DATA_POINT_SIZE;
+  uint64_t sent = 0, received = 0, collided = 0, tooWeak = 0;
+  uint8_t dataPoint[NETWORK_DATA_POINT_SIZE], SF;
+  size_t i;
+  NetworkStatistics statistics;
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+  for (SF = NETWORK_SF_MIN; SF <= NETWORK_SF_MAX; SF++) {
+    LoRaAirtime modulation;
+    modulation.init(SF);
+    toa[SF - NETWORK_SF_MIN] = modulation.frameTimeOnAir(payloadSize);
+  }
+  for (deviceI = 0; deviceI < devices; deviceI++) {
+    NetworkDevice &device = network[deviceI];
+    // log-distance path loss for an urban area at 868 MHz
+    distance = std::max(radius * sqrt(uniform(rng)), 10.0);
+    pathLoss = 120.5 + 37.6 * log10(distance / 1000);
+    device.rssi = NETWORK_TX_POWER - pathLoss;
+    for (SF = NETWORK_SF_MIN; SF < NETWORK_SF_MAX && device.rssi < sensitivity[SF - NETWORK_SF_MIN]; SF++) {
+    }
+    device.SF = SF;
+    if (R > 1) {
+      device.encoding.init(&device.payload, NETWORK_DATA_POINT_SIZE, (DaRe::R_VALUE)(R - 2), W);
+      device.encoding.set((DaRe::R_VALUE)(R - 2), W);
+      device.session.init(NETWORK_DATA_POINT_SIZE);
+      device.session.setDeliveryCallback(countDelivery, &statistics);
+    }
+    events.push(NetworkEvent{ uniform(rng) * period, deviceI, 0, false });
+  }
+
+  while (!events.empty()) {
+    NetworkEvent event = events.top();
+    events.pop();
+    NetworkDevice &device = network[event.device];
+    std::vector<Transmission> &channel = onAir[event.channel][device.SF - NETWORK_SF_MIN];
+
+    if (!event.end) {
+      // a new frame: encode it and check it against all frames on the same channel and spreading factor
+      Transmission transmission = { event.device, device.rssi, false };
+      device.fcntup++;
+      if (R > 1) {
+        dataPoint[0] = (uint8_t)device.fcntup;
+        dataPoint[1] = (uint8_t)event.device;
+        device.encoding.encode(&device.payload, dataPoint, device.fcntup);
+      }
+      event.channel = (uint8_t)(rng() % NETWORK_CHANNELS);
+      std::vector<Transmission> &busy = onAir[event.channel][device.SF - NETWORK_SF_MIN];
+      for (i = 0; i < busy.size(); i++) {
+        if (transmission.rssi < busy[i].rssi + NETWORK_CAPTURE_DB) {
+          transmission.destroyed = true;
+        }
+        if (busy[i].rssi < transmission.rssi + NETWORK_CAPTURE_DB) {
+          busy[i].destroyed = true;
+        }
+      }
+      busy.push_back(transmission);
+      sent++;
+      airtime += toa[device.SF - NETWORK_SF_MIN];
+      event.time += toa[device.SF - NETWORK_SF_MIN];
+      event.end = true;
+      events.push(event);
+      continue;
+    }
+
+    // the end of a frame: it is received if nothing destroyed it while it was on the air
+    for (i = 0; channel[i].device != event.device; i++) {
+    }
+    bool destroyed = channel[i].destroyed;
+    channel[i] = channel.back();
+    channel.pop_back();
+    if (destroyed) {
+      collided++;
+    } else if (device.rssi < sensitivity[device.SF - NETWORK_SF_MIN]) {
+      tooWeak++;
+    } else {
+      received++;
+      if (R > 1) {
+        device.session.decode(device.payload, device.fcntup);
+      } else {
+        statistics.delivered++;
+        statistics.recovered++;
+      }
+    }
+
+    // the next frame of the device, if it still starts within the simulated time
+    event.time += period * (0.9 + 0.2 * uniform(rng)) - toa[device.SF - NETWORK_SF_MIN];
+    event.end = false;
+    if (event.time < duration) {
+      events.push(event);
+    }
+  }
+
+  for (deviceI = 0; deviceI < devices; deviceI++) {
+    NetworkDevice &device = network[deviceI];
+    if (R > 1) {
+      device.session.flush();
+      device.encoding.destroy();
+      delete[] device.payload.payload;
+    }
+    device.session.destroy();
+  }
+
+  // the data points of frames after the last received frame of a device are never delivered, so p_rr is relative to all frames sent
+  std::cout << R << "\t" << (int)DaRe::getW(W) << "\t" << AIRTIME_LORAWAN_OVERHEAD + payloadSize << "\t" << sent << "\t"
+    << 100 * airtime / (duration * NETWORK_CHANNELS) << "\t" << (double)100 * collided / sent << "\t" << (double)100 * tooWeak / sent
+    << "\t" << (double)100 * (sent - received) / sent << "\t" << (double)100 * statistics.recovered / sent << "\t"
+    << 1000 * airtime / statistics.recovered << "\t"
+    << std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() << std::endl;
+}
+
+/*
+ * Compare the code rates in the same network, a higher R recovers more but its longer frames collide more often
+ * @param devices, hours, period, radius - see networkSimulation()
+ */
+void networkSweep(uint32_t devices, double hours, double period, double radius) {
+  int R;
+  std::cout << devices << " devices, " << hours << " h, a frame every " << period << " s, within " << radius << " m" << std::endl;
+  std::cout << "R \tW \tPHY \tframes \tairtime \tcollided \ttoo weak \tp_e \tp_rr \tms/dp \ttime [s]" << std::endl;
+  for (R = 1; R <= 5; R++) {
+    networkSimulation(devices, hours, period, radius, R, DaRe::W_16, 1);
+  }
+}
@@ -0,0 +1,27 @@
+/*
+/ _____)             _              | |
+( (____  _____ ____ _| |_ _____  ____| |__
+\____ \| ___ |    (_   _) ___ |/ ___)  _ \
+_____) ) ____| | | || |_| ____( (___| | | |
+(______/|_____)_|_|_| \__)_____)\____)_| |_|
+(C)2017 Semtech
+
+Description: Discrete-event simulation of a LoRaWAN network, with frame losses from collisions at the gateway
+License: Revised BSD License, see LICENSE file included in the project
+By: Paul Marcelis
+*/
+#include "DaRe.h"
+#include "airtime.h"
+
+#ifndef __DARE_NETWORK_H
+#define __DARE_NETWORK_H
+
+#define NETWORK_CHANNELS 8 // uplink channels of the gateway, a frame uses a random one
+#define NETWORK_CAPTURE_DB 6.0 // a frame survives a collision on its channel and spreading factor if it is this much stronger
+#define NETWORK_TX_POWER 14.0 // dBm
+#define NETWORK_DATA_POINT_SIZE 2
+
+void networkSimulation(uint32_t devices, double hours, double period, double radius, int R, DaRe::W_VALUE W, uint32_t seed);
+void networkSweep(uint32_t devices, double hours, double period, double radius);
+
+#endif
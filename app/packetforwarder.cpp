@@ -0,0 +1,365 @@
+/*
+/ _____)             _              | |
+( (____  _____ ____ _| |_ _____  ____| |__
+\____ \| ___ |    (_   _) ___ |/ ___)  _ \
+_____) ) ____| | | || |_| ____( (___| | | |
+(______/|_____)_|_|_| \__)_____)\____)_| |_|
+(C)2017 Semtech
+
+Description: Load generator and ingest front-end speaking the Semtech UDP packet forwarder protocol
+License: Revised BSD License, see LICENSE file included in the project
+By: Paul Marcelis
+*/
+
+#include <iostream>
+#include "packetforwarder.h"
+
+#ifdef _WIN32
+
+void loadGenerator(uint32_t devices, double framesPerSecond, uint32_t seconds, DaRe::R_VALUE R, DaRe::W_VALUE W, int p_e_percent, uint16_t port) {
+  std::cout << "The load generator is only available on POSIX systems" << std::endl;
+}
+
+void ingest(uint16_t port, uint32_t framesPerDevice) {
+  std::cout << "The ingest front-end is only available on POSIX systems" << std::endl;
+}
+
+#else
+
+#include <vector>
+#include <algorithm>
+#include <unordered_map>
+#include <chrono>
+#include <thread>
+#include <random>
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include "utilities.h"
+#include "DaReEncode.h"
+#include "DaReDecode.h"
+
+#define PF_PROTOCOL_VERSION 2
+#define PF_PUSH_DATA 0x00
+#define PF_PUSH_ACK 0x01
+#define PF_PULL_DATA 0x02
+#define PF_PULL_ACK 0x04
+#define PF_HEADER_SIZE 12 // protocol version, token, identifier and gateway EUI
+#define PF_MAX_PACKET 2048
+#define PF_MAX_PHY_PAYLOAD 255
+#define PF_DEVADDR_BASE 0x26010000
+#define PF_FPORT 1
+#define PF_IDLE_SECONDS 3 // the ingest front-end stops after receiving nothing for this long
+
+/*
+ * the gateway timestamp in microseconds. The steady clock is shared by all processes on one machine, so the ingest
+ * front-end can compute the latency from the tmst field
+ */
+static uint32_t getMicroseconds() {
+  return (uint32_t)std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/*
+ * Emulate devices running DaReEncode and send their uplinks as PUSH_DATA packets of one gateway to the local network
+ * server. Frames are sent round robin over the devices at a fixed total rate, lost frames are not sent.
+ * The LoRaWAN frames are not encrypted and carry an empty MIC, no session keys are involved
+ * @param devices - number of emulated devices
+ * @param framesPerSecond - total uplink rate
+ * @param seconds - duration of the run
+ * @param R, W - the coding parameters of all devices
+ * @param p_e_percent - probability that a frame is lost on the channel
+ * @param port - UDP port of the network server on localhost
+ */
+void loadGenerator(uint32_t devices, double framesPerSecond, uint32_t seconds, DaRe::R_VALUE R, DaRe::W_VALUE W, int p_e_percent, uint16_t port) {
+  std::mt19937 rng(1);
+  std::uniform_real_distribution<double> uniform(0.0, 1.0);
+  std::vector<DaReEncode> encoding(devices);
+  std::vector<DaRe::Payload> payloads(devices);
+  std::vector<uint32_t> fcnt(devices, 0);
+  std::vector<uint8_t> dataPoints(devices * PF_DATA_POINT_SIZE, 0);
+  uint8_t packet[PF_MAX_PACKET], phyPayload[PF_MAX_PHY_PAYLOAD], ack[PF_HEADER_SIZE];
+  char data[2 * PF_MAX_PHY_PAYLOAD];
+  uint64_t frame, frames = (uint64_t)(framesPerSecond * seconds);
+  uint32_t device, sent = 0, acks = 0, devAddr, i;
+  uint16_t token;
+  int phySize, length;
+
+  int sock = socket(AF_INET, SOCK_DGRAM, 0);
+  if (sock < 0) {
+    std::cout << "Cannot open socket" << std::endl;
+    return;
+  }
+  struct sockaddr_in server;
+  memset(&server, 0, sizeof(server));
+  server.sin_family = AF_INET;
+  server.sin_port = htons(port);
+  server.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+  for (device = 0; device < devices; device++) {
+    encoding[device].init(&payloads[device], PF_DATA_POINT_SIZE, DaRe::R_1_5, DaRe::W_64);
+    encoding[device].set(R, W);
+  }
+
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  for (frame = 0; frame < frames; frame++) {
+    device = (uint32_t)(frame % devices);
+    fcnt[device]++;
+
+    // a slowly changing sensor value
+    for (i = 0; i < PF_DATA_POINT_SIZE; i++) {
+      dataPoints[device * PF_DATA_POINT_SIZE + i] += (uint8_t)(rng() % 3);
+    }
+    encoding[device].encode(&payloads[device], &dataPoints[device * PF_DATA_POINT_SIZE], fcnt[device]);
+    if (uniform(rng) * 100 < p_e_percent) {
+      continue;
+    }
+
+    std::this_thread::sleep_until(start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(frame / framesPerSecond)));
+
+    // unconfirmed data up: MHDR, DevAddr, FCtrl, FCnt, FPort, FRMPayload, MIC
+    devAddr = PF_DEVADDR_BASE + device;
+    phySize = 0;
+    phyPayload[phySize++] = 0x40;
+    for (i = 0; i < 4; i++) {
+      phyPayload[phySize++] = (uint8_t)(devAddr >> (8 * i));
+    }
+    phyPayload[phySize++] = 0x00;
+    phyPayload[phySize++] = (uint8_t)fcnt[device];
+    phyPayload[phySize++] = (uint8_t)(fcnt[device] >> 8);
+    phyPayload[phySize++] = PF_FPORT;
+    memcpy(&phyPayload[phySize], payloads[device].payload, payloads[device].payloadSize);
+    phySize += payloads[device].payloadSize;
+    memset(&phyPayload[phySize], 0, 4);
+    phySize += 4;
+    base64Encode(phyPayload, phySize, data);
+
+    token = (uint16_t)rng();
+    packet[0] = PF_PROTOCOL_VERSION;
+    packet[1] = (uint8_t)(token >> 8);
+    packet[2] = (uint8_t)token;
+    packet[3] = PF_PUSH_DATA;
+    for (i = 0; i < 8; i++) {
+      packet[4 + i] = (uint8_t)(0xAA + i); // gateway EUI
+    }
+    length = snprintf((char *)&packet[PF_HEADER_SIZE], PF_MAX_PACKET - PF_HEADER_SIZE,
+      "{\"rxpk\":[{\"tmst\":%u,\"chan\":%u,\"rfch\":0,\"freq\":%.6f,\"stat\":1,\"modu\":\"LORA\",\"datr\":\"SF7BW125\","
+      "\"codr\":\"4/5\",\"lsnr\":9.5,\"rssi\":-42,\"size\":%d,\"data\":\"%s\"}]}",
+      getMicroseconds(), device % 8, 867.1 + 0.2 * (device % 8), phySize, data);
+    if (sendto(sock, packet, PF_HEADER_SIZE + length, 0, (struct sockaddr *)&server, sizeof(server)) > 0) {
+      sent++;
+    }
+    while (recv(sock, ack, sizeof(ack), MSG_DONTWAIT) >= 4) {
+      acks++;
+    }
+  }
+  double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  // late acknowledgements
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  while (recv(sock, ack, sizeof(ack), MSG_DONTWAIT) >= 4) {
+    acks++;
+  }
+  close(sock);
+  for (device = 0; device < devices; device++) {
+    encoding[device].destroy();
+  }
+
+  std::cout << "frames \tsent \tframes/s \tacks" << std::endl;
+  std::cout << frames << "\t" << sent << "\t" << sent / elapsed << "\t" << acks << std::endl;
+}
+
+/*
+ * The state of one device at the ingest front-end
+ */
+struct IngestSession {
+  DaReDecode decoder;
+  uint32_t fcntup = 0; // highest frame counter so far, the 16 bit FCnt of the frames is extended with it
+  uint32_t readings = 0; // highest reading counter so far, see DaReDecode::decode()
+};
+
+/*
+ * find the value of a key within one JSON object, without a full parser: the rxpk objects are flat
+ * @return the first character of the value, or NULL if the key is not in the object
+ */
+static const char *findJsonValue(const char *object, const char *objectEnd, const char *key) {
+  size_t keyLength = strlen(key);
+  const char *p;
+  for (p = object; p + keyLength + 3 <= objectEnd; p++) {
+    if (p[0] == '"' && strncmp(p + 1, key, keyLength) == 0 && p[keyLength + 1] == '"' && p[keyLength + 2] == ':') {
+      return p + keyLength + 3;
+    }
+  }
+  return NULL;
+}
+
+/*
+ * Network server front-end: receive PUSH_DATA packets, acknowledge them, extract the LoRaWAN frames and decode them
+ * with one DaReDecode session per DevAddr. Stops when nothing is received for PF_IDLE_SECONDS and reports the sustained
+ * frame rate, the latency from the gateway timestamp to the decoded frame, and the CPU time per frame
+ * @param port - UDP port to listen on
+ * @param framesPerDevice - the capacity of every decoding session in frames, of up to PF_MAX_K readings each
+ */
+void ingest(uint16_t port, uint32_t framesPerDevice) {
+  std::unordered_map<uint32_t, IngestSession *> sessions;
+  std::unordered_map<uint32_t, IngestSession *>::iterator it;
+  std::vector<uint32_t> latencies;
+  uint8_t packet[PF_MAX_PACKET + 1], phyPayload[PF_MAX_PHY_PAYLOAD], ack[4];
+  uint32_t packets = 0, frames = 0, invalid = 0, overflow = 0, devAddr, fcntup, tmst;
+  struct rusage usageStart, usageEnd;
+  std::chrono::steady_clock::time_point firstPacket, lastPacket;
+  DaRe::Payload payload;
+  int sock, received, phySize, fOptsLength, headerSize;
+
+  sock = socket(AF_INET, SOCK_DGRAM, 0);
+  struct sockaddr_in address;
+  memset(&address, 0, sizeof(address));
+  address.sin_family = AF_INET;
+  address.sin_port = htons(port);
+  address.sin_addr.s_addr = htonl(INADDR_ANY);
+  if (sock < 0 || bind(sock, (struct sockaddr *)&address, sizeof(address)) != 0) {
+    std::cout << "Cannot listen on port " << port << std::endl;
+    if (sock >= 0) {
+      close(sock);
+    }
+    return;
+  }
+  struct timeval timeout = { 1, 0 };
+  int receiveBuffer = 8 * 1024 * 1024;
+  setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+  setsockopt(sock, SOL_SOCKET, SO_RCVBUF, &receiveBuffer, sizeof(receiveBuffer));
+  std::cout << "Listening on port " << port << std::endl;
+
+  while (true) {
+    struct sockaddr_in gateway;
+    socklen_t gatewaySize = sizeof(gateway);
+    received = (int)recvfrom(sock, packet, PF_MAX_PACKET, 0, (struct sockaddr *)&gateway, &gatewaySize);
+    if (received < 0) {
+      if (packets > 0 && std::chrono::steady_clock::now() - lastPacket > std::chrono::seconds(PF_IDLE_SECONDS)) {
+        break;
+      }
+      continue;
+    }
+    if (received < 4 || packet[0] != PF_PROTOCOL_VERSION || (packet[3] != PF_PUSH_DATA && packet[3] != PF_PULL_DATA)) {
+      continue;
+    }
+    ack[0] = PF_PROTOCOL_VERSION;
+    ack[1] = packet[1];
+    ack[2] = packet[2];
+    ack[3] = (packet[3] == PF_PUSH_DATA) ? PF_PUSH_ACK : PF_PULL_ACK;
+    sendto(sock, ack, 4, 0, (struct sockaddr *)&gateway, gatewaySize);
+    if (packet[3] != PF_PUSH_DATA || received <= PF_HEADER_SIZE) {
+      continue;
+    }
+
+    if (packets == 0) {
+      firstPacket = std::chrono::steady_clock::now();
+      getrusage(RUSAGE_SELF, &usageStart);
+    }
+    packets++;
+    packet[received] = '\0';
+
+    // every object in the rxpk array is one received frame
+    const char *json = (const char *)&packet[PF_HEADER_SIZE];
+    const char *object = strstr(json, "\"rxpk\"");
+    const char *objectEnd, *value;
+    while (object != NULL && (object = strchr(object, '{')) != NULL && (objectEnd = strchr(object, '}')) != NULL) {
+      value = findJsonValue(object, objectEnd, "data");
+      if (value == NULL || *value != '"') {
+        invalid++;
+        object = objectEnd;
+        continue;
+      }
+      const char *dataEnd = strchr(value + 1, '"');
+      phySize = (dataEnd == NULL || dataEnd - value - 1 > 4 * PF_MAX_PHY_PAYLOAD / 3) ? -1 : base64Decode(value + 1, (int)(dataEnd - value - 1), phyPayload);
+      value = findJsonValue(object, objectEnd, "tmst");
+      tmst = (value != NULL) ? (uint32_t)strtoul(value, NULL, 10) : getMicroseconds();
+
+      // data up frames only, with a FPort and a DaRe payload as long as its header announces, a shorter payload would
+      // make the decoder read parity checks from the bytes of an earlier packet. More than PF_MAX_K readings would not
+      // fit in the decoder
+      fOptsLength = (phySize > 5) ? (phyPayload[5] & 0x0f) : 0;
+      headerSize = 8 + fOptsLength + 1;
+      if (phySize < headerSize + 4 + 1 || ((phyPayload[0] & 0xe0) != 0x40 && (phyPayload[0] & 0xe0) != 0x80)
+        || !DaRe::isPayloadComplete(&phyPayload[headerSize], phySize - headerSize - 4, PF_DATA_POINT_SIZE)
+        || DaRe::getK(&phyPayload[headerSize]) > PF_MAX_K) {
+        invalid++;
+        object = objectEnd;
+        continue;
+      }
+      devAddr = phyPayload[1] | (phyPayload[2] << 8) | (phyPayload[3] << 16) | ((uint32_t)phyPayload[4] << 24);
+      it = sessions.find(devAddr);
+      if (it == sessions.end()) {
+        it = sessions.insert(std::make_pair(devAddr, new IngestSession())).first;
+        it->second->decoder.init(PF_DATA_POINT_SIZE, framesPerDevice * PF_MAX_K);
+      }
+      IngestSession *session = it->second;
+
+      // extend the 16 bit FCnt to the 32 bit frame counter, assuming less than 2^15 frames are missed
+      fcntup = (session->fcntup & 0xffff0000) | (phyPayload[6] | (phyPayload[7] << 8));
+      if (fcntup + 0x8000 < session->fcntup) {
+        fcntup += 0x10000;
+      }
+      // the readings of the frame, up to fcntup * k, fit in the decoder as k is at most PF_MAX_K
+      if (fcntup == 0 || fcntup > framesPerDevice) {
+        overflow++;
+        object = objectEnd;
+        continue;
+      }
+      session->fcntup = std::max(session->fcntup, fcntup);
+      session->readings = std::max(session->readings, fcntup * DaRe::getK(&phyPayload[headerSize]));
+
+      payload.payload = &phyPayload[headerSize];
+      payload.payloadSize = (uint8_t)(phySize - headerSize - 4);
+      session->decoder.decode(payload, fcntup);
+      latencies.push_back(getMicroseconds() - tmst);
+      frames++;
+      object = objectEnd;
+    }
+    lastPacket = std::chrono::steady_clock::now();
+  }
+  close(sock);
+
+  uint64_t dataPoints = 0, recovered = 0;
+  for (it = sessions.begin(); it != sessions.end(); ++it) {
+    it->second->decoder.flushBuffers();
+    for (fcntup = 1; fcntup <= it->second->readings; fcntup++) {
+      recovered += it->second->decoder.isReceived(fcntup) ? 1 : 0;
+    }
+    dataPoints += it->second->readings;
+  }
+  getrusage(RUSAGE_SELF, &usageEnd);
+  for (it = sessions.begin(); it != sessions.end(); ++it) {
+    it->second->decoder.destroy();
+    delete it->second;
+  }
+  if (frames == 0) {
+    std::cout << "No frames received" << std::endl;
+    return;
+  }
+
+  double seconds = std::chrono::duration<double>(lastPacket - firstPacket).count();
+  double cpu = (usageEnd.ru_utime.tv_sec - usageStart.ru_utime.tv_sec) + (usageEnd.ru_stime.tv_sec - usageStart.ru_stime.tv_sec)
+    + 1e-6 * ((usageEnd.ru_utime.tv_usec - usageStart.ru_utime.tv_usec) + (usageEnd.ru_stime.tv_usec - usageStart.ru_stime.tv_usec));
+  std::sort(latencies.begin(), latencies.end());
+  size_t n = latencies.size();
+  std::cout << "devices \tframes \tinvalid \toverflow \tframes/s \tp50 \tp99 \tp99.9 \tmax [us] \tcpu/frame [us] \tp_rr" << std::endl;
+  std::cout << sessions.size()
+    << "\t" << frames
+    << "\t" << invalid
+    << "\t" << overflow
+    << "\t" << ((seconds > 0) ? frames / seconds : 0)
+    << "\t" << latencies[n / 2]
+    << "\t" << latencies[(size_t)(n * 0.99)]
+    << "\t" << latencies[(size_t)(n * 0.999)]
+    << "\t" << latencies[n - 1]
+    << "\t" << 1e6 * cpu / frames
+    << "\t" << (double)100 * recovered / dataPoints << std::endl;
+}
+
+#endif
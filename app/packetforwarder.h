@@ -0,0 +1,25 @@
+/*
+/ _____)             _              | |
+( (____  _____ ____ _| |_ _____  ____| |__
+\____ \| ___ |    (_   _) ___ |/ ___)  _ \
+_____) ) ____| | | || |_| ____( (___| | | |
+(______/|_____)_|_|_| \__)_____)\____)_| |_|
+(C)2017 Semtech
+
+Description: Load generator and ingest front-end speaking the Semtech UDP packet forwarder protocol
+License: Revised BSD License, see LICENSE file included in the project
+By: Paul Marcelis
+*/
+#include "DaRe.h"
+
+#ifndef __DARE_PACKET_FORWARDER_H
+#define __DARE_PACKET_FORWARDER_H
+
+#define PF_DEFAULT_PORT 1700 // default port of the network server for the packet forwarder
+#define PF_DATA_POINT_SIZE 2
+#define PF_MAX_K 4 // readings per frame the ingest front-end accepts, its decoders are sized for this many per frame
+
+void loadGenerator(uint32_t devices, double framesPerSecond, uint32_t seconds, DaRe::R_VALUE R, DaRe::W_VALUE W, int p_e_percent, uint16_t port);
+void ingest(uint16_t port, uint32_t framesPerDevice);
+
+#endif
@@ -0,0 +1,243 @@
+/*
+/ _____)             _              | |
+( (____  _____ ____ _| |_ _____  ____| |__
+\____ \| ___ |    (_   _) ___ |/ ___)  _ \
+_____) ) ____| | | || |_| ____( (___| | | |
+(______/|_____)_|_|_| \__)_____)\____)_| |_|
+(C)2017 Semtech
+
+Description: Importance sampling estimation of the residual loss rate at low frame loss rates
+License: Revised BSD License, see LICENSE file included in the project
+By: Paul Marcelis
+*/
+
+#include <iostream>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <cmath>
+#include <algorithm>
+#include "rareevent.h"
+#include "DaReEncode.h"
+#include "DaReDecode.h"
+
+#define RARE_EVENT_DATA_POINT_SIZE 2
+#define RARE_EVENT_BURN_IN 2 // windows of frames before the target data points
+#define RARE_EVENT_LOOK_AHEAD 4 // windows of frames after the target data points, shorter ones underestimate what elimination recovers
+#define RARE_EVENT_PILOT 0.2 // share of the episodes spread evenly over the strata, the rest goes where the variance is
+#define RARE_EVENT_PROBE 2 // strata below the lowest stratum with unrecovered data points that keep being sampled
+#define RARE_EVENT_ROUNDS 8 // allocation rounds after the pilot
+
+/*
+ * An episode is a fresh decoder receiving a burn-in of RARE_EVENT_BURN_IN windows, W target frames and a look-ahead of
+ * RARE_EVENT_LOOK_AHEAD windows. The result of an episode is the fraction of the target data points that is not
+ * recovered. The frames of the target and of the first window after it, the frames with parity checks over the target
+ * data points, form the critical region.
+ */
+class RareEventEpisodes {
+  uint32_t window, length, frameSize;
+  std::vector<uint8_t> frames;
+  std::vector<bool> lost;
+  std::mt19937 rng;
+  std::uniform_real_distribution<double> uniform;
+
+public:
+  uint32_t criticalStart, criticalLength;
+
+  RareEventEpisodes(DaRe::R_VALUE R, DaRe::W_VALUE W, uint32_t seed) : rng(seed), uniform(0.0, 1.0) {
+    uint8_t dataPoint[RARE_EVENT_DATA_POINT_SIZE];
+    uint32_t fcntup;
+    window = DaRe::getW(W);
+    length = (RARE_EVENT_BURN_IN + 1 + RARE_EVENT_LOOK_AHEAD) * window;
+    frameSize = 1 + RARE_EVENT_DATA_POINT_SIZE * DaRe::getR(R);
+    criticalStart = RARE_EVENT_BURN_IN * window; // index of the first frame
+    criticalLength = 2 * window;
+    lost.resize(length);
+
+    // the values of the data points do not change whether they are recovered, so all episodes send the same frames
+    DaRe::Payload payload;
+    DaReEncode encoding;
+    encoding.init(&payload, RARE_EVENT_DATA_POINT_SIZE, DaRe::R_1_5, DaRe::W_64);
+    encoding.set(R, W);
+    frames.resize(length * frameSize);
+    for (fcntup = 1; fcntup <= length; fcntup++) {
+      dataPoint[0] = (uint8_t)rng();
+      dataPoint[1] = (uint8_t)rng();
+      encoding.encode(&payload, dataPoint, fcntup);
+      std::copy(payload.payload, payload.payload + frameSize, frames.begin() + (fcntup - 1) * frameSize);
+    }
+    encoding.destroy();
+  }
+
+  /*
+   * run an episode. Outside the critical region frames are lost with probability p, inside the critical region either
+   * also with probability p (k < 0) or exactly k frames at uniformly drawn positions
+   */
+  double run(double p, int k) {
+    uint8_t payloadCopy[1 + 2 * RARE_EVENT_DATA_POINT_SIZE * 5];
+    uint32_t fcntup, i, j, unrecovered = 0;
+    DaRe::Payload payload;
+    DaReDecode decoding;
+
+    for (i = 0; i < length; i++) {
+      lost[i] = (k < 0 || i < criticalStart || i >= criticalStart + criticalLength) && uniform(rng) < p;
+    }
+    if (k >= 0) {
+      std::vector<uint32_t> positions(criticalLength);
+      for (i = 0; i < criticalLength; i++) {
+        positions[i] = criticalStart + i;
+      }
+      for (i = 0; i < (uint32_t)k; i++) {
+        j = i + rng() % (criticalLength - i);
+        std::swap(positions[i], positions[j]);
+        lost[positions[i]] = true;
+      }
+    }
+
+    decoding.init(RARE_EVENT_DATA_POINT_SIZE, length);
+    for (fcntup = 1; fcntup <= length; fcntup++) {
+      if (!lost[fcntup - 1]) {
+        std::copy(frames.begin() + (fcntup - 1) * frameSize, frames.begin() + fcntup * frameSize, payloadCopy);
+        payload.payload = payloadCopy;
+        payload.payloadSize = (uint8_t)frameSize;
+        decoding.decode(payload, fcntup);
+      }
+    }
+    decoding.flushBuffers();
+    for (fcntup = criticalStart + 1; fcntup <= criticalStart + window; fcntup++) {
+      unrecovered += decoding.isReceived(fcntup) ? 0 : 1;
+    }
+    decoding.destroy();
+    return (double)unrecovered / window;
+  }
+};
+
+/*
+ * print one estimate of the residual loss rate with its 95% confidence interval
+ */
+static void displayEstimate(const char *method, double p_e_percent, uint32_t episodes, uint32_t hits, double mean, double variance, int lowestStratum, double seconds) {
+  double halfWidth = 1.96 * sqrt(variance);
+  std::cout << method << "\t" << p_e_percent << "\t" << episodes << "\t\t" << hits << "\t" << mean << "\t" << halfWidth
+    << "\t" << ((mean > 0) ? halfWidth / mean : 0) << "\t\t";
+  if (lowestStratum >= 0) {
+    std::cout << lowestStratum;
+  } else {
+    std::cout << "-";
+  }
+  std::cout << "\t" << seconds << std::endl;
+}
+
+/*
+ * the lowest number of losses in the critical region for which unrecovered data points were seen, -1 if none
+ */
+static int getLowestStratum(std::vector<double> &strataSum) {
+  size_t k;
+  for (k = 0; k < strataSum.size(); k++) {
+    if (strataSum[k] > 0) {
+      return (int)k;
+    }
+  }
+  return -1;
+}
+
+/*
+ * Estimate the residual loss rate 1 - p_rr at a low frame loss rate, with plain Monte Carlo and with importance
+ * sampling, both with the same number of episodes.
+ * The importance sampling draws the number of lost frames k in the critical region per stratum instead of from its
+ * binomial distribution, so episodes with many losses, which cause the unrecovered data points, are sampled far more
+ * often than they occur. Every stratum is weighted with its likelihood, the binomial probability of k losses at p_e,
+ * which keeps the estimate unbiased. A pilot spreads RARE_EVENT_PILOT of the episodes evenly over the strata, the rest
+ * is allocated in rounds, in proportion to the weighted standard deviation of each stratum (Neyman allocation).
+ * Strata far below the lowest number of losses that left data points unrecovered get no episodes after the pilot, their
+ * contribution is taken as zero. The lowest such number of losses is printed, a stratum without any unrecovered data
+ * point can only be ruled out up to the number of episodes spent on it
+ * @param R, W - the coding parameters
+ * @param p_e_percent - the frame loss probability
+ * @param episodes - number of episodes per estimate, at least two per stratum of the critical region
+ * @param seed - random seed
+ */
+void rareEventSimulation(DaRe::R_VALUE R, DaRe::W_VALUE W, double p_e_percent, uint32_t episodes, uint32_t seed) {
+  RareEventEpisodes simulation(R, W, seed);
+  double p = p_e_percent / 100, value, sum = 0, squares = 0, mean, variance;
+  uint32_t episode, hits = 0, n = simulation.criticalLength, k;
+
+  // the pilot of the importance sampling takes at least two episodes per stratum, both estimates need two for a variance
+  if (episodes < 2 * (n + 1)) {
+    std::cout << "At least " << 2 * (n + 1) << " episodes are needed for " << n << " frames in the critical region, using " << 2 * (n + 1) << std::endl;
+    episodes = 2 * (n + 1);
+  }
+  std::cout << "method \t\tp_e \tepisodes \thits \t1-p_rr \t\t+- \t\trelative error \tlowest k \ttime [s]" << std::endl;
+
+  // plain Monte Carlo
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  for (episode = 0; episode < episodes; episode++) {
+    value = simulation.run(p, -1);
+    hits += (value > 0) ? 1 : 0;
+    sum += value;
+    squares += value * value;
+  }
+  mean = sum / episodes;
+  variance = (squares / episodes - mean * mean) / (episodes - 1);
+  displayEstimate("monte carlo", p_e_percent, episodes, hits, mean, variance, -1,
+    std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+
+  // importance sampling, stratified on the number of losses in the critical region
+  start = std::chrono::steady_clock::now();
+  std::vector<double> weight(n + 1), strataSum(n + 1, 0), strataSquares(n + 1, 0), deviation(n + 1);
+  std::vector<uint32_t> strataEpisodes(n + 1, 0);
+  uint32_t pilot = std::max((uint32_t)2, (uint32_t)(episodes * RARE_EVENT_PILOT / (n + 1))), used = 0, extra, budget, round;
+  double deviationSum = 0, referenceDeviation;
+  int lowestStratum;
+  hits = 0;
+  for (k = 0; k <= n; k++) {
+    weight[k] = exp(lgamma(n + 1.0) - lgamma(k + 1.0) - lgamma(n - k + 1.0) + k * log(p) + (n - k) * log(1 - p));
+  }
+  for (k = 0; k <= n; k++) {
+    for (episode = 0; episode < pilot; episode++) {
+      value = simulation.run(p, k);
+      hits += (value > 0) ? 1 : 0;
+      strataSum[k] += value;
+      strataSquares[k] += value * value;
+    }
+    strataEpisodes[k] = pilot;
+    used += pilot;
+  }
+  // the other episodes in rounds, so the sampling can follow the lowest stratum with unrecovered data points downwards
+  for (round = 0; round < RARE_EVENT_ROUNDS; round++) {
+    budget = (episodes - used) / (RARE_EVENT_ROUNDS - round);
+    lowestStratum = getLowestStratum(strataSum);
+    if (lowestStratum < 0) {
+      break;
+    }
+    deviationSum = 0;
+    for (k = 0; k <= n; k++) {
+      deviation[k] = sqrt(strataSquares[k] / strataEpisodes[k] - (strataSum[k] / strataEpisodes[k]) * (strataSum[k] / strataEpisodes[k]));
+    }
+    referenceDeviation = deviation[lowestStratum];
+    for (k = 0; k <= n; k++) {
+      // the strata just below the lowest stratum with unrecovered data points are assumed to vary like it
+      deviation[k] = ((int)k >= lowestStratum - RARE_EVENT_PROBE) ? weight[k] * std::max(deviation[k], referenceDeviation) : 0;
+      deviationSum += deviation[k];
+    }
+    for (k = 0; k <= n; k++) {
+      extra = (uint32_t)(budget * deviation[k] / deviationSum);
+      for (episode = 0; episode < extra; episode++) {
+        value = simulation.run(p, k);
+        hits += (value > 0) ? 1 : 0;
+        strataSum[k] += value;
+        strataSquares[k] += value * value;
+      }
+      strataEpisodes[k] += extra;
+      used += extra;
+    }
+  }
+  mean = 0;
+  variance = 0;
+  for (k = 0; k <= n; k++) {
+    double strataMean = strataSum[k] / strataEpisodes[k];
+    mean += weight[k] * strataMean;
+    variance += weight[k] * weight[k] * (strataSquares[k] / strataEpisodes[k] - strataMean * strataMean) / (strataEpisodes[k] - 1);
+  }
+  displayEstimate("importance", p_e_percent, used, hits, mean, variance, getLowestStratum(strataSum),
+    std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+}
@@ -0,0 +1,20 @@
+/*
+/ _____)             _              | |
+( (____  _____ ____ _| |_ _____  ____| |__
+\____ \| ___ |    (_   _) ___ |/ ___)  _ \
+_____) ) ____| | | || |_| ____( (___| | | |
+(______/|_____)_|_|_| \__)_____)\____)_| |_|
+(C)2017 Semtech
+
+Description: Importance sampling estimation of the residual loss rate at low frame loss rates
+License: Revised BSD License, see LICENSE file included in the project
+By: Paul Marcelis
+*/
+#include "DaRe.h"
+
+#ifndef __DARE_RARE_EVENT_H
+#define __DARE_RARE_EVENT_H
+
+void rareEventSimulation(DaRe::R_VALUE R, DaRe::W_VALUE W, double p_e_percent, uint32_t episodes, uint32_t seed);
+
+#endif
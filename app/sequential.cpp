@@ -0,0 +1,167 @@
+/*
+/ _____)             _              | |
+( (____  _____ ____ _| |_ _____  ____| |__
+\____ \| ___ |    (_   _) ___ |/ ___)  _ \
+_____) ) ____| | | || |_| ____( (___| | | |
+(______/|_____)_|_|_| \__)_____)\____)_| |_|
+(C)2017 Semtech
+
+Description: Simulation that stops as soon as the results reach a given precision
+License: Revised BSD License, see LICENSE file included in the project
+By: Paul Marcelis
+*/
+
+#include <iostream>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <cmath>
+#include <algorithm>
+#include "sequential.h"
+#include "DaReEncode.h"
+#include "DaReDecode.h"
+
+/*
+ * Batch means of the delivered data points. Neighbouring data points are decoded from the same parity checks, so
+ * single data points are not independent samples; batches of SEQUENTIAL_CHUNK data points are
+ */
+struct BatchStatistics {
+  uint32_t delivered = 0;
+  uint32_t recovered = 0;
+  double delaySum = 0;
+  std::vector<double> prr; // p_rr per batch in percent
+  std::vector<double> delay; // mean delay of the recovered data points per batch
+};
+
+static void collectDelivery(void *context, uint32_t /*fcntup*/, uint8_t * /*dataPoint*/, bool received, uint8_t /*phase*/, uint32_t delay) {
+  BatchStatistics *statistics = (BatchStatistics *)context;
+  statistics->delivered++;
+  if (received) {
+    statistics->recovered++;
+    statistics->delaySum += delay;
+  }
+  if (statistics->delivered == SEQUENTIAL_CHUNK) {
+    statistics->prr.push_back((double)100 * statistics->recovered / SEQUENTIAL_CHUNK);
+    statistics->delay.push_back((statistics->recovered > 0) ? statistics->delaySum / statistics->recovered : 0);
+    statistics->delivered = 0;
+    statistics->recovered = 0;
+    statistics->delaySum = 0;
+  }
+}
+
+/*
+ * 97.5% quantile of Student's t distribution, for a two-sided 95% confidence interval
+ */
+static double tQuantile(size_t degreesOfFreedom) {
+  static const double quantiles[] = { 12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+    2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086, 2.080, 2.074, 2.069, 2.064, 2.060,
+    2.056, 2.052, 2.048, 2.045, 2.042 };
+  return (degreesOfFreedom <= 30) ? quantiles[degreesOfFreedom - 1] : 1.96;
+}
+
+/*
+ * mean and half width of the 95% confidence interval of the mean of a number of batch means
+ */
+static double confidenceHalfWidth(std::vector<double> &samples, double *mean) {
+  double sum = 0, squares = 0;
+  size_t i, n = samples.size();
+  for (i = 0; i < n; i++) {
+    sum += samples[i];
+  }
+  *mean = sum / n;
+  for (i = 0; i < n; i++) {
+    squares += (samples[i] - *mean) * (samples[i] - *mean);
+  }
+  return tQuantile(n - 1) * sqrt(squares / (n - 1) / n);
+}
+
+/*
+ * Simulate in batches of SEQUENTIAL_CHUNK frames until the 95% confidence intervals of p_rr and of the mean delay are
+ * within the given precision, or maxFrames frames are sent. Only completely delivered batches are counted
+ * @param R, W, F, S - the coding parameters
+ * @param p_e_percent - probability that a frame is lost
+ * @param precisionPrr - target half width of the confidence interval of p_rr, in percentage points
+ * @param precisionDelay - target half width of the confidence interval of the mean delay, in frames
+ * @param maxFrames - frame cap
+ * @param seed - random seed of the data points and the losses
+ * @return the number of frames sent
+ */
+uint32_t sequentialSimulation(DaRe::R_VALUE R, DaRe::W_VALUE W, int p_e_percent, DaRe::F_VALUE F, DaRe::S_VALUE S,
+  double precisionPrr, double precisionDelay, uint32_t maxFrames, uint32_t seed) {
+  std::mt19937 rng(seed);
+  std::uniform_real_distribution<double> uniform(0.0, 1.0);
+  uint8_t dataPoint[2];
+  uint32_t fcntup = 0;
+  double prr = 0, delay = 0, prrHalfWidth = 0, delayHalfWidth = 0;
+  DaRe::Payload payload;
+  DaReEncode encoding;
+  DaReDecode decoding;
+  BatchStatistics statistics;
+
+  encoding.init(&payload, sizeof(dataPoint), DaRe::R_1_5, DaRe::W_64);
+  encoding.set(R, W);
+  encoding.setF(F);
+  encoding.setStrategy(S);
+  decoding.init(sizeof(dataPoint), maxFrames);
+  decoding.setStrategy(S);
+  decoding.setDeliveryCallback(collectDelivery, &statistics);
+
+  while (fcntup + SEQUENTIAL_CHUNK <= maxFrames) {
+    uint32_t last = fcntup + SEQUENTIAL_CHUNK;
+    for (fcntup++; fcntup <= last; fcntup++) {
+      dataPoint[0] = (uint8_t)rng();
+      dataPoint[1] = (uint8_t)rng();
+      encoding.encode(&payload, dataPoint, fcntup);
+      if (uniform(rng) * 100 >= p_e_percent) {
+        decoding.decode(payload, fcntup);
+      }
+    }
+    fcntup = last;
+
+    if (statistics.prr.size() >= SEQUENTIAL_MIN_CHUNKS) {
+      // when no data point is lost at all the batch variance is zero, the rule of three still bounds the loss rate
+      prrHalfWidth = std::max(confidenceHalfWidth(statistics.prr, &prr), (double)300 / (statistics.prr.size() * SEQUENTIAL_CHUNK));
+      delayHalfWidth = confidenceHalfWidth(statistics.delay, &delay);
+      if (prrHalfWidth <= precisionPrr && delayHalfWidth <= precisionDelay) {
+        break;
+      }
+    }
+  }
+  if (statistics.prr.size() > 1) {
+    prrHalfWidth = std::max(confidenceHalfWidth(statistics.prr, &prr), (double)300 / (statistics.prr.size() * SEQUENTIAL_CHUNK));
+    delayHalfWidth = confidenceHalfWidth(statistics.delay, &delay);
+  }
+
+  std::cout << (int)DaRe::getR(R) << "\t" << (int)DaRe::getW(W) << "\t" << ((F == DaRe::F_GF256) ? 256 : 2) << "\t"
+    << ((S == DaRe::S_REPETITION) ? RepetitionStrategy::name() : DaReStrategy::name()) << "\t" << p_e_percent
+    << "\t" << prr << "\t" << prrHalfWidth << "\t" << delay << "\t" << delayHalfWidth << "\t" << fcntup << std::endl;
+
+  encoding.destroy();
+  decoding.destroy();
+  return fcntup;
+}
+
+/*
+ * Sweep over R, W and p_e with early stopping, and compare the number of frames with fixed length simulations
+ */
+void sequentialSweep(double precisionPrr, double precisionDelay, uint32_t maxFrames) {
+  DaRe::R_VALUE Rs[] = { DaRe::R_1_2, DaRe::R_1_3 };
+  DaRe::W_VALUE Ws[] = { DaRe::W_4, DaRe::W_8, DaRe::W_16, DaRe::W_32 };
+  int p_es[] = { 10, 30, 50 };
+  int R_i, W_i, p_e_i, runs = 0;
+  uint64_t frames = 0;
+
+  std::cout << "R \tW \tF \tS \tp_e \tp_rr \t+- \tavg_delay \t+- \tframes" << std::endl;
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  for (R_i = 0; R_i < 2; R_i++) {
+    for (W_i = 0; W_i < 4; W_i++) {
+      for (p_e_i = 0; p_e_i < 3; p_e_i++) {
+        frames += sequentialSimulation(Rs[R_i], Ws[W_i], p_es[p_e_i], DaRe::F_GF2, DaRe::S_DARE, precisionPrr, precisionDelay, maxFrames, 1 + runs);
+        runs++;
+      }
+    }
+  }
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  std::cout << frames << " frames in " << seconds << " s, " << (double)runs * maxFrames / frames << " times fewer than "
+    << runs << " runs of " << maxFrames << " frames" << std::endl;
+}
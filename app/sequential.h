@@ -0,0 +1,25 @@
+/*
+/ _____)             _              | |
+( (____  _____ ____ _| |_ _____  ____| |__
+\____ \| ___ |    (_   _) ___ |/ ___)  _ \
+_____) ) ____| | | || |_| ____( (___| | | |
+(______/|_____)_|_|_| \__)_____)\____)_| |_|
+(C)2017 Semtech
+
+Description: Simulation that stops as soon as the results reach a given precision
+License: Revised BSD License, see LICENSE file included in the project
+By: Paul Marcelis
+*/
+#include "DaRe.h"
+
+#ifndef __DARE_SEQUENTIAL_H
+#define __DARE_SEQUENTIAL_H
+
+#define SEQUENTIAL_CHUNK 2000 // data points per batch, the batch means are close to independent for W <= 64
+#define SEQUENTIAL_MIN_CHUNKS 10 // minimal number of batches before the confidence intervals are trusted
+
+uint32_t sequentialSimulation(DaRe::R_VALUE R, DaRe::W_VALUE W, int p_e_percent, DaRe::F_VALUE F, DaRe::S_VALUE S,
+  double precisionPrr, double precisionDelay, uint32_t maxFrames, uint32_t seed);
+void sequentialSweep(double precisionPrr, double precisionDelay, uint32_t maxFrames);
+
+#endif
@@ -0,0 +1,192 @@
+/*
+/ _____)             _              | |
+( (____  _____ ____ _| |_ _____  ____| |__
+\____ \| ___ |    (_   _) ___ |/ ___)  _ \
+_____) ) ____| | | || |_| ____( (___| | | |
+(______/|_____)_|_|_| \__)_____)\____)_| |_|
+(C)2017 Semtech
+
+Description: Search for the degree of the parity checks per window size, as a degree table
+License: Revised BSD License, see LICENSE file included in the project
+By: Paul Marcelis
+*/
+
+#include <iostream>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+#include "tuner.h"
+#include "DaReEncode.h"
+#include "DaReDecode.h"
+
+/*
+ * One point of the search, a degree for a window size, and its simulated performance
+ */
+struct TunerCandidate {
+  DaRe::W_VALUE W;
+  uint8_t D;
+  double prr = 0; // percent, averaged over the frame loss rates
+  double delay = 0; // mean delay of the recovered data points, in frames
+  double nsPerFrame = 0; // decode time per received frame
+  double objective = 0;
+};
+
+/*
+ * Simulate the candidate at a number of frame loss rates. The candidate degree is put in the degree table of the
+ * calling thread, and signalled to the decoder through the extension byte like a deployed table would be
+ * @param candidate - the window size and degree, the results are filled in
+ * @param table - the degree table this thread may overwrite
+ * @param R - code rate
+ */
+static void evaluate(TunerCandidate &candidate, uint8_t table, DaRe::R_VALUE R) {
+  static const int p_es[] = { 10, 30, 50 };
+  uint8_t degrees[DaRe::W_64 + 1], dataPoint[2];
+  uint32_t fcntup, recovered, decoded;
+  double delaySum, decodeNs;
+  size_t p_e_i;
+  int W_i;
+
+  for (W_i = DaRe::W_0; W_i <= DaRe::W_64; W_i++) {
+    degrees[W_i] = DaRe::getDegree(0, (DaRe::W_VALUE)W_i);
+  }
+  degrees[candidate.W] = candidate.D;
+  DaRe::setDegreeTable(table, degrees);
+
+  for (p_e_i = 0; p_e_i < sizeof(p_es) / sizeof(p_es[0]); p_e_i++) {
+    std::mt19937 rng(p_es[p_e_i]); // every candidate sees the same data points and losses
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+    DaRe::Payload payload;
+    DaReEncode encoding;
+    DaReDecode decoding;
+
+    encoding.init(&payload, sizeof(dataPoint), DaRe::R_1_5, DaRe::W_64);
+    encoding.set(R, candidate.W);
+    encoding.setDegreeTable(table);
+    decoding.init(sizeof(dataPoint), TUNER_FRAMES);
+    decoded = 0;
+    decodeNs = 0;
+    for (fcntup = 1; fcntup <= TUNER_FRAMES; fcntup++) {
+      dataPoint[0] = (uint8_t)rng();
+      dataPoint[1] = (uint8_t)rng();
+      encoding.encode(&payload, dataPoint, fcntup);
+      if (uniform(rng) * 100 >= p_es[p_e_i]) {
+        auto start = std::chrono::steady_clock::now();
+        decoding.decode(payload, fcntup);
+        decodeNs += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        decoded++;
+      }
+    }
+
+    recovered = 0;
+    delaySum = 0;
+    for (fcntup = 1; fcntup <= TUNER_FRAMES; fcntup++) {
+      if (decoding.isReceived(fcntup)) {
+        recovered++;
+        delaySum += decoding.getDelay(fcntup);
+      }
+    }
+    candidate.prr += (double)100 * recovered / TUNER_FRAMES;
+    candidate.delay += (recovered > 0) ? delaySum / recovered : 0;
+    candidate.nsPerFrame += (decoded > 0) ? decodeNs / decoded : 0;
+
+    encoding.destroy();
+    decoding.destroy();
+  }
+  candidate.prr /= sizeof(p_es) / sizeof(p_es[0]);
+  candidate.delay /= sizeof(p_es) / sizeof(p_es[0]);
+  candidate.nsPerFrame /= sizeof(p_es) / sizeof(p_es[0]);
+}
+
+/*
+ * Search per window size the degree with the lowest objective (100 - p_rr) + delayWeight * delay + cpuWeight * us/frame.
+ * The candidates are simulated in parallel, each thread with its own scratch degree table. The best degrees are stored
+ * as degree table TUNER_TABLE and compared with the degree function w2d()
+ * @param R - code rate
+ * @param threads - number of worker threads, at most DARE_DEGREE_TABLES - 1
+ * @param delayWeight - weight of the mean delay, in percentage points p_rr per frame delay
+ * @param cpuWeight - weight of the decode time, in percentage points p_rr per microsecond per frame
+ */
+void degreeTuner(DaRe::R_VALUE R, unsigned int threads, double delayWeight, double cpuWeight) {
+  std::vector<TunerCandidate> candidates;
+  std::vector<std::thread> workers;
+  std::atomic<size_t> next(0);
+  uint8_t tuned[DaRe::W_64 + 1];
+  uint8_t windowSize, step, D, defaultD;
+  unsigned int thread_i;
+  size_t candidate_i;
+  int W_i;
+
+  threads = std::max(1u, std::min(threads, (unsigned int)(DARE_DEGREE_TABLES - 1)));
+
+  // all degrees for small windows, for larger windows a grid that always includes the default degree
+  for (W_i = DaRe::W_2; W_i <= DaRe::W_64; W_i++) {
+    windowSize = DaRe::getW((DaRe::W_VALUE)W_i);
+    defaultD = DaRe::getDegree(0, (DaRe::W_VALUE)W_i);
+    step = std::max(1, windowSize / TUNER_MAX_STEPS);
+    for (D = 1; D <= windowSize; D += step) {
+      TunerCandidate candidate;
+      candidate.W = (DaRe::W_VALUE)W_i;
+      candidate.D = D;
+      candidates.push_back(candidate);
+    }
+    if ((defaultD - 1) % step != 0) {
+      TunerCandidate candidate;
+      candidate.W = (DaRe::W_VALUE)W_i;
+      candidate.D = defaultD;
+      candidates.push_back(candidate);
+    }
+  }
+
+  std::cout << "Simulating " << candidates.size() << " candidates on " << threads << " threads" << std::endl;
+  for (thread_i = 0; thread_i < threads; thread_i++) {
+    workers.push_back(std::thread([&candidates, &next, thread_i, R]() {
+      size_t i;
+      while ((i = next++) < candidates.size()) {
+        evaluate(candidates[i], (uint8_t)(1 + thread_i), R);
+      }
+    }));
+  }
+  for (thread_i = 0; thread_i < threads; thread_i++) {
+    workers[thread_i].join();
+  }
+
+  for (candidate_i = 0; candidate_i < candidates.size(); candidate_i++) {
+    TunerCandidate &candidate = candidates[candidate_i];
+    candidate.objective = (100 - candidate.prr) + delayWeight * candidate.delay + cpuWeight * candidate.nsPerFrame / 1000;
+  }
+
+  std::cout << "W \tD \tp_rr \tavg_delay \tns/frame \tobjective \tD \tp_rr \tavg_delay \tns/frame \tobjective" << std::endl;
+  for (W_i = DaRe::W_0; W_i <= DaRe::W_64; W_i++) {
+    tuned[W_i] = DaRe::getDegree(0, (DaRe::W_VALUE)W_i);
+    TunerCandidate *best = NULL, *standard = NULL;
+    for (candidate_i = 0; candidate_i < candidates.size(); candidate_i++) {
+      TunerCandidate &candidate = candidates[candidate_i];
+      if (candidate.W != W_i) {
+        continue;
+      }
+      if (best == NULL || candidate.objective < best->objective) {
+        best = &candidate;
+      }
+      if (candidate.D == tuned[W_i]) {
+        standard = &candidate;
+      }
+    }
+    if (best == NULL || standard == NULL) {
+      continue;
+    }
+    tuned[W_i] = best->D;
+    std::cout << (int)DaRe::getW((DaRe::W_VALUE)W_i) << "\t" << (int)standard->D << "\t" << standard->prr << "\t" << standard->delay
+      << "\t" << standard->nsPerFrame << "\t" << standard->objective << "\t" << (int)best->D << "\t" << best->prr
+      << "\t" << best->delay << "\t" << best->nsPerFrame << "\t" << best->objective << std::endl;
+  }
+
+  DaRe::setDegreeTable(TUNER_TABLE, tuned);
+  std::cout << "Degree table " << TUNER_TABLE << ":";
+  for (W_i = DaRe::W_0; W_i <= DaRe::W_64; W_i++) {
+    std::cout << " " << (int)tuned[W_i];
+  }
+  std::cout << std::endl;
+}
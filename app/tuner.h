@@ -0,0 +1,24 @@
+/*
+/ _____)             _              | |
+( (____  _____ ____ _| |_ _____  ____| |__
+\____ \| ___ |    (_   _) ___ |/ ___)  _ \
+_____) ) ____| | | || |_| ____( (___| | | |
+(______/|_____)_|_|_| \__)_____)\____)_| |_|
+(C)2017 Semtech
+
+Description: Search for the degree of the parity checks per window size, as a degree table
+License: Revised BSD License, see LICENSE file included in the project
+By: Paul Marcelis
+*/
+#include "DaRe.h"
+
+#ifndef __DARE_TUNER_H
+#define __DARE_TUNER_H
+
+#define TUNER_FRAMES 10000 // frames per simulation of a candidate degree
+#define TUNER_TABLE 1 // the tuned degree table is stored under this number
+#define TUNER_MAX_STEPS 16 // maximal number of candidate degrees per window size
+
+void degreeTuner(DaRe::R_VALUE R, unsigned int threads, double delayWeight, double cpuWeight);
+
+#endif
@@ -0,0 +1,323 @@
+/*
+/ _____)             _              | |
+( (____  _____ ____ _| |_ _____  ____| |__
+\____ \| ___ |    (_   _) ___ |/ ___)  _ \
+_____) ) ____| | | || |_| ____( (___| | | |
+(______/|_____)_|_|_| \__)_____)\____)_| |_|
+(C)2017 Semtech
+
+Description: Genetic search for the loss patterns that make the decoder slowest, and replay of the patterns found
+License: Revised BSD License, see LICENSE file included in the project
+By: Paul Marcelis
+*/
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <algorithm>
+#include <string>
+#include "worstcase.h"
+#include "DaReEncode.h"
+#include "DaReDecode.h"
+
+#define WORST_CASE_ELITE 2 // best patterns copied unchanged to the next generation
+#define WORST_CASE_TOURNAMENT 3
+#define WORST_CASE_EVICTION_WEIGHT 100
+
+/*
+ * A loss pattern with the code parameters it is decoded with, and what it costs the decoder
+ */
+struct WorstCasePattern {
+  DaRe::R_VALUE R;
+  DaRe::W_VALUE W;
+  std::vector<bool> lost;
+  double maxFrameUs = 0; // the slowest decode() call
+  double meanFrameUs = 0;
+  uint32_t slowestFcntup = 0;
+  uint32_t allocations = 0; // parity checks stored in a buffer
+  uint32_t evictions = 0; // parity checks dropped because all buffers were in use
+  double fitness = 0;
+};
+
+/*
+ * Decode a pattern WORST_CASE_REPEATS times with the real encoder and decoder, timing every decode() call. Taking
+ * the fastest run of every frame filters out interruptions of the process
+ * @param pattern - the pattern, its results are filled in
+ * @param churn - whether the fitness is the buffer churn instead of the slowest frame
+ */
+static void evaluate(WorstCasePattern &pattern, bool churn) {
+  std::vector<double> frameUs(WORST_CASE_FRAMES, 0);
+  uint8_t dataPoint[2];
+  uint32_t fcntup, repeat, received = 0;
+  double sum = 0;
+
+  for (repeat = 0; repeat < WORST_CASE_REPEATS; repeat++) {
+    std::mt19937 rng(1);
+    DaRe::Payload payload;
+    DaReEncode encoding;
+    DaReDecode decoding;
+    encoding.init(&payload, sizeof(dataPoint), DaRe::R_1_5, DaRe::W_64);
+    encoding.set(pattern.R, pattern.W);
+    decoding.init(sizeof(dataPoint), WORST_CASE_FRAMES);
+    for (fcntup = 1; fcntup <= WORST_CASE_FRAMES; fcntup++) {
+      dataPoint[0] = (uint8_t)rng();
+      dataPoint[1] = (uint8_t)rng();
+      encoding.encode(&payload, dataPoint, fcntup);
+      if (pattern.lost[fcntup - 1]) {
+        continue;
+      }
+      std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+      decoding.decode(payload, fcntup);
+      double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+      frameUs[fcntup - 1] = (repeat == 0) ? us : std::min(frameUs[fcntup - 1], us);
+    }
+    pattern.allocations = decoding.getBufferAllocations();
+    pattern.evictions = decoding.getBufferEvictions();
+    encoding.destroy();
+    decoding.destroy();
+  }
+
+  pattern.maxFrameUs = 0;
+  for (fcntup = 1; fcntup <= WORST_CASE_FRAMES; fcntup++) {
+    if (pattern.lost[fcntup - 1]) {
+      continue;
+    }
+    received++;
+    sum += frameUs[fcntup - 1];
+    if (frameUs[fcntup - 1] > pattern.maxFrameUs) {
+      pattern.maxFrameUs = frameUs[fcntup - 1];
+      pattern.slowestFcntup = fcntup;
+    }
+  }
+  pattern.meanFrameUs = (received > 0) ? sum / received : 0;
+  // an eviction loses a parity check that could still have recovered data points, so it weighs more than a buffer stored
+  pattern.fitness = churn ? pattern.allocations + WORST_CASE_EVICTION_WEIGHT * pattern.evictions : pattern.maxFrameUs;
+}
+
+/*
+ * A random pattern: bursty losses at a random loss rate and burst length
+ */
+static WorstCasePattern randomPattern(std::mt19937 &rng) {
+  std::uniform_real_distribution<double> uniform(0.0, 1.0);
+  WorstCasePattern pattern;
+  double p_e = 0.05 + 0.6 * uniform(rng), p_badToGood = 0.05 + 0.9 * uniform(rng), p_goodToBad = p_badToGood * p_e / (1 - p_e);
+  bool bad = false;
+  uint32_t frame_i;
+
+  pattern.R = (DaRe::R_VALUE)(rng() % (DaRe::R_1_5 + 1));
+  pattern.W = (DaRe::W_VALUE)(DaRe::W_4 + rng() % (DaRe::W_64 - DaRe::W_4 + 1));
+  pattern.lost.resize(WORST_CASE_FRAMES);
+  for (frame_i = 0; frame_i < WORST_CASE_FRAMES; frame_i++) {
+    bad = bad ? (uniform(rng) >= p_badToGood) : (uniform(rng) < p_goodToBad);
+    pattern.lost[frame_i] = bad;
+  }
+  return pattern;
+}
+
+/*
+ * Change a pattern a little: flip some frames, add or remove a burst, or change R or W
+ */
+static void mutate(WorstCasePattern &pattern, std::mt19937 &rng) {
+  uint32_t start, length, frame_i;
+  switch (rng() % 6) {
+  case 0: // flip a few frames
+    for (frame_i = 0; frame_i < 1 + rng() % 8; frame_i++) {
+      start = rng() % WORST_CASE_FRAMES;
+      pattern.lost[start] = !pattern.lost[start];
+    }
+    break;
+  case 1: // a burst of losses
+  case 2: // or of received frames
+    start = rng() % WORST_CASE_FRAMES;
+    length = 1 + rng() % 80;
+    for (frame_i = start; frame_i < start + length && frame_i < WORST_CASE_FRAMES; frame_i++) {
+      pattern.lost[frame_i] = (rng() % 8 == 0) ? !pattern.lost[frame_i] : (rng() % 6 == 1);
+    }
+    break;
+  case 3: // shift a part of the pattern, moving the bursts relative to each other
+    start = rng() % WORST_CASE_FRAMES;
+    length = 1 + rng() % 16;
+    for (frame_i = WORST_CASE_FRAMES - 1; frame_i >= start + length; frame_i--) {
+      pattern.lost[frame_i] = pattern.lost[frame_i - length];
+    }
+    break;
+  case 4:
+    pattern.R = (DaRe::R_VALUE)(rng() % (DaRe::R_1_5 + 1));
+    break;
+  default:
+    pattern.W = (DaRe::W_VALUE)(DaRe::W_4 + rng() % (DaRe::W_64 - DaRe::W_4 + 1));
+    break;
+  }
+}
+
+/*
+ * one-point crossover of the loss masks, the code parameters come from either parent
+ */
+static WorstCasePattern crossover(const WorstCasePattern &a, const WorstCasePattern &b, std::mt19937 &rng) {
+  WorstCasePattern child = a;
+  uint32_t cut = rng() % WORST_CASE_FRAMES, frame_i;
+  for (frame_i = cut; frame_i < WORST_CASE_FRAMES; frame_i++) {
+    child.lost[frame_i] = b.lost[frame_i];
+  }
+  child.R = (rng() % 2 == 0) ? a.R : b.R;
+  child.W = (rng() % 2 == 0) ? a.W : b.W;
+  return child;
+}
+
+static const WorstCasePattern &tournament(const std::vector<WorstCasePattern> &population, std::mt19937 &rng) {
+  size_t best = rng() % population.size(), i, candidate;
+  for (i = 1; i < WORST_CASE_TOURNAMENT; i++) {
+    candidate = rng() % population.size();
+    if (population[candidate].fitness > population[best].fitness) {
+      best = candidate;
+    }
+  }
+  return population[best];
+}
+
+static bool fitter(const WorstCasePattern &a, const WorstCasePattern &b) {
+  return a.fitness > b.fitness;
+}
+
+/*
+ * the loss mask as hexadecimal digits, 4 frames per digit with the first frame in the lowest bit
+ */
+static std::string encodeMask(const std::vector<bool> &lost) {
+  static const char digits[] = "0123456789abcdef";
+  std::string mask;
+  uint32_t frame_i, bit_i, nibble;
+  for (frame_i = 0; frame_i < lost.size(); frame_i += 4) {
+    nibble = 0;
+    for (bit_i = 0; bit_i < 4 && frame_i + bit_i < lost.size(); bit_i++) {
+      nibble |= (lost[frame_i + bit_i] ? 1 : 0) << bit_i;
+    }
+    mask += digits[nibble];
+  }
+  return mask;
+}
+
+static bool decodeMask(const std::string &mask, std::vector<bool> &lost) {
+  uint32_t frame_i, nibble;
+  if (mask.size() * 4 < lost.size()) {
+    return false;
+  }
+  for (frame_i = 0; frame_i < lost.size(); frame_i++) {
+    char digit = mask[frame_i / 4];
+    nibble = (digit >= 'a') ? digit - 'a' + 10 : digit - '0';
+    lost[frame_i] = (nibble >> (frame_i % 4)) & 1;
+  }
+  return true;
+}
+
+static void printPattern(const char *objective, const WorstCasePattern &pattern) {
+  uint32_t lostCount = (uint32_t)std::count(pattern.lost.begin(), pattern.lost.end(), true);
+  std::cout << objective << "\t" << (int)DaRe::getR(pattern.R) << "\t" << (int)DaRe::getW(pattern.W) << "\t"
+    << (double)100 * lostCount / WORST_CASE_FRAMES << "\t" << pattern.maxFrameUs << "\t\t" << pattern.slowestFcntup << "\t"
+    << pattern.meanFrameUs << "\t\t" << pattern.allocations << "\t\t" << pattern.evictions << std::endl;
+}
+
+/*
+ * Search the loss patterns and code parameters that make decode() slowest, and those that churn the buffer pool the
+ * most, with a genetic algorithm. The best pattern of each search is appended to a file, to be
+ * replayed as a regression benchmark with worstCaseReplay()
+ * @param generations - number of generations
+ * @param population - patterns per generation
+ * @param path - file the patterns are appended to, NULL to only print them
+ * @param seed - random seed of the search
+ */
+void worstCaseSearch(uint32_t generations, uint32_t population, const char *path, uint32_t seed) {
+  static const char *objectives[] = { "time", "churn" };
+  std::mt19937 rng(seed);
+  std::vector<WorstCasePattern> current, next;
+  uint32_t generation, objective, i;
+
+  population = std::max(population, (uint32_t)WORST_CASE_ELITE + 2);
+  std::cout << "objective \tR \tW \tp_e \tmax [us] \tfcntup \tmean [us] \tallocations \tevictions" << std::endl;
+  for (objective = 0; objective < 2; objective++) {
+    current.clear();
+    for (i = 0; i < population; i++) {
+      current.push_back(randomPattern(rng));
+      evaluate(current.back(), objective == 1);
+    }
+    std::sort(current.begin(), current.end(), fitter);
+
+    for (generation = 0; generation < generations; generation++) {
+      next.assign(current.begin(), current.begin() + WORST_CASE_ELITE);
+      while (next.size() < population) {
+        WorstCasePattern child = crossover(tournament(current, rng), tournament(current, rng), rng);
+        mutate(child, rng);
+        if (rng() % 2 == 0) {
+          mutate(child, rng);
+        }
+        evaluate(child, objective == 1);
+        next.push_back(child);
+      }
+      // the elite is measured again, so a pattern cannot stay on top by one lucky measurement
+      for (i = 0; i < WORST_CASE_ELITE; i++) {
+        evaluate(next[i], objective == 1);
+      }
+      std::sort(next.begin(), next.end(), fitter);
+      current.swap(next);
+#if DEBUG >= 1
+      std::cout << "generation " << generation << ": ";
+      printPattern(objectives[objective], current[0]);
+#endif
+    }
+    printPattern(objectives[objective], current[0]);
+
+    if (path != NULL) {
+      std::ofstream file(path, std::ios::app);
+      file << objectives[objective] << " " << (int)DaRe::getR(current[0].R) << " " << (int)DaRe::getW(current[0].W) << " "
+        << WORST_CASE_FRAMES << " " << current[0].maxFrameUs << " " << current[0].allocations << " " << current[0].evictions << " " << encodeMask(current[0].lost) << std::endl;
+    }
+  }
+}
+
+/*
+ * Decode the patterns stored by worstCaseSearch() again and compare with the stored results. Every line of the file is
+ * objective R W frames max_us allocations evictions mask, lines starting with # are comments
+ * @param path - the file with the patterns
+ * @return 0 if the file could be read
+ */
+int worstCaseReplay(const char *path) {
+  std::ifstream file(path);
+  std::string line, objective, mask;
+  int R, W;
+  uint32_t frames, allocations, evictions;
+  double maxFrameUs;
+
+  if (!file) {
+    std::cout << "Cannot read " << path << std::endl;
+    return 1;
+  }
+  std::cout << "objective \tR \tW \tp_e \tmax [us] \tfcntup \tmean [us] \tallocations \tevictions \tstored max [us] \tstored allocations \tstored evictions" << std::endl;
+  while (std::getline(file, line)) {
+    if (line.empty() || line[0] == '#') {
+      continue;
+    }
+    std::istringstream fields(line);
+    WorstCasePattern pattern;
+    if (!(fields >> objective >> R >> W >> frames >> maxFrameUs >> allocations >> evictions >> mask) || frames != WORST_CASE_FRAMES) {
+      std::cout << "Skipping line: " << line << std::endl;
+      continue;
+    }
+    pattern.R = DaRe::R_1_2;
+    while (pattern.R < DaRe::R_1_5 && DaRe::getR(pattern.R) < R) pattern.R = (DaRe::R_VALUE)(pattern.R + 1);
+    pattern.W = DaRe::W_1;
+    while (pattern.W < DaRe::W_64 && DaRe::getW(pattern.W) < W) pattern.W = (DaRe::W_VALUE)(pattern.W + 1);
+    pattern.lost.resize(WORST_CASE_FRAMES);
+    if (!decodeMask(mask, pattern.lost)) {
+      std::cout << "Skipping line: " << line << std::endl;
+      continue;
+    }
+    evaluate(pattern, objective == "churn");
+    uint32_t lostCount = (uint32_t)std::count(pattern.lost.begin(), pattern.lost.end(), true);
+    std::cout << objective << "\t\t" << R << "\t" << W << "\t" << (double)100 * lostCount / WORST_CASE_FRAMES << "\t"
+      << pattern.maxFrameUs << "\t\t" << pattern.slowestFcntup << "\t" << pattern.meanFrameUs << "\t\t" << pattern.allocations
+      << "\t\t" << pattern.evictions << "\t\t" << maxFrameUs << "\t\t\t" << allocations << "\t\t\t" << evictions << std::endl;
+  }
+  return 0;
+}
@@ -0,0 +1,24 @@
+/*
+/ _____)             _              | |
+( (____  _____ ____ _| |_ _____  ____| |__
+\____ \| ___ |    (_   _) ___ |/ ___)  _ \
+_____) ) ____| | | || |_| ____( (___| | | |
+(______/|_____)_|_|_| \__)_____)\____)_| |_|
+(C)2017 Semtech
+
+Description: Genetic search for the loss patterns that make the decoder slowest, and replay of the patterns found
+License: Revised BSD License, see LICENSE file included in the project
+By: Paul Marcelis
+*/
+#include "DaRe.h"
+
+#ifndef __DARE_WORST_CASE_H
+#define __DARE_WORST_CASE_H
+
+#define WORST_CASE_FRAMES 1000 // frames per loss pattern
+#define WORST_CASE_REPEATS 3 // runs per pattern, the time of a frame is the fastest of its runs
+
+void worstCaseSearch(uint32_t generations, uint32_t population, const char *path, uint32_t seed);
+int worstCaseReplay(const char *path);
+
+#endif
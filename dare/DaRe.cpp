@@ -10,6 +10,8 @@ Description: General functions for DaRe
 License: Revised BSD License, see LICENSE file included in the project
 By: Paul Marcelis
 */
+#include <algorithm>
+#include <cmath>
 #include "DaRe.h"
 
 /*
@@ -20,6 +22,54 @@ double DaRe::w2d(uint8_t W) {
   return W2D_A * exp(W2D_B * W) + W2D_C;
 }
 
+uint8_t DaRe::degreeTables[DARE_DEGREE_TABLES][W_64 + 1];
+bool DaRe::degreeTableSet[DARE_DEGREE_TABLES];
+
+/*
+ * Get the absolute degree, the number of previous data points in a parity check, for a window size
+ * @param table - degree table, 0 for the degree function w2d()
+ * @param W - window size enumerate value
+ * @return the degree, 0 for a degree table that is not set
+ */
+uint8_t DaRe::getDegree(uint8_t table, W_VALUE W) {
+  uint8_t windowSize = getW(W);
+  if (table == 0 || table >= DARE_DEGREE_TABLES) {
+    return (uint8_t)round(windowSize * w2d(windowSize));
+  }
+  return degreeTableSet[table] ? degreeTables[table][W] : 0;
+}
+
+/*
+ * Set a degree table, for instance tuned for a deployment. Device and network server need the same table under the
+ * same number, the number is signalled in the extension byte of the payload header
+ * @param table - degree table 1 to DARE_DEGREE_TABLES - 1, table 0 is fixed to w2d()
+ * @param degrees - the absolute degree for each window size enumerate value W_0 to W_64, at most the window size
+ * @return false if the table number or a degree is invalid
+ */
+bool DaRe::setDegreeTable(uint8_t table, const uint8_t *degrees) {
+  uint8_t W_i;
+  if (table == 0 || table >= DARE_DEGREE_TABLES) {
+    return false;
+  }
+  for (W_i = W_0; W_i <= W_64; W_i++) {
+    if (degrees[W_i] > getW((W_VALUE)W_i)) {
+      return false;
+    }
+  }
+  for (W_i = W_0; W_i <= W_64; W_i++) {
+    degreeTables[table][W_i] = degrees[W_i];
+  }
+  degreeTableSet[table] = true;
+  return true;
+}
+
+/*
+ * check whether a degree table can be used
+ */
+bool DaRe::hasDegreeTable(uint8_t table) {
+  return table == 0 || (table < DARE_DEGREE_TABLES && degreeTableSet[table]);
+}
+
 /*
  * If the window size W is larger than the history (calculated from the frame counter), return the maximum possible window size
  */
@@ -27,6 +77,55 @@ uint8_t DaRe::getWindowSize(uint8_t W, uint32_t fcntup) {
   return ((fcntup - 1) < W) ? (fcntup - 1) : W;
 }
 
+/*
+ * get the number of readings k in the payload of a frame, 1 without an extension byte
+ */
+uint8_t DaRe::getK(const uint8_t *payload) {
+  if (((payload[0] >> DARE_HEADER_X_SHIFT) & 1) == 0) {
+    return 1;
+  }
+  return ((payload[1] >> DARE_EXTENSION_K_SHIFT) & DARE_EXTENSION_K_MASK) + 1;
+}
+
+/*
+ * check whether a received payload holds all the bytes its header announces: the extension byte if X is set, and the
+ * k readings with R - 1 parity checks each. The decoders trust the header, so a shorter payload must not reach them
+ * @param payload - the payload of the frame
+ * @param payloadSize - the number of bytes received
+ * @param dataPointSize - the size of a reading
+ */
+bool DaRe::isPayloadComplete(const uint8_t *payload, uint32_t payloadSize, uint8_t dataPointSize) {
+  if (payloadSize < 1 || (((payload[0] >> DARE_HEADER_X_SHIFT) & 1) && payloadSize < 2)) {
+    return false;
+  }
+  uint32_t headerSize = ((payload[0] >> DARE_HEADER_X_SHIFT) & 1) ? 2 : 1;
+  uint32_t R = getR((R_VALUE)((payload[0] >> DARE_HEADER_R_SHIFT) & DARE_HEADER_R_MASK));
+  return payloadSize >= headerSize + (uint32_t)dataPointSize * R * getK(payload);
+}
+
+/*
+ * Copy one reading of a frame with k readings and its parity checks to a payload of its own, with the same header
+ * but k = 1. That payload is decoded as a frame with reading counter (fcntup - 1) * k + reading_i + 1
+ * @param reading - buffer for the payload of the reading, at least 2 + dataPointSize * R bytes
+ * @param payload - the payload of the frame
+ * @param reading_i - the index of the reading in the frame
+ * @param dataPointSize - the size of a reading
+ * @return the size of the payload of the reading
+ */
+uint8_t DaRe::getReading(uint8_t *reading, const uint8_t *payload, uint8_t reading_i, uint8_t dataPointSize) {
+  uint8_t k = getK(payload), R = getR((R_VALUE)((payload[0] >> DARE_HEADER_R_SHIFT) & DARE_HEADER_R_MASK));
+  uint8_t headerSize = ((payload[0] >> DARE_HEADER_X_SHIFT) & 1) ? 2 : 1;
+  const uint8_t *parityChecks = &payload[headerSize + dataPointSize * (k + (R - 1) * reading_i)];
+
+  reading[0] = payload[0];
+  if (headerSize == 2) {
+    reading[1] = payload[1] & DARE_EXTENSION_TABLE_MASK;
+  }
+  std::copy(&payload[headerSize + dataPointSize * reading_i], &payload[headerSize + dataPointSize * (reading_i + 1)], &reading[headerSize]);
+  std::copy(parityChecks, parityChecks + dataPointSize * (R - 1), &reading[headerSize + dataPointSize]);
+  return headerSize + dataPointSize * R;
+}
+
 /*
  * Convert a window size W enumerate value to the corresponding integer value, returns 0 if incorrect
  */
@@ -84,32 +183,16 @@ uint8_t DaRe::getR(R_VALUE enumR) {
 
   return R;
 }
-#ifdef CONVENTIONAL_CODING
-/*
- * Pseudo random line generator function for conventional coding. 
- */
-bool *DaRe::prlg(uint8_t W, uint32_t fcntup, uint8_t R) {
-  bool *line = new bool[W]();
-  if (R > W) {
-    return line;
-  }
-
-  line[R] = 1;
-
-  return line;
-}
-#else
 /*
  * Pseudo random line generator for DaRe. This function is used to calculate the generator lines that are used to calculate the parity checks for certain frames
  * @param W - window size
  * @param fcntup - frame counter value for the frame to calculate the generator line for
  * @param R - code rae
+ * @param D - absolute degree, number of previous data units to use in the parity check (see getDegree())
  */
-bool *DaRe::prlg(uint8_t W, uint32_t fcntup, uint8_t R) {
-  double d = w2d(W); //calculate relative degree
-  uint8_t D = (uint8_t) round(W * d); //determine absolute degree, number of previous data units to use in the parity check
+bool *DaRe::prlg(uint8_t W, uint32_t fcntup, uint8_t R, uint8_t D) {
 #if DEBUG >= 3
-  std::cout << "d = " << d << ", D = " << (unsigned int)D << std::endl;
+  std::cout << "D = " << (unsigned int)D << std::endl;
 #endif
   bool *line = new bool[W]();
   uint32_t index = fcntup, indexNew, indexTemp;
@@ -132,7 +215,28 @@ bool *DaRe::prlg(uint8_t W, uint32_t fcntup, uint8_t R) {
 
   return line;
 }
-#endif
+
+/*
+ * Pseudo random coefficient generator for the GF(256) mode. Returns a non-zero coefficient for every position of the generator line,
+ * to be used only for the positions that prlg() includes in the parity check
+ * @param W - window size
+ * @param fcntup - frame counter value for the frame to calculate the coefficients for
+ * @param R - code rate index of the parity check within the frame
+ */
+uint8_t *DaRe::prcg(uint8_t W, uint32_t fcntup, uint8_t R) {
+  uint8_t *coefficients = new uint8_t[W]();
+  uint8_t lfsr = (uint8_t)(((fcntup * 29) + (R * 113)) % 255) + 1;
+  uint8_t lfsrOut, i;
+
+  for (i = 0; i < W; i++) {
+    //x^8+x^6+x^5+x^4+1, same register as prng(), never reaches zero
+    lfsrOut = ((lfsr >> 0) ^ (lfsr >> 2) ^ (lfsr >> 3) ^ (lfsr >> 4)) & 1;
+    lfsr = (lfsr >> 1) | (lfsrOut << 7);
+    coefficients[i] = lfsr;
+  }
+
+  return coefficients;
+}
 
 /*
  * calculate a pseudo random number on the interval [0, max] with index and seed as seeds
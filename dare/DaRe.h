@@ -19,25 +19,51 @@ By: Paul Marcelis
 
 #define DEBUG 0 // Amount of debug data to print to std::out. 0 = none, 1 = only result, 2 = process, 3 = all (with matrices)
 #define DARE_MAX_W 64 //absolute maximal supported value for window size W
-//#define CONVENTIONAL_CODING //uncomment to apply a repetition coding scheme instead of DaRe
+#define DARE_DEGREE_TABLES 16 // number of degree tables, table 0 is the degree function w2d()
 
 class DaRe {
 public:
   enum R_VALUE { R_1_2, R_1_3, R_1_4, R_1_5 }; // Coding rate enumerate values
   enum W_VALUE { W_0, W_1, W_2, W_4, W_8, W_16, W_32, W_64 }; // Window size enumerate values
+  enum F_VALUE { F_GF2, F_GF256 }; // Field of the parity check coefficients, GF(2) is the plain XOR of DaRe
+  enum S_VALUE { S_DARE, S_REPETITION }; // Coding strategy, see DaReStrategy.h. Not signalled in the payload, device and network server have to agree on it
   struct Payload {
     uint8_t *payload;
     uint8_t payloadSize;
   };
 
-  static bool *prlg(uint8_t W, uint32_t fcntup, uint8_t R);
+  static bool *prlg(uint8_t W, uint32_t fcntup, uint8_t R, uint8_t D);
+  static uint8_t *prcg(uint8_t W, uint32_t fcntup, uint8_t R);
   static uint8_t prng(uint8_t max, uint32_t index, uint32_t seed);
   static uint8_t getW(W_VALUE);
   static uint8_t getR(R_VALUE);
   static double w2d(uint8_t W);
+  static uint8_t getDegree(uint8_t table, W_VALUE W);
+  static bool setDegreeTable(uint8_t table, const uint8_t *degrees);
+  static bool hasDegreeTable(uint8_t table);
   static uint8_t getWindowSize(uint8_t W, uint32_t fcntup);
+  static uint8_t getK(const uint8_t *payload);
+  static bool isPayloadComplete(const uint8_t *payload, uint32_t payloadSize, uint8_t dataPointSize);
+  static uint8_t getReading(uint8_t *reading, const uint8_t *payload, uint8_t reading_i, uint8_t dataPointSize);
+
+private:
+  static uint8_t degreeTables[DARE_DEGREE_TABLES][W_64 + 1]; // absolute degree per window size enumerate value
+  static bool degreeTableSet[DARE_DEGREE_TABLES];
 };
 
+// Layout of the first payload byte: bit 7 = field F, bit 6 = extension byte X, bits 5-4 = code rate R, bits 3-0 = window size W
+// If X is set, a second header byte follows: bits 7-4 = readings per frame k - 1, bits 3-0 = degree table. Without it,
+// degree table 0 is used and a frame carries one reading
+#define DARE_HEADER_F_SHIFT 7
+#define DARE_HEADER_X_SHIFT 6
+#define DARE_EXTENSION_TABLE_MASK 0xf
+#define DARE_EXTENSION_K_SHIFT 4
+#define DARE_EXTENSION_K_MASK 0xf
+#define DARE_MAX_K 16 // maximal number of readings per frame
+#define DARE_HEADER_R_SHIFT 4
+#define DARE_HEADER_R_MASK 0x3
+#define DARE_HEADER_W_MASK 0xf
+
 #define W2D_A 0.75
 #define W2D_B -0.0625
 #define W2D_C 0.25
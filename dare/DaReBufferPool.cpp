@@ -0,0 +1,241 @@
+/*
+ / _____)             _              | |
+( (____  _____ ____ _| |_ _____  ____| |__
+ \____ \| ___ |    (_   _) ___ |/ ___)  _ \
+ _____) ) ____| | | || |_| ____( (___| | | |
+(______/|_____)_|_|_| \__)_____)\____)_| |_|
+    (C)2017 Semtech
+	
+Description: Pool of buffers holding the intermediate recovery results of the decoder
+License: Revised BSD License, see LICENSE file included in the project
+By: Paul Marcelis
+*/
+#include "DaReBufferPool.h"
+
+/*
+ * Number of buffers worth keeping for certain coding parameters. A parity check can only pay off while its oldest data point can
+ * still be included in a future parity check, so only the parity checks of about the last 2 * W frames are useful, each frame
+ * carrying R - 1 of them
+ */
+uint32_t DaReBufferPool::getPoolSize(uint8_t R, uint8_t W) {
+  uint32_t size = (R > 1) ? (uint32_t)(R - 1) * 2 * W : 0;
+  return (size < DARE_DECODING_BUFFERS_MIN) ? DARE_DECODING_BUFFERS_MIN : size;
+}
+
+/*
+ * grow the pool to a certain number of buffers, buffers in use are kept. The pool never shrinks
+ */
+void DaReBufferPool::resize(uint32_t size) {
+  uint32_t i;
+  if (size <= poolSize) {
+    return;
+  }
+
+  buffer *newBuffers = new buffer[size];
+  uint32_t *newFreeList = new uint32_t[size];
+  uint32_t *newHeap = new uint32_t[size];
+  uint32_t *newHeapPosition = new uint32_t[size];
+  for (i = 0; i < poolSize; i++) {
+    newBuffers[i] = buffers[i];
+    newHeapPosition[i] = heapPosition[i];
+  }
+  for (i = 0; i < freeCount; i++) {
+    newFreeList[i] = freeList[i];
+  }
+  for (i = 0; i < heapCount; i++) {
+    newHeap[i] = heap[i];
+  }
+  // new buffers are added to the free list in reverse, so the lowest index is used first
+  for (i = size; i > poolSize; i--) {
+    newFreeList[freeCount++] = i - 1;
+  }
+
+  delete[] buffers;
+  delete[] freeList;
+  delete[] heap;
+  delete[] heapPosition;
+  buffers = newBuffers;
+  freeList = newFreeList;
+  heap = newHeap;
+  heapPosition = newHeapPosition;
+  poolSize = size;
+}
+
+/*
+ * release all buffers and the pool itself
+ */
+void DaReBufferPool::destroy() {
+  uint32_t i;
+  for (i = 0; i < poolSize; i++) {
+    if (buffers[i].inUse) {
+      release(i);
+    }
+  }
+  delete[] buffers;
+  delete[] freeList;
+  delete[] heap;
+  delete[] heapPosition;
+  buffers = NULL;
+  freeList = heap = heapPosition = NULL;
+  poolSize = freeCount = heapCount = 0;
+}
+
+/*
+ * charge a memory budget for the buffers in use from now on, see DaReMemoryBudget. Pass NULL to stop charging
+ * @param budgetIn - the budget
+ * @param accountIn - account of the decoder of this pool
+ * @param bytesPerBuffer - bytes charged per buffer in use
+ */
+void DaReBufferPool::setBudget(DaReMemoryBudget *budgetIn, uint32_t accountIn, uint32_t bytesPerBufferIn) {
+  // the buffers already in use move to the new budget
+  if (budget != NULL) {
+    budget->credit(account, (size_t)heapCount * bytesPerBuffer);
+  }
+  budget = budgetIn;
+  account = accountIn;
+  bytesPerBuffer = bytesPerBufferIn;
+  if (budget != NULL) {
+    budget->charge(account, (size_t)heapCount * bytesPerBuffer);
+  }
+}
+
+/*
+ * get an unused buffer for a parity check of a certain frame. If all buffers are in use, the oldest buffer is released and reused,
+ * since the oldest buffer has the smallest probability of being solved ever again
+ * @return index of the buffer
+ */
+uint32_t DaReBufferPool::allocate(uint32_t fcntup) {
+  uint32_t bufferI;
+  if (freeCount == 0) {
+#if DEBUG >= 2
+    std::cout << "BUFFER FULL!!!, replace the oldest buffer" << std::endl;
+#endif
+    release(heap[0]);
+    evictions++;
+  }
+  bufferI = freeList[--freeCount];
+  allocations++;
+  if (budget != NULL) {
+    budget->charge(account, bytesPerBuffer);
+  }
+  buffers[bufferI].inUse = true;
+  buffers[bufferI].reduced = false;
+  buffers[bufferI].fcntup = fcntup;
+  heap[heapCount] = bufferI;
+  heapPosition[bufferI] = heapCount;
+  heapCount++;
+  heapUp(heapCount - 1);
+  return bufferI;
+}
+
+/*
+ * release a buffer and the memory of its contents
+ */
+void DaReBufferPool::release(uint32_t bufferI) {
+  uint32_t position = heapPosition[bufferI];
+
+  delete[] buffers[bufferI].parityCheck;
+  delete[] buffers[bufferI].generatorLine;
+  delete[] buffers[bufferI].coefficients;
+  buffers[bufferI].parityCheck = NULL;
+  buffers[bufferI].generatorLine = NULL;
+  buffers[bufferI].coefficients = NULL;
+  buffers[bufferI].inUse = false;
+  if (budget != NULL) {
+    budget->credit(account, bytesPerBuffer);
+  }
+
+  heapCount--;
+  if (position != heapCount) {
+    heapSwap(position, heapCount);
+    heapUp(position);
+    heapDown(position);
+  }
+  freeList[freeCount++] = bufferI;
+}
+
+/*
+ * index of the buffer with the oldest parity check, only valid if inUse() > 0
+ */
+uint32_t DaReBufferPool::oldest() {
+  return heap[0];
+}
+
+/*
+ * getter for the number of buffers in the pool
+ */
+uint32_t DaReBufferPool::size() {
+  return poolSize;
+}
+
+/*
+ * bytes in use by the pool and the contents of its buffers
+ */
+size_t DaReBufferPool::memoryUsage(uint8_t dataPointSize) {
+  size_t bytes = (size_t)poolSize * (sizeof(buffer) + 3 * sizeof(uint32_t));
+  uint32_t i;
+  for (i = 0; i < poolSize; i++) {
+    if (buffers[i].inUse) {
+      bytes += dataPointSize + DARE_MAX_W * ((buffers[i].coefficients != NULL) ? 2 : 1);
+    }
+  }
+  return bytes;
+}
+
+/*
+ * getter for the number of buffers in use
+ */
+uint32_t DaReBufferPool::inUse() {
+  return heapCount;
+}
+
+/*
+ * getter for the number of buffers that were released because the pool was full
+ */
+uint32_t DaReBufferPool::getEvictions() {
+  return evictions;
+}
+
+/*
+ * getter for the number of buffers handed out, evicted or not
+ */
+uint32_t DaReBufferPool::getAllocations() {
+  return allocations;
+}
+
+DaReBufferPool::buffer &DaReBufferPool::operator[](uint32_t bufferI) {
+  return buffers[bufferI];
+}
+
+void DaReBufferPool::heapSwap(uint32_t a, uint32_t b) {
+  uint32_t temp = heap[a];
+  heap[a] = heap[b];
+  heap[b] = temp;
+  heapPosition[heap[a]] = a;
+  heapPosition[heap[b]] = b;
+}
+
+void DaReBufferPool::heapUp(uint32_t position) {
+  while (position > 0 && buffers[heap[(position - 1) / 2]].fcntup > buffers[heap[position]].fcntup) {
+    heapSwap(position, (position - 1) / 2);
+    position = (position - 1) / 2;
+  }
+}
+
+void DaReBufferPool::heapDown(uint32_t position) {
+  uint32_t smallest;
+  while (true) {
+    smallest = position;
+    if (2 * position + 1 < heapCount && buffers[heap[2 * position + 1]].fcntup < buffers[heap[smallest]].fcntup) {
+      smallest = 2 * position + 1;
+    }
+    if (2 * position + 2 < heapCount && buffers[heap[2 * position + 2]].fcntup < buffers[heap[smallest]].fcntup) {
+      smallest = 2 * position + 2;
+    }
+    if (smallest == position) {
+      return;
+    }
+    heapSwap(position, smallest);
+    position = smallest;
+  }
+}
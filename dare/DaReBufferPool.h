@@ -0,0 +1,68 @@
+/*
+ / _____)             _              | |
+( (____  _____ ____ _| |_ _____  ____| |__
+ \____ \| ___ |    (_   _) ___ |/ ___)  _ \
+ _____) ) ____| | | || |_| ____( (___| | | |
+(______/|_____)_|_|_| \__)_____)\____)_| |_|
+    (C)2017 Semtech
+	
+Description: Pool of buffers holding the intermediate recovery results of the decoder
+License: Revised BSD License, see LICENSE file included in the project
+By: Paul Marcelis
+*/
+#include "DaRe.h"
+#include "DaReMemoryBudget.h"
+
+#ifndef __DARE_BUFFER_POOL_H
+#define __DARE_BUFFER_POOL_H
+
+#define DARE_DECODING_BUFFERS_MIN 8 // lower limit on the number of buffers, whatever R and W
+
+class DaReBufferPool {
+public:
+  struct buffer {
+    bool inUse = false;
+    uint32_t fcntup;
+    uint8_t *parityCheck = NULL;
+    bool *generatorLine = NULL;
+    uint8_t *coefficients = NULL; // only for parity checks in GF(256), NULL for plain XOR parity checks
+    uint8_t windowSize;
+    bool reduced = false; // a row of the last elimination, unchanged since
+  };
+
+private:
+  buffer *buffers = NULL;
+  uint32_t *freeList = NULL; // stack of unused buffer indices
+  uint32_t freeCount = 0;
+  uint32_t *heap = NULL; // buffer indices in use, as a min-heap on fcntup, so the oldest buffer is on top
+  uint32_t *heapPosition = NULL; // position of every buffer index in the heap
+  uint32_t heapCount = 0;
+  uint32_t poolSize = 0;
+  uint32_t evictions = 0;
+  uint32_t allocations = 0;
+  DaReMemoryBudget *budget = NULL; // optional, charged for every buffer in use
+  uint32_t account = 0;
+  uint32_t bytesPerBuffer = 0;
+
+  void heapSwap(uint32_t a, uint32_t b);
+  void heapUp(uint32_t position);
+  void heapDown(uint32_t position);
+
+public:
+  static uint32_t getPoolSize(uint8_t R, uint8_t W);
+
+  void resize(uint32_t size);
+  void destroy();
+  void setBudget(DaReMemoryBudget *budgetIn, uint32_t accountIn, uint32_t bytesPerBufferIn);
+  uint32_t allocate(uint32_t fcntup);
+  void release(uint32_t bufferI);
+  uint32_t oldest();
+  uint32_t size();
+  uint32_t inUse();
+  uint32_t getEvictions();
+  uint32_t getAllocations();
+  size_t memoryUsage(uint8_t dataPointSize);
+  buffer &operator[](uint32_t bufferI);
+};
+
+#endif
@@ -0,0 +1,378 @@
+/*
+ / _____)             _              | |
+( (____  _____ ____ _| |_ _____  ____| |__
+ \____ \| ___ |    (_   _) ___ |/ ___)  _ \
+ _____) ) ____| | | || |_| ____( (___| | | |
+(______/|_____)_|_|_| \__)_____)\____)_| |_|
+    (C)2017 Semtech
+	
+Description: Memory-mapped columnar file storing the recovered data points of many devices
+License: Revised BSD License, see LICENSE file included in the project
+By: Paul Marcelis
+*/
+#include <iostream>
+#include <algorithm>
+#include <string.h>
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#include "DaReColumnStore.h"
+
+static uint32_t alignColumn(uint32_t size) {
+  return (size + DARE_COLUMN_ALIGN - 1) / DARE_COLUMN_ALIGN * DARE_COLUMN_ALIGN;
+}
+
+/*
+ * open or create a column store file
+ * @param path - the file, an existing file is appended to
+ * @param dataPointSizeIn - the size in bytes of the data points, has to match the size in an existing file
+ * @return false if the file cannot be opened, mapped or has a different format
+ */
+bool DaReColumnStore::init(const char *path, uint8_t dataPointSizeIn) {
+  uint64_t fileSize;
+
+  dataPointSize = dataPointSizeIn;
+  setLayout();
+
+#ifdef _WIN32
+  LARGE_INTEGER size;
+  file = CreateFileA(path, GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, NULL, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+  if (file == INVALID_HANDLE_VALUE || !GetFileSizeEx((HANDLE)file, &size)) {
+    std::cout << "Cannot open column store " << path << std::endl;
+    file = NULL;
+    return false;
+  }
+  fileSize = (uint64_t)size.QuadPart;
+#else
+  struct stat status;
+  file = open(path, O_RDWR | O_CREAT, 0644);
+  if (file < 0 || fstat(file, &status) != 0) {
+    std::cout << "Cannot open column store " << path << std::endl;
+    return false;
+  }
+  fileSize = (uint64_t)status.st_size;
+#endif
+
+  if (fileSize < DARE_COLUMN_BLOCK_SIZE) {
+    // a new file
+    if (!mapFile(DARE_COLUMN_GROW_BLOCKS)) {
+      destroy();
+      return false;
+    }
+    getFileHeader()->magic = DARE_COLUMN_MAGIC;
+    getFileHeader()->blockSize = DARE_COLUMN_BLOCK_SIZE;
+    getFileHeader()->blocksUsed = 1;
+    getFileHeader()->dataPointSize = dataPointSize;
+    return true;
+  }
+
+  if (!mapFile((uint32_t)(fileSize / DARE_COLUMN_BLOCK_SIZE))) {
+    destroy();
+    return false;
+  }
+  if (getFileHeader()->magic != DARE_COLUMN_MAGIC || getFileHeader()->blockSize != DARE_COLUMN_BLOCK_SIZE
+    || getFileHeader()->dataPointSize != dataPointSize || getFileHeader()->blocksUsed > blocksAllocated) {
+    std::cout << "Column store " << path << " has a different format" << std::endl;
+    destroy();
+    return false;
+  }
+
+  // rebuild the index of the blocks per device
+  uint32_t block;
+  for (block = 1; block < getFileHeader()->blocksUsed; block++) {
+    devices[getBlockHeader(block)->deviceId].blocks.push_back(block);
+  }
+  return true;
+}
+
+/*
+ * write all batched records, and close the file
+ */
+void DaReColumnStore::destroy() {
+  if (map != NULL) {
+    flush();
+  }
+  unmapFile();
+#ifdef _WIN32
+  if (file != NULL) {
+    CloseHandle((HANDLE)file);
+    file = NULL;
+  }
+#else
+  if (file >= 0) {
+    close(file);
+    file = -1;
+  }
+#endif
+  devices.clear();
+  blocksAllocated = 0;
+}
+
+/*
+ * compute the number of records per block and the offsets of the columns, each column starts aligned
+ */
+void DaReColumnStore::setLayout() {
+  blockCapacity = (DARE_COLUMN_BLOCK_SIZE - DARE_COLUMN_ALIGN) / (4 + 4 + dataPointSize + 1 + 1);
+  while (true) {
+    offsetDelay = DARE_COLUMN_ALIGN + alignColumn(4 * blockCapacity);
+    offsetValue = offsetDelay + alignColumn(4 * blockCapacity);
+    offsetPhase = offsetValue + alignColumn(dataPointSize * blockCapacity);
+    offsetLost = offsetPhase + alignColumn(blockCapacity);
+    if (offsetLost + alignColumn(blockCapacity) <= DARE_COLUMN_BLOCK_SIZE) {
+      break;
+    }
+    blockCapacity--;
+  }
+}
+
+/*
+ * (re)map the file with a certain number of blocks, growing the file if needed. The new mapping is made before the
+ * previous one is released, so if the file cannot grow or be mapped the store keeps working with the previous mapping
+ * all pointers into the previous mapping become invalid
+ */
+bool DaReColumnStore::mapFile(uint32_t blocks) {
+  uint64_t size = (uint64_t)blocks * DARE_COLUMN_BLOCK_SIZE;
+  uint8_t *newMap = NULL;
+
+#ifdef _WIN32
+  // the mapping grows the file to the mapped size
+  void *newMapping = CreateFileMappingA((HANDLE)file, NULL, PAGE_READWRITE, (DWORD)(size >> 32), (DWORD)size, NULL);
+  if (newMapping != NULL) {
+    newMap = (uint8_t *)MapViewOfFile((HANDLE)newMapping, FILE_MAP_ALL_ACCESS, 0, 0, (SIZE_T)size);
+    if (newMap == NULL) {
+      CloseHandle((HANDLE)newMapping);
+    }
+  }
+#else
+  struct stat status;
+  if (fstat(file, &status) != 0 || ((uint64_t)status.st_size < size && ftruncate(file, (off_t)size) != 0)) {
+    std::cout << "Cannot grow column store" << std::endl;
+    return false;
+  }
+  void *mapped = mmap(NULL, (size_t)size, PROT_READ | PROT_WRITE, MAP_SHARED, file, 0);
+  newMap = (mapped == MAP_FAILED) ? NULL : (uint8_t *)mapped;
+#endif
+  if (newMap == NULL) {
+    std::cout << "Cannot map column store" << std::endl;
+    return false;
+  }
+
+  unmapFile();
+  map = newMap;
+#ifdef _WIN32
+  mapping = newMapping;
+#endif
+  blocksAllocated = blocks;
+  return true;
+}
+
+/*
+ * write the mapped blocks back to the file and unmap them
+ */
+void DaReColumnStore::unmapFile() {
+  if (map != NULL) {
+#ifdef _WIN32
+    FlushViewOfFile(map, 0);
+    UnmapViewOfFile(map);
+#else
+    msync(map, (size_t)blocksAllocated * DARE_COLUMN_BLOCK_SIZE, MS_ASYNC);
+    munmap(map, (size_t)blocksAllocated * DARE_COLUMN_BLOCK_SIZE);
+#endif
+    map = NULL;
+  }
+#ifdef _WIN32
+  if (mapping != NULL) {
+    CloseHandle((HANDLE)mapping);
+    mapping = NULL;
+  }
+#endif
+}
+
+DaReColumnStore::fileHeader *DaReColumnStore::getFileHeader() {
+  return (fileHeader *)map;
+}
+
+DaReColumnStore::blockHeader *DaReColumnStore::getBlockHeader(uint32_t block) {
+  return (blockHeader *)&map[(size_t)block * DARE_COLUMN_BLOCK_SIZE];
+}
+
+uint32_t *DaReColumnStore::getFcntupColumn(uint32_t block) {
+  return (uint32_t *)&map[(size_t)block * DARE_COLUMN_BLOCK_SIZE + DARE_COLUMN_ALIGN];
+}
+
+/*
+ * take the next free block for a device, the file grows by DARE_COLUMN_GROW_BLOCKS blocks when it is full
+ * @return the block number, or 0 if the file cannot grow
+ */
+uint32_t DaReColumnStore::newBlock(uint32_t deviceId, device &dev) {
+  uint32_t block = getFileHeader()->blocksUsed;
+
+  if (block == blocksAllocated && !mapFile(blocksAllocated + DARE_COLUMN_GROW_BLOCKS)) {
+    return 0;
+  }
+  getBlockHeader(block)->magic = DARE_COLUMN_MAGIC;
+  getBlockHeader(block)->deviceId = deviceId;
+  getBlockHeader(block)->count = 0;
+  getFileHeader()->blocksUsed = block + 1;
+  dev.blocks.push_back(block);
+  return block;
+}
+
+/*
+ * write the batched records of a device to its blocks, column by column
+ * @return false if the file cannot grow, the records that were not written stay in the batch
+ */
+bool DaReColumnStore::writeBatch(uint32_t deviceId, device &dev) {
+  uint32_t written = 0, block, count, n;
+  uint32_t total = (uint32_t)dev.fcntup.size();
+  uint8_t *base;
+
+  while (written < total) {
+    block = dev.blocks.empty() ? 0 : dev.blocks.back();
+    if (block == 0 || getBlockHeader(block)->count == blockCapacity) {
+      block = newBlock(deviceId, dev);
+      if (block == 0) {
+        break;
+      }
+    }
+    count = getBlockHeader(block)->count;
+    n = std::min(total - written, blockCapacity - count);
+    base = &map[(size_t)block * DARE_COLUMN_BLOCK_SIZE];
+
+    memcpy(base + DARE_COLUMN_ALIGN + 4 * count, &dev.fcntup[written], 4 * n);
+    memcpy(base + offsetDelay + 4 * count, &dev.delay[written], 4 * n);
+    memcpy(base + offsetValue + dataPointSize * count, &dev.value[written * dataPointSize], dataPointSize * n);
+    memcpy(base + offsetPhase + count, &dev.phase[written], n);
+    memcpy(base + offsetLost + count, &dev.lost[written], n);
+
+    if (count == 0) {
+      getBlockHeader(block)->firstFcntup = dev.fcntup[written];
+    }
+    getBlockHeader(block)->lastFcntup = dev.fcntup[written + n - 1];
+    getBlockHeader(block)->count = count + n;
+    written += n;
+  }
+
+  dev.fcntup.erase(dev.fcntup.begin(), dev.fcntup.begin() + written);
+  dev.delay.erase(dev.delay.begin(), dev.delay.begin() + written);
+  dev.value.erase(dev.value.begin(), dev.value.begin() + (size_t)written * dataPointSize);
+  dev.phase.erase(dev.phase.begin(), dev.phase.begin() + written);
+  dev.lost.erase(dev.lost.begin(), dev.lost.begin() + written);
+  return written == total;
+}
+
+/*
+ * append a record for a device. Records are collected per device and written in batches of DARE_COLUMN_BATCH
+ * @param deviceId - the device, e.g. its DevAddr
+ * @param fcntup - the frame counter, increasing per device
+ * @param dataPoint - the value, NULL if the data point is lost
+ * @param phase - the recovery phase, 0 if lost
+ * @param delay - the decoding delay in frames
+ * @param lost - true if the data point could not be recovered
+ * @return false if a batch could not be written because the file cannot grow, the records are kept and written by a
+ * later append() or flush()
+ */
+bool DaReColumnStore::append(uint32_t deviceId, uint32_t fcntup, uint8_t *dataPoint, uint8_t phase, uint32_t delay, bool lost) {
+  device &dev = devices[deviceId];
+
+  dev.fcntup.push_back(fcntup);
+  dev.delay.push_back(delay);
+  if (dataPoint != NULL) {
+    dev.value.insert(dev.value.end(), dataPoint, dataPoint + dataPointSize);
+  } else {
+    dev.value.resize(dev.value.size() + dataPointSize, 0);
+  }
+  dev.phase.push_back(phase);
+  dev.lost.push_back(lost ? 1 : 0);
+
+  if (dev.fcntup.size() >= DARE_COLUMN_BATCH) {
+    return writeBatch(deviceId, dev);
+  }
+  return true;
+}
+
+/*
+ * write the batched records of all devices to the file
+ * @return false if the file cannot grow, the records that were not written stay in their batches
+ */
+bool DaReColumnStore::flush() {
+  std::map<uint32_t, device>::iterator it;
+  bool complete = true;
+  for (it = devices.begin(); it != devices.end(); ++it) {
+    if (!it->second.fcntup.empty()) {
+      complete &= writeBatch(it->first, it->second);
+    }
+  }
+  return complete;
+}
+
+/*
+ * find the records of a device within a range of frame counters, without copying them
+ * @param deviceId - the device
+ * @param fromFcntup - the first frame counter of the range
+ * @param toFcntup - the last frame counter of the range
+ * @param segments - filled with one view per block, valid until the next write to the store
+ * @return the number of records found
+ */
+uint32_t DaReColumnStore::scan(uint32_t deviceId, uint32_t fromFcntup, uint32_t toFcntup, std::vector<Columns> &segments) {
+  std::map<uint32_t, device>::iterator it = devices.find(deviceId);
+  std::vector<uint32_t>::iterator blockIt;
+  uint32_t found = 0, *fcntups, start, end;
+  uint8_t *base;
+  Columns columns;
+
+  segments.clear();
+  if (it == devices.end()) {
+    return 0;
+  }
+  device &dev = it->second;
+  if (!dev.fcntup.empty()) {
+    writeBatch(deviceId, dev);
+  }
+
+  // the first block that ends at or after the start of the range
+  blockIt = std::lower_bound(dev.blocks.begin(), dev.blocks.end(), fromFcntup, [this](uint32_t block, uint32_t fcntup) {
+    return getBlockHeader(block)->lastFcntup < fcntup;
+  });
+  for (; blockIt != dev.blocks.end() && getBlockHeader(*blockIt)->firstFcntup <= toFcntup; ++blockIt) {
+    fcntups = getFcntupColumn(*blockIt);
+    start = (uint32_t)(std::lower_bound(fcntups, fcntups + getBlockHeader(*blockIt)->count, fromFcntup) - fcntups);
+    end = (uint32_t)(std::upper_bound(fcntups, fcntups + getBlockHeader(*blockIt)->count, toFcntup) - fcntups);
+    if (start == end) {
+      continue;
+    }
+    base = &map[(size_t)*blockIt * DARE_COLUMN_BLOCK_SIZE];
+    columns.fcntup = fcntups + start;
+    columns.delay = (uint32_t *)(base + offsetDelay) + start;
+    columns.value = base + offsetValue + dataPointSize * start;
+    columns.phase = base + offsetPhase + start;
+    columns.lost = base + offsetLost + start;
+    columns.count = end - start;
+    segments.push_back(columns);
+    found += columns.count;
+  }
+  return found;
+}
+
+/*
+ * getter for the number of blocks in use, including the file header block
+ */
+uint32_t DaReColumnStore::getBlocksUsed() {
+  return (map == NULL) ? 0 : getFileHeader()->blocksUsed;
+}
+
+/*
+ * delivery callback for DaReDecode, appends every delivered data point to the store
+ * @param context - a DaReColumnStore::Device, naming the store and the device of the decoder
+ */
+void DaReColumnStore::onDelivery(void *context, uint32_t fcntup, uint8_t *dataPoint, bool received, uint8_t phase, uint32_t delay) {
+  Device *dev = (Device *)context;
+  dev->store->append(dev->deviceId, fcntup, dataPoint, phase, delay, !received);
+}
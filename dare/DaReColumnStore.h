@@ -0,0 +1,103 @@
+/*
+ / _____)             _              | |
+( (____  _____ ____ _| |_ _____  ____| |__
+ \____ \| ___ |    (_   _) ___ |/ ___)  _ \
+ _____) ) ____| | | || |_| ____( (___| | | |
+(______/|_____)_|_|_| \__)_____)\____)_| |_|
+    (C)2017 Semtech
+	
+Description: Memory-mapped columnar file storing the recovered data points of many devices
+License: Revised BSD License, see LICENSE file included in the project
+By: Paul Marcelis
+*/
+#include <map>
+#include <vector>
+#include "DaRe.h"
+
+#ifndef __DARE_COLUMN_STORE_H
+#define __DARE_COLUMN_STORE_H
+
+#define DARE_COLUMN_BLOCK_SIZE 65536 // bytes per block, a multiple of the page size and of the Windows allocation granularity
+#define DARE_COLUMN_GROW_BLOCKS 16 // number of blocks the file grows with at once
+#define DARE_COLUMN_BATCH 64 // number of records collected per device before they are written to the file
+#define DARE_COLUMN_ALIGN 64 // alignment of the columns within a block
+#define DARE_COLUMN_MAGIC 0x65526144 // "DaRe"
+
+/*
+ * The file consists of blocks of DARE_COLUMN_BLOCK_SIZE bytes. Block 0 holds the file header, every other block holds
+ * consecutive records of one device, stored as columns: frame counter, delay, value, recovery phase and lost flag.
+ * Records of a device have to be appended in frame counter order, as the decoder delivers them
+ */
+class DaReColumnStore {
+public:
+  // zero-copy view of consecutive records of one device, only valid until the next write to the store
+  struct Columns {
+    const uint32_t *fcntup;
+    const uint32_t *delay;
+    const uint8_t *value; // dataPointSize bytes per record
+    const uint8_t *phase;
+    const uint8_t *lost;
+    uint32_t count;
+  };
+  // delivery callback context for the decoder of one device
+  struct Device {
+    DaReColumnStore *store;
+    uint32_t deviceId;
+  };
+
+private:
+  struct fileHeader {
+    uint32_t magic;
+    uint32_t blockSize;
+    uint32_t blocksUsed;
+    uint8_t dataPointSize;
+  };
+  struct blockHeader {
+    uint32_t magic;
+    uint32_t deviceId;
+    uint32_t firstFcntup;
+    uint32_t lastFcntup;
+    uint32_t count;
+  };
+  struct device {
+    std::vector<uint32_t> blocks; // block numbers in frame counter order
+    std::vector<uint32_t> fcntup; // records not yet written to the file
+    std::vector<uint32_t> delay;
+    std::vector<uint8_t> value;
+    std::vector<uint8_t> phase;
+    std::vector<uint8_t> lost;
+  };
+
+  uint8_t dataPointSize;
+  uint32_t blockCapacity; // records per block
+  uint32_t offsetDelay, offsetValue, offsetPhase, offsetLost; // column offsets within a block, the frame counters start at DARE_COLUMN_ALIGN
+  uint32_t blocksAllocated = 0;
+  uint8_t *map = NULL;
+#ifdef _WIN32
+  void *file = NULL;
+  void *mapping = NULL;
+#else
+  int file = -1;
+#endif
+  std::map<uint32_t, device> devices;
+
+  void setLayout();
+  bool mapFile(uint32_t blocks);
+  void unmapFile();
+  fileHeader *getFileHeader();
+  blockHeader *getBlockHeader(uint32_t block);
+  uint32_t *getFcntupColumn(uint32_t block);
+  uint32_t newBlock(uint32_t deviceId, device &dev);
+  bool writeBatch(uint32_t deviceId, device &dev);
+
+public:
+  bool init(const char *path, uint8_t dataPointSizeIn);
+  void destroy();
+  bool append(uint32_t deviceId, uint32_t fcntup, uint8_t *dataPoint, uint8_t phase, uint32_t delay, bool lost);
+  bool flush();
+  uint32_t scan(uint32_t deviceId, uint32_t fromFcntup, uint32_t toFcntup, std::vector<Columns> &segments);
+  uint32_t getBlocksUsed();
+  static void onDelivery(void *context, uint32_t fcntup, uint8_t *dataPoint, bool received, uint8_t phase, uint32_t delay);
+};
+
+#endif
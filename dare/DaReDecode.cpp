@@ -10,50 +10,392 @@ Description: Decoding functions
 License: Revised BSD License, see LICENSE file included in the project
 By: Paul Marcelis
 */
+#include <algorithm>
 #include "DaReDecode.h"
 
 /*
  * initialise a DaRe decoder. 
  * @param dataPointSizeIn - the size in bytes of the data points that will be transmitted. should be constant during runtime. zero padding is possible to keep the size constant, then maximum data point size should be used here
- * @param simulationLength - required to allocate sufficient memory for results
+ * @param simulationLength - required to allocate sufficient memory for results, in readings when frames carry more than one
  */
 void DaReDecode::init(uint8_t dataPointSizeIn, uint32_t simulationLength) {
   dataPointSize = dataPointSizeIn;
   totalDataPoints = simulationLength;
   dataPointsReceived = new uint8_t[simulationLength * dataPointSize]();
   dataPointsDelay = new uint32_t[simulationLength * dataPointSize]();
+  dataPointsPhase = new uint8_t[simulationLength]();
   isDataPointReceived = new bool[simulationLength]();
-#if DEBUG >= 0
-  dataPointsDebug = new uint8_t[simulationLength * dataPointSize]();
-#endif
+  snapshot.init(dataPointSize);
 }
 
 /*
  * destroy the DaRe decoder
  */
 void DaReDecode::destroy() {
-  free(dataPointsReceived);
-  free(isDataPointReceived);
+  buffers.destroy();
+  if (memoryBudget != NULL) {
+    memoryBudget->detach(budgetAccount);
+    memoryBudget = NULL;
+  }
+  snapshot.destroy();
+  delete[] dataPointsReceived;
+  delete[] dataPointsDelay;
+  delete[] dataPointsPhase;
+  delete[] isDataPointReceived;
 }
 
 /*
  * helper function to clear all buffers from intermediate decoded data
  */
 void DaReDecode::flushBuffers() {
+  if (!frameLog.empty()) {
+    replayParityLog();
+  }
+  runElimination(0);
   checkBuffersForSubmatrix(true, totalDataPoints);
+  deliverInOrder(true);
 }
 
-#if DEBUG >= 0
 /*
- * store the known value for a certain data point for later correctness comparison of the decoded value
+ * in deferred mode decode() only stores the data point and recovers directly from the parity checks (stage 1 and 2),
+ * the iterative decoding and Gaussian elimination (stage 3 and 4) are left to runElimination()
  */
-void DaReDecode::debugData(uint32_t fcntup, uint8_t *dataPoint) {
-  uint8_t i;
-  for (i = 0; i < dataPointSize; i++) {
-    dataPointsDebug[(fcntup - 1) * dataPointSize + i] = dataPoint[i];
+void DaReDecode::setDeferredElimination(bool deferred) {
+  deferredElimination = deferred;
+}
+
+/*
+ * set the coding strategy of the device of this decoder. The strategy is not in the payload, so it has to be
+ * configured per session, before the first frame
+ */
+void DaReDecode::setStrategy(DaRe::S_VALUE strategyIn) {
+  strategy = strategyIn;
+}
+
+/*
+ * in lazy mode decode() only stores the data point and logs the parity checks of the frame. The recovery runs on the
+ * log when query() asks for a data point that is missing, or just before a missing data point would be doomed
+ */
+void DaReDecode::setLazyRecovery(bool lazy) {
+  lazyRecovery = lazy;
+}
+
+/*
+ * getter for the number of frames of which the parity checks are in the log of the lazy mode
+ */
+uint32_t DaReDecode::getLoggedFrames() {
+  return (uint32_t)frameLog.size();
+}
+
+/*
+ * Make sure all data points in a range of frames are recovered as far as possible, in lazy mode this replays the log.
+ * Read the data points with isReceived() and getDataPoint() afterwards
+ * @param fromFcntup - first frame counter of the range
+ * @param toFcntup - last frame counter of the range
+ * @return true if all data points in the range are received or decoded
+ */
+bool DaReDecode::query(uint32_t fromFcntup, uint32_t toFcntup) {
+  uint32_t fcntup;
+  bool complete = true;
+
+  toFcntup = (toFcntup > lastFcntup) ? lastFcntup : toFcntup;
+  for (fcntup = fromFcntup; fcntup <= toFcntup && complete; fcntup++) {
+    complete = isDataPointReceived[fcntup - 1];
+  }
+  if (complete || frameLog.empty()) {
+    return complete;
+  }
+
+  replayParityLog();
+  for (fcntup = fromFcntup; fcntup <= toFcntup; fcntup++) {
+    if (!isDataPointReceived[fcntup - 1]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/*
+ * move the oldest missing data point up to the first data point that is not received, decoded or doomed. It only moves
+ * forward, so keeping it up to date costs amortized constant time per frame
+ */
+void DaReDecode::updateOldestMissing() {
+  while (oldestMissing < lastFcntup && (isDataPointReceived[oldestMissing] || (lastFcntup - 1) - oldestMissing > DARE_MAX_W)) {
+    oldestMissing++;
   }
 }
+
+/*
+ * whether a data point is missing that can still be recovered, by the buffers or by the parity checks of later frames.
+ * Data points that are doomed do not count, they are lost for good
+ */
+bool DaReDecode::isRecoveryOutstanding() {
+  updateOldestMissing();
+  return oldestMissing < lastFcntup;
+}
+
+/*
+ * whether all data points in the window of a frame are known, then its parity checks cannot recover anything
+ */
+bool DaReDecode::isWindowComplete(uint32_t fcntup, uint8_t W) {
+  uint32_t dataPointOffset, windowSize = DaRe::getWindowSize(W, fcntup);
+  for (dataPointOffset = 1; dataPointOffset <= windowSize; dataPointOffset++) {
+    if (!isDataPointReceived[(fcntup - 1) - dataPointOffset]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/*
+ * append the parity checks of a frame to the log of the lazy mode
+ * @param parityChecks - the R - 1 parity checks in the payload of the frame
+ * @param fcntup, W, R, D, enumF - see interpretParityChecks()
+ */
+void DaReDecode::logParityChecks(const uint8_t *parityChecks, uint32_t fcntup, uint8_t W, uint8_t R, uint8_t D, DaRe::F_VALUE enumF) {
+  LoggedFrame frame;
+  frame.fcntup = fcntup;
+  frame.W = W;
+  frame.R = R;
+  frame.D = D;
+  frame.enumF = enumF;
+  frame.parityOffset = (uint32_t)parityLog.size();
+  frameLog.push_back(frame);
+  parityLog.insert(parityLog.end(), parityChecks, parityChecks + dataPointSize * (R - 1));
+}
+
+/*
+ * Run the recovery of the lazy mode: stage 2 for all logged frames, then the elimination once for all of them. With the
+ * data points of the later frames already known the parity checks reduce further than they would have one by one.
+ * The decoding delay of the recovered data points counts up to the newest frame
+ */
+void DaReDecode::replayParityLog() {
+  size_t frame_i;
+
+#if DEBUG >= 2
+  std::cout << "Replay " << frameLog.size() << " logged frames." << std::endl;
 #endif
+  if (buffers.inUse() > 0) {
+    discardDoomedBuffers(lastFcntup);
+  }
+  for (frame_i = 0; frame_i < frameLog.size(); frame_i++) {
+    LoggedFrame &frame = frameLog[frame_i];
+    if (isWindowComplete(frame.fcntup, frame.W)) {
+      continue; // skip generating the generator lines of parity checks that have nothing left to recover
+    }
+    recoverFromParityChecks(&parityLog[frame.parityOffset], frame.fcntup, frame.W, frame.R, frame.D, frame.enumF);
+  }
+  frameLog.clear();
+  parityLog.clear();
+
+  // data points stored since the last replay can be in the buffers as well, so always iterate
+  if (deferredElimination) {
+    eliminationPending = true;
+    eliminationFcntup = lastFcntup;
+  } else {
+    iterateBuffers(lastFcntup, NULL);
+    checkBuffersForSubmatrix(false, lastFcntup);
+  }
+  updateOldestMissing();
+  deliverInOrder(false);
+}
+
+/*
+ * whether decode() left an elimination to be run with runElimination()
+ */
+bool DaReDecode::hasPendingElimination() {
+  return eliminationPending;
+}
+
+/*
+ * set a callback that receives all data points in frame counter order, pass NULL to disable
+ */
+void DaReDecode::setDeliveryCallback(DeliveryCallback callback, void *context) {
+  deliveryCallback = callback;
+  deliveryContext = context;
+}
+
+/*
+ * whether a parity check in one of the buffers still includes a certain data point
+ */
+bool DaReDecode::isReferencedByBuffer(uint32_t dataPointId) {
+  uint32_t bufferI, dataPointOffset;
+  for (bufferI = 0; bufferI < buffers.size(); bufferI++) {
+    if (!buffers[bufferI].inUse || dataPointId + 1 >= buffers[bufferI].fcntup) {
+      continue;
+    }
+    dataPointOffset = (buffers[bufferI].fcntup - 1) - dataPointId;
+    if (dataPointOffset <= buffers[bufferI].windowSize && buffers[bufferI].generatorLine[dataPointOffset - 1] == 1) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/*
+ * pass data points to the delivery callback in frame counter order. A missing data point holds back the ones after it
+ * until it is decoded, or until it is too old to be included in a future parity check and no buffer includes it anymore
+ * @param flush - deliver all remaining data points, also the missing ones
+ */
+void DaReDecode::deliverInOrder(bool flush) {
+  uint32_t oldestDataPointStillReceivable = ((lastFcntup - 1) > DARE_MAX_W) ? ((lastFcntup - 1) - DARE_MAX_W) : 0;
+
+  if (deliveryCallback == NULL) {
+    return;
+  }
+  while (lastDelivered < lastFcntup) {
+    if (isDataPointReceived[lastDelivered]) {
+      deliveryCallback(deliveryContext, lastDelivered + 1, &dataPointsReceived[lastDelivered * dataPointSize], true, dataPointsPhase[lastDelivered], dataPointsDelay[lastDelivered]);
+    } else if (flush || (lastDelivered < oldestDataPointStillReceivable && !eliminationPending && !isReferencedByBuffer(lastDelivered))) {
+      deliveryCallback(deliveryContext, lastDelivered + 1, NULL, false, 0, 0);
+    } else {
+      break;
+    }
+    lastDelivered++;
+  }
+}
+
+/*
+ * attach a verifier that compares every decoded data point with the ground truth. Pass NULL to detach
+ */
+void DaReDecode::setVerifier(DaReVerifier *verifierIn) {
+  verifier = verifierIn;
+}
+
+/*
+ * share a cache of decode plans with other decoders, see DaRePlanCache. The frames with a known loss pattern in their
+ * window then skip the generator lines and the buffers. Pass NULL to decode without plans
+ */
+void DaReDecode::setPlanCache(DaRePlanCache *planCacheIn) {
+  planCache = planCacheIn;
+}
+
+/*
+ * charge the parity checks in the buffers of this decoder to a memory budget shared with other decoders, which evicts
+ * the parity checks with the lowest expected recovery value of all decoders when they take too much memory together,
+ * see DaReMemoryBudget. Pass NULL to leave the budget
+ * @param budget - the budget
+ * @param priority - weight of the parity checks of this device against those of others, 1 for a normal device
+ */
+void DaReDecode::setMemoryBudget(DaReMemoryBudget *budget, double priority) {
+  if (memoryBudget != NULL) {
+    buffers.setBudget(NULL, 0, 0);
+    memoryBudget->detach(budgetAccount);
+  }
+  memoryBudget = budget;
+  if (memoryBudget != NULL) {
+    budgetAccount = memoryBudget->attach(this, priority);
+    buffers.setBudget(memoryBudget, budgetAccount, sizeof(DaReBufferPool::buffer) + dataPointSize + DARE_MAX_W);
+  }
+}
+
+/*
+ * Expected recovery value of a buffered parity check: the part of the DARE_MAX_W frames left before its oldest data
+ * point is doomed, divided by the number of other equations it needs before it recovers a data point. Parity checks
+ * that will soon be discarded anyway, or that miss many data points, are worth the least
+ */
+double DaReDecode::recoveryValue(uint32_t bufferI) {
+  uint32_t offset, unknowns = 0, oldestOffset = 0, newest = (lastFcntup > 0) ? lastFcntup - 1 : 0;
+  int64_t framesLeft;
+
+  for (offset = 1; offset <= buffers[bufferI].windowSize; offset++) {
+    if (buffers[bufferI].generatorLine[offset - 1] == 1) {
+      unknowns++;
+      oldestOffset = offset;
+    }
+  }
+  if (unknowns < 2) {
+    return 0;
+  }
+  framesLeft = (int64_t)((buffers[bufferI].fcntup - 1) - oldestOffset) + DARE_MAX_W - newest;
+  if (framesLeft <= 0) {
+    return 0;
+  }
+  return (double)framesLeft / DARE_MAX_W / (unknowns - 1);
+}
+
+/*
+ * the lowest recovery value of the parity checks in the buffers, see recoveryValue(). Used by DaReMemoryBudget
+ */
+double DaReDecode::leastRecoveryValue() {
+  uint32_t bufferI;
+  double value, lowest = -1;
+  for (bufferI = 0; bufferI < buffers.size(); bufferI++) {
+    if (buffers[bufferI].inUse) {
+      value = recoveryValue(bufferI);
+      if (lowest < 0 || value < lowest) {
+        lowest = value;
+      }
+    }
+  }
+  return (lowest < 0) ? 0 : lowest;
+}
+
+/*
+ * release the buffer with the lowest recovery value. Used by DaReMemoryBudget
+ */
+void DaReDecode::evictLeastValuable() {
+  uint32_t bufferI, victim = 0;
+  double value, lowest = -1;
+  for (bufferI = 0; bufferI < buffers.size(); bufferI++) {
+    if (buffers[bufferI].inUse) {
+      value = recoveryValue(bufferI);
+      if (lowest < 0 || value < lowest) {
+        lowest = value;
+        victim = bufferI;
+      }
+    }
+  }
+  if (lowest >= 0) {
+    clearBuffer(victim);
+  }
+}
+
+/*
+ * bytes in use by this decoder, the object itself included. The arrays grow with the simulation length, see
+ * DaReSession for a decoder state of constant size
+ */
+size_t DaReDecode::memoryUsage() {
+  return sizeof(DaReDecode) + (size_t)totalDataPoints * (dataPointSize * (1 + sizeof(uint32_t)) + 2)
+    + buffers.memoryUsage(dataPointSize) + frameLog.capacity() * sizeof(LoggedFrame) + parityLog.capacity()
+    + scratch.capacity() + planValue.capacity() + snapshot.memoryUsage();
+}
+
+/*
+ * getter for the window of the newest data points, which other threads can read while the decoder runs. The other
+ * getters are only safe on the thread that calls decode()
+ */
+DaReSnapshot *DaReDecode::getSnapshot() {
+  return &snapshot;
+}
+
+/*
+ * whether the data point of a certain frame is received or decoded
+ */
+bool DaReDecode::isReceived(uint32_t fcntup) {
+  return isDataPointReceived[fcntup - 1];
+}
+
+/*
+ * getter for the received or decoded value of the data point of a certain frame
+ */
+uint8_t *DaReDecode::getDataPoint(uint32_t fcntup) {
+  return &dataPointsReceived[(fcntup - 1) * dataPointSize];
+}
+
+/*
+ * getter for the decoding delay (in frames) of the data point of a certain frame
+ */
+uint32_t DaReDecode::getDelay(uint32_t fcntup) {
+  return dataPointsDelay[fcntup - 1];
+}
+
+/*
+ * getter for the recovery phase of the data point of a certain frame, 1 if received and 0 if not (yet) decoded
+ */
+uint8_t DaReDecode::getPhase(uint32_t fcntup) {
+  return dataPointsPhase[fcntup - 1];
+}
 
 /*
  * store the decoded value at a certain position
@@ -62,26 +404,24 @@ void DaReDecode::debugData(uint32_t fcntup, uint8_t *dataPoint) {
  * @param currentFcntup - frame counter value of the current received frame, to compute the decoding delay for this data point
  * @param phase - the phase at which the data point was decoded, for statistics purposes
  */
-void DaReDecode::storeDataPoint(uint32_t fcntup, uint8_t *dataPoint, uint32_t currentFcntup, int phase) {
+void DaReDecode::storeDataPoint(uint32_t fcntup, const uint8_t *dataPoint, uint32_t currentFcntup, int phase) {
   uint8_t i;
-  bool wrong = false; //to verify the decoded value
   for (i = 0; i < dataPointSize; i++) {
     dataPointsReceived[(fcntup - 1) * dataPointSize + i] = dataPoint[i];
-    if (dataPoint[i] != dataPointsDebug[(fcntup - 1) * dataPointSize + i]) {
-      wrong = true;
-#if DEBUG >= 0
-      std::printf("FOUT! d[%d_%d](%d) = %02x != %02x. ", (fcntup-1), i, phase, dataPoint[i], dataPointsDebug[(fcntup - 1) * dataPointSize + i]);
-#endif
-    }
   }
 
-  if (!wrong) {
-    dataPointsDelay[fcntup - 1] = currentFcntup - fcntup;
-    isDataPointReceived[fcntup - 1] = true;
-    recovered += 1;
-    recoverPhase[phase-1] += 1;
+  // the verifier only reports wrongly decoded values, the decoder does not depend on the ground truth
+  if (verifier != NULL) {
+    verifier->verify(fcntup, dataPoint, phase);
   }
 
+  dataPointsDelay[fcntup - 1] = currentFcntup - fcntup;
+  dataPointsPhase[fcntup - 1] = (uint8_t)phase;
+  isDataPointReceived[fcntup - 1] = true;
+  recovered += 1;
+  recoverPhase[phase-1] += 1;
+  snapshot.publish(fcntup, dataPoint, (uint8_t)phase, dataPointsDelay[fcntup - 1]);
+
 #if DEBUG >= 1
   std::cout << "++ Received d[" << (fcntup - 1) << "]: ";
   displayCharArray(&dataPointsReceived[(fcntup - 1)*dataPointSize], dataPointSize, 1, ' ');
@@ -90,46 +430,171 @@ void DaReDecode::storeDataPoint(uint32_t fcntup, uint8_t *dataPoint, uint32_t cu
 }
 
 /*
- * clear the intermediate decoded value from a certain buffer. freeing memory does not work (yet)
+ * clear the intermediate decoded value from a certain buffer
  */
 void DaReDecode::clearBuffer(uint32_t bufferI) {
-  //free(buffers[bufferI].parityCheck);
-  //free(buffers[bufferI].generatorLine);
-  buffers[bufferI].inUse = false;
+  buffers.release(bufferI);
 }
 
 /*
- * Main function to decode the payload from a certain frame
- * @param payload - the payload from the frame to be decoded
+ * clear the buffers with a parity check of which the oldest data point cannot be included in a to be received parity check anymore,
+ * so that only parity checks that can still pay off take part in the decoding
+ * @param fcntup - frame counter of current frame
+ */
+void DaReDecode::discardDoomedBuffers(uint32_t fcntup) {
+  uint32_t oldestDataPointStillReceivable = ((fcntup - 1) > DARE_MAX_W) ? ((fcntup - 1) - DARE_MAX_W) : 0;
+  uint32_t bufferI, dataPointOffset;
+
+  for (bufferI = 0; bufferI < buffers.size(); bufferI++) {
+    // the oldest data point a buffer can include is windowSize before its frame, skip the buffers that are recent enough
+    if (!buffers[bufferI].inUse || (buffers[bufferI].fcntup - 1) - buffers[bufferI].windowSize >= oldestDataPointStillReceivable) {
+      continue;
+    }
+    for (dataPointOffset = buffers[bufferI].windowSize; dataPointOffset >= 1; dataPointOffset--) {
+      if (buffers[bufferI].generatorLine[dataPointOffset - 1] == 1) {
+        break;
+      }
+    }
+    if (dataPointOffset == 0 || (buffers[bufferI].fcntup - 1) - dataPointOffset < oldestDataPointStillReceivable) {
+#if DEBUG >= 1
+      std::cout << "-- d[" << (buffers[bufferI].fcntup - 1) - dataPointOffset << "] is forever lost!" << std::endl;
+#endif
+      clearBuffer(bufferI);
+    }
+  }
+}
+
+/*
+ * getter for the number of parity checks that were dropped because all buffers were in use
+ */
+uint32_t DaReDecode::getBufferEvictions() {
+  return buffers.getEvictions();
+}
+
+/*
+ * getter for the number of frames decodeBatch() dropped because they were shorter than their header announces
+ */
+uint32_t DaReDecode::getMalformedFrames() {
+  return malformedFrames;
+}
+
+/*
+ * getter for the number of data points that were dropped because their counter is 0 or beyond the length given to init()
+ */
+uint32_t DaReDecode::getOutOfRangeReadings() {
+  return outOfRangeReadings;
+}
+
+/*
+ * getter for the number of parity checks that were stored in a buffer
+ */
+uint32_t DaReDecode::getBufferAllocations() {
+  return buffers.getAllocations();
+}
+
+/*
+ * Main function to decode the payload from a certain frame. Frames are expected in frame counter order, a late frame is
+ * still used but can come too late to help decoding. Use DaReReorder to put frames from parallel pipelines in order.
+ * A frame with k readings (see DaReEncode::setK()) is decoded per reading, so the data points, the delays and the
+ * counters passed to the delivery callback are in readings: reading i of frame fcntup is (fcntup - 1) * k + i + 1.
+ * Readings with a counter beyond the length given to init() are dropped and counted in getOutOfRangeReadings()
+ * @param payload - the payload from the frame to be decoded, it is not modified
  * @param fcntup - the frame counter
  */
 void DaReDecode::decode(DaRe::Payload payload, uint32_t fcntup) {
-  uint8_t windowSize, W, R, dataPointOffset;
-  uint32_t dataPointOffsetPointer;
-  bool *generatorLine;
+  decodeFrame(payload.payload, fcntup);
+  deliverInOrder(false);
+}
+
+/*
+ * Decode a batch of frames of this session, for example all frames of one uplink message from the network server. The
+ * payloads are only read, they can point straight into the receive buffer. The elimination still runs frame by frame,
+ * so the decoded data points are the same as with decode(), but the data points are delivered once for the whole batch.
+ * A frame shorter than its header announces would make the decoder read past its span, it is dropped and counted in
+ * getMalformedFrames()
+ * @param frames - the frames in frame counter order
+ * @param count - the number of frames
+ */
+void DaReDecode::decodeBatch(const Frame *frames, size_t count) {
+  size_t frame_i;
+  for (frame_i = 0; frame_i < count; frame_i++) {
+    if (!DaRe::isPayloadComplete(frames[frame_i].payload, frames[frame_i].payloadSize, dataPointSize)) {
+      malformedFrames++;
+      continue;
+    }
+    decodeFrame(frames[frame_i].payload, frames[frame_i].fcntup);
+  }
+  deliverInOrder(false);
+}
+
+/*
+ * Decode one frame without delivering the data points, see decode()
+ * @param payload - the payload from the frame to be decoded, it is not modified
+ * @param fcntup - the frame counter
+ */
+void DaReDecode::decodeFrame(const uint8_t *payload, uint32_t fcntup) {
+  uint8_t W, R, headerSize, table, k, reading_i;
   bool previousDataRecovered = false;
-  uint8_t R_i, dataPoint_i;
-  int bufferI;
 
-  // get coding paramter values, code rate R and window size W from the first byte in the payload
-  DaRe::R_VALUE enumR = (DaRe::R_VALUE) (payload.payload[0] >> 4);
-  DaRe::W_VALUE enumW = (DaRe::W_VALUE) (payload.payload[0] & 0xf);
+  // a frame with k readings is decoded as k frames of one reading each, the code is over the readings
+  k = DaRe::getK(payload);
+  if (fcntup == 0 || ((uint64_t)fcntup - 1) * k >= totalDataPoints) {
+    outOfRangeReadings += k; // also keeps (fcntup - 1) * k from wrapping around
+    return;
+  }
+  if (k > 1) {
+    uint8_t reading[256];
+    for (reading_i = 0; reading_i < k; reading_i++) {
+      DaRe::getReading(reading, payload, reading_i, dataPointSize);
+      decodeFrame(reading, (fcntup - 1) * k + reading_i + 1);
+    }
+    return;
+  }
+
+  // get coding paramter values, field F, code rate R and window size W from the first byte in the payload
+  DaRe::F_VALUE enumF = (DaRe::F_VALUE) (payload[0] >> DARE_HEADER_F_SHIFT);
+  bool extension = (payload[0] >> DARE_HEADER_X_SHIFT) & 1;
+  DaRe::R_VALUE enumR = (DaRe::R_VALUE) ((payload[0] >> DARE_HEADER_R_SHIFT) & DARE_HEADER_R_MASK);
+  DaRe::W_VALUE enumW = (DaRe::W_VALUE) (payload[0] & DARE_HEADER_W_MASK);
   W = DaRe::getW(enumW);
   R = DaRe::getR(enumR);
+  // an extension byte selects the degree table of the parity checks
+  headerSize = extension ? 2 : 1;
+  table = extension ? (payload[1] & DARE_EXTENSION_TABLE_MASK) : 0;
+  // in lazy mode the pool also has room for the parity checks of a log that covers the whole doom horizon
+  buffers.resize(DaReBufferPool::getPoolSize(R, W) + (lazyRecovery ? (R - 1) * (DARE_MAX_W + 1) : 0));
 
 
+  // in lazy mode, the log has to be replayed before this frame dooms the oldest missing data point
+  if (lazyRecovery && !frameLog.empty() && fcntup > lastFcntup && (fcntup - 1) - oldestMissing > DARE_MAX_W) {
+    replayParityLog();
+  }
+
   //** STAGE 1 DATA RECOVERY | NORMAL RECOVERY **//
-  // store the current data point from the payload
-  storeDataPoint(fcntup, &payload.payload[1], fcntup, 1);
+  if (fcntup <= lastFcntup) {
+    // a late frame, older than the newest frame. Its data point is only new if it was not decoded in the meantime,
+    // the delay is counted up to the newest frame
+    if (!isDataPointReceived[fcntup - 1]) {
+      storeDataPoint(fcntup, &payload[headerSize], lastFcntup, 1);
+      previousDataRecovered = true; // the late data point can make buffered parity checks solvable
+      tryToRecover = true;
+    }
+#if DEBUG >= 2
+    std::cout << "!!! Late frame " << fcntup << " after frame " << lastFcntup << std::endl;
+#endif
+  } else {
+    // store the current data point from the payload
+    storeDataPoint(fcntup, &payload[headerSize], fcntup, 1);
 
-  // Check if a previous frame was not received...
-  if (lastFcntup < (fcntup - 1)) {
-    tryToRecover = true; //if so, try to recover
+    // Check if a previous frame was not received...
+    if (lastFcntup < (fcntup - 1)) {
+      tryToRecover = true; //if so, try to recover
 #if DEBUG >= 2
-    std::cout << "!!! There is something missing!" << std::endl;
+      std::cout << "!!! There is something missing!" << std::endl;
 #endif
+    }
+    lastFcntup = fcntup;
   }
-  lastFcntup = fcntup;
 
   // If there is something missing, let's get checking..
   if (tryToRecover) {
@@ -137,195 +602,393 @@ void DaReDecode::decode(DaRe::Payload payload, uint32_t fcntup) {
     std::cout << "Interpret parity check." << std::endl;
 #endif
 
-    windowSize = DaRe::getWindowSize(W, fcntup);
-    // the code rate indicates the number of parity checks included in the frame payload for R = 2, one parity check is included, for R = 3, two parity checks, etc.
+    // The parity checks of a frame with an unknown degree table cannot be interpreted, only its data point is used
+    bool parityChecksKnown = (strategy == DaRe::S_REPETITION) || DaRe::hasDegreeTable(table);
+#if DEBUG >= 1
+    if (!parityChecksKnown) {
+      std::cout << "!!! Unknown degree table " << (int)table << std::endl;
+    }
+#endif
+
+    if (lazyRecovery) {
+      // lazy mode: only log the parity checks, as long as there is a missing data point they can help to recover
+      updateOldestMissing();
+      if (oldestMissing >= lastFcntup) {
+        frameLog.clear();
+        parityLog.clear();
+      } else if (parityChecksKnown && !isWindowComplete(fcntup, W)) {
+        logParityChecks(&payload[headerSize + dataPointSize], fcntup, W, R, DaRe::getDegree(table, enumW), enumF);
+        // replay before the logged parity checks could outnumber the free buffers, the pool would evict them
+        if (buffers.inUse() + frameLog.size() * (R - 1) >= buffers.size()) {
+          replayParityLog();
+        }
+      }
+    } else {
+      if (buffers.inUse() > 0) {
+        discardDoomedBuffers(lastFcntup);
+      }
+
+      // stage 2 with the generator lines of the strategy of this session
+      if (parityChecksKnown) {
+        // the parity checks are reduced in place, so they are copied to the scratch buffer first
+        scratch.assign(&payload[headerSize + dataPointSize], &payload[headerSize + dataPointSize * R]);
+        previousDataRecovered |= recoverFromParityChecks(scratch.data(), fcntup, W, R, DaRe::getDegree(table, enumW), enumF);
+      }
+
+      // in deferred mode, only stage 1 and stage 2 are done inline, the elimination is left to runElimination()
+      if (deferredElimination) {
+        eliminationPending = true;
+        eliminationFcntup = lastFcntup;
+      } else {
+        if (previousDataRecovered) {
+          iterateBuffers(lastFcntup, NULL);
+        }
+        // finally, try to find more data points in all buffers
+        checkBuffersForSubmatrix(false, lastFcntup);
+      }
+    }
+  }
+
+  // reset the try to recover flag if all previous data points are recovered or doomed, a permanently lost data point
+  // should not keep the session out of the fast path
+  if (tryToRecover && !eliminationPending && !isRecoveryOutstanding()) {
+#if DEBUG >= 2
+    std::cout << "--------- We are complete!" << std::endl;
+#endif
+    tryToRecover = false;
+    frameLog.clear();
+    parityLog.clear();
+  }
+
+  // the parity checks of this frame can push the decoders of a shared budget over it
+  if (memoryBudget != NULL) {
+    memoryBudget->enforce();
+  }
+}
+
+/*
+ * Stage 2 of the decoding with the generator lines of the strategy of this session
+ * @return true if a data point is recovered
+ */
+bool DaReDecode::recoverFromParityChecks(uint8_t *parityChecks, uint32_t fcntup, uint8_t W, uint8_t R, uint8_t D, DaRe::F_VALUE enumF) {
+  // plans are XOR schedules, so only for GF(2), and only for a full window
+  if (planCache != NULL && enumF == DaRe::F_GF2 && (fcntup - 1) >= W) {
+    int planned = recoverFromPlan(parityChecks, fcntup, W, R, (strategy == DaRe::S_REPETITION) ? 1 : D);
+    if (planned >= 0) {
+      return planned > 0;
+    }
+  }
+  switch (strategy) {
+  case DaRe::S_REPETITION:
+    return interpretParityChecks<RepetitionStrategy>(parityChecks, fcntup, W, R, 1, enumF);
+  default:
+    return interpretParityChecks<DaReStrategy>(parityChecks, fcntup, W, R, D, enumF);
+  }
+}
+
+/*
+ * Stage 2 of the decoding with a plan from the cache: if the parity checks of the frame can recover every missing data
+ * point in its window, they are recovered straight from the parity checks and the known data points
+ * @return the number of data points recovered, or -1 if there is no complete plan and the general decoding is needed
+ */
+int DaReDecode::recoverFromPlan(const uint8_t *parityChecks, uint32_t fcntup, uint8_t W, uint8_t R, uint8_t D) {
+  uint64_t lossBitmap = 0;
+  uint32_t missing = 0, offset, step_i, known_i;
+  uint8_t R_i, dataPoint_i;
+  const uint8_t *source;
+
+  for (offset = 1; offset <= W; offset++) {
+    if (!isDataPointReceived[(fcntup - 1) - offset]) {
+      lossBitmap |= 1ULL << (offset - 1);
+      // R - 1 parity checks cannot recover more data points than that
+      if (++missing > (uint32_t)(R - 1)) {
+        return -1;
+      }
+    }
+  }
+  if (missing == 0) {
+    return 0;
+  }
+
+  const DaRePlanCache::Plan *plan = planCache->getPlan(strategy, W, fcntup, R, D, lossBitmap);
+  if (plan == NULL || !plan->complete) {
+    return -1;
+  }
+  planValue.resize(dataPointSize);
+  for (step_i = 0; step_i < plan->steps.size(); step_i++) {
+    const DaRePlanCache::Step &step = plan->steps[step_i];
+    std::fill(planValue.begin(), planValue.end(), 0);
     for (R_i = 0; R_i < R - 1; R_i++) {
-      generatorLine = DaRe::prlg(W, fcntup, R_i); // recalculate the generator line for this parity check
+      if ((step.parityMask >> R_i) & 1) {
+        for (dataPoint_i = 0; dataPoint_i < dataPointSize; dataPoint_i++) {
+          planValue[dataPoint_i] ^= parityChecks[dataPointSize * R_i + dataPoint_i];
+        }
+      }
+    }
+    for (known_i = 0; known_i < step.known.size(); known_i++) {
+      source = &dataPointsReceived[((fcntup - 1) - step.known[known_i]) * dataPointSize];
+      for (dataPoint_i = 0; dataPoint_i < dataPointSize; dataPoint_i++) {
+        planValue[dataPoint_i] ^= source[dataPoint_i];
+      }
+    }
+    storeDataPoint(fcntup - step.offset, planValue.data(), lastFcntup, 2);
+  }
+  return (int)plan->steps.size();
+}
+
+/*
+ * Stage 2 of the decoding: remove the known data points from the parity checks of a frame. A parity check with one
+ * unknown data point left recovers it, a parity check with more is stored in a buffer
+ * @param parityChecks - the parity checks in the payload of the frame
+ * @param fcntup - the frame counter
+ * @param W - window size
+ * @param R - code rate
+ * @param D - degree, number of data points per parity check
+ * @param enumF - field of the parity check coefficients
+ * @return true if a data point is recovered
+ */
+template <class Strategy>
+bool DaReDecode::interpretParityChecks(uint8_t *parityChecks, uint32_t fcntup, uint8_t W, uint8_t R, uint8_t D, DaRe::F_VALUE enumF) {
+  uint8_t windowSize, dataPointOffset;
+  uint32_t dataPointOffsetPointer;
+  bool *generatorLine;
+  uint8_t *coefficients, *parityCheck;
+  bool previousDataRecovered = false;
+  uint8_t R_i, dataPoint_i;
+  int bufferI;
+
+  windowSize = DaRe::getWindowSize(W, fcntup);
+  // the code rate indicates the number of parity checks included in the frame payload for R = 2, one parity check is included, for R = 3, two parity checks, etc.
+  for (R_i = 0; R_i < R - 1; R_i++) {
+    generatorLine = Strategy::generatorLine(W, fcntup, R_i, D); // recalculate the generator line for this parity check
+    coefficients = (enumF == DaRe::F_GF256) ? DaRe::prcg(W, fcntup, R_i) : NULL; // and the coefficients in GF(256) mode
+    parityCheck = &parityChecks[dataPointSize * R_i];
 
 #if DEBUG >= 3
-      displayBoolArray(generatorLine, windowSize); 
-      std::cout << std::endl;
+    displayBoolArray(generatorLine, windowSize); 
+    std::cout << std::endl;
 #endif
-      // iterate over the window size
-      for (dataPointOffset = 1; dataPointOffset <= windowSize; dataPointOffset++) {
-        dataPointOffsetPointer = ((fcntup - 1) - dataPointOffset); // Calculate pointer for this previous data point
-        if (isDataPointReceived[dataPointOffsetPointer]) { // if the value for this data point is known, received or decoded...
+    // iterate over the window size
+    for (dataPointOffset = 1; dataPointOffset <= windowSize; dataPointOffset++) {
+      dataPointOffsetPointer = ((fcntup - 1) - dataPointOffset); // Calculate pointer for this previous data point
+      if (isDataPointReceived[dataPointOffsetPointer]) { // if the value for this data point is known, received or decoded...
 #if DEBUG >= 3
-          std::cout << (int)dataPointOffsetPointer << ", ";
+        std::cout << (int)dataPointOffsetPointer << ", ";
 #endif
-          //... and if the data point is included in the parity check ..
-          if (generatorLine[dataPointOffset - 1] == 1) {
-            generatorLine[dataPointOffset - 1] = 0; //... remove the data point from the generator line ...
+        //... and if the data point is included in the parity check ..
+        if (generatorLine[dataPointOffset - 1] == 1) {
+          generatorLine[dataPointOffset - 1] = 0; //... remove the data point from the generator line ...
 #if DEBUG >= 3
-            std::cout << "0x";
-            displayCharArray(&dataPointsReceived[dataPointOffsetPointer * dataPointSize], dataPointSize);
-            std::cout << std::endl;
+          std::cout << "0x";
+          displayCharArray(&dataPointsReceived[dataPointOffsetPointer * dataPointSize], dataPointSize);
+          std::cout << std::endl;
 #endif
-            // ... and remove the data point from the parity check by XORing the value with the parity check value, bytewise
-            for (dataPoint_i = 0; dataPoint_i < dataPointSize; dataPoint_i++) {
-              payload.payload[1 + dataPointSize * (1 + R_i) + dataPoint_i] ^= dataPointsReceived[dataPointOffsetPointer * dataPointSize + dataPoint_i]; // XOR it
-            }
+          // ... and remove the data point from the parity check by XORing the value with the parity check value, bytewise
+          if (coefficients != NULL) {
+            GF256::mulAdd(parityCheck, &dataPointsReceived[dataPointOffsetPointer * dataPointSize], coefficients[dataPointOffset - 1], dataPointSize);
+            continue;
+          }
+          for (dataPoint_i = 0; dataPoint_i < dataPointSize; dataPoint_i++) {
+            parityCheck[dataPoint_i] ^= dataPointsReceived[dataPointOffsetPointer * dataPointSize + dataPoint_i]; // XOR it
           }
         }
       }
-      
-      // now check how much data points are still included in the parity check
-      int generatorLineOnes = 0;
-      int newDataOffset = 0;
-      uint32_t j;
-      for (j = 0; j < windowSize; j++) {
-        if (generatorLine[j] == 1) {
-          generatorLineOnes += 1;
-          newDataOffset = j + 1;
-        }
+    }
+    
+    // now check how much data points are still included in the parity check
+    int generatorLineOnes = 0;
+    int newDataOffset = 0;
+    uint32_t j;
+    for (j = 0; j < windowSize; j++) {
+      if (generatorLine[j] == 1) {
+        generatorLineOnes += 1;
+        newDataOffset = j + 1;
       }
+    }
 #if DEBUG >= 3
-      displayBoolArray(generatorLine, windowSize); 
-      std::cout << std::endl;
+    displayBoolArray(generatorLine, windowSize); 
+    std::cout << std::endl;
 #endif
 
-      switch (generatorLineOnes) {
-      case 0: //if no data points are left in the parity check, no new information is received
+    switch (generatorLineOnes) {
+    case 0: //if no data points are left in the parity check, no new information is received
 #if DEBUG >= 2
-        std::cout << "No new data" << std::endl;
+      std::cout << "No new data" << std::endl;
 #endif
-        break;
-      case 1: //if one data point is left in the parity check, a data point is recovered!
-        //** STAGE 2 DATA RECOVERY | DIRECTLY FROM PARITY CHECK **//
-        storeDataPoint(fcntup - newDataOffset, &payload.payload[1 + dataPointSize * (1 + R_i)], fcntup, 2);
-        previousDataRecovered = true; // set flag for data point recovered to continue the iterative decoding
-        break;
-      default: //if more than one data point is left in the parity check, the intermediate result should be stored in a buffer instance
-        // so a new buffer entry. First to check if there is a submatrix in the buffers.
-
-        bool emptyBufferFound = false;
-        bufferI = 0;
-        // If buffers not full, get next empty buffer
-        for (j = 0; j < DARE_DECODING_BUFFERS; j++) {
-          if (!buffers[j].inUse) {
-            bufferI = j;
-            emptyBufferFound = true;
-            break;
-          }
-        }
-        // If the buffers are full, take oldest buffer entry and replace it. The oldest buffer has the smallest probability of being solved ever again
-        if (!emptyBufferFound) {
-#if DEBUG >= 2
-          std::cout << "BUFFER FULL!!!, try to solve what's possible, check if something comes clear" << std::endl;
-#endif
-          bufferI = 0;
-          uint32_t bufferDataI = buffers[0].fcntup;
-          for (j = 0; j < DARE_DECODING_BUFFERS; j++) {
-            if (bufferDataI > buffers[j].fcntup) {
-              bufferI = j;
-              bufferDataI = buffers[j].fcntup;
-            }
-          }
-        }
-        // result of this functipn part: bufferI
-
-        // fill the selected buffer instance
-        buffers[bufferI].inUse = true;
-        buffers[bufferI].fcntup = fcntup;
-        buffers[bufferI].parityCheck = new uint8_t[windowSize]();
-        for (j = 0; j < windowSize; j++) {
-          buffers[bufferI].parityCheck[j] = payload.payload[1 + dataPointSize * (1 + R_i) + j];
-        }
-        buffers[bufferI].generatorLine = generatorLine;
-        buffers[bufferI].windowSize = windowSize;
+      delete[] generatorLine;
+      delete[] coefficients;
+      break;
+    case 1: //if one data point is left in the parity check, a data point is recovered!
+      //** STAGE 2 DATA RECOVERY | DIRECTLY FROM PARITY CHECK **//
+      if (coefficients != NULL) {
+        GF256::mulRegion(parityCheck, GF256::inv(coefficients[newDataOffset - 1]), dataPointSize); // divide by the remaining coefficient
+        delete[] coefficients;
+      }
+      delete[] generatorLine;
+      storeDataPoint(fcntup - newDataOffset, parityCheck, lastFcntup, 2);
+      previousDataRecovered = true; // set flag for data point recovered to continue the iterative decoding
+      break;
+    default: //if more than one data point is left in the parity check, the intermediate result should be stored in a buffer instance
+      // so a new buffer entry. If the buffers are full, the pool replaces the oldest buffer entry
+      bufferI = buffers.allocate(fcntup);
+
+      // fill the selected buffer instance
+      buffers[bufferI].parityCheck = new uint8_t[dataPointSize]();
+      for (j = 0; j < dataPointSize; j++) {
+        buffers[bufferI].parityCheck[j] = parityCheck[j];
+      }
+      buffers[bufferI].generatorLine = generatorLine;
+      buffers[bufferI].coefficients = coefficients;
+      buffers[bufferI].windowSize = windowSize;
 #if DEBUG >= 2
-        std::cout << "Intermediate result saved in BUFFER[" << bufferI << "]." << std::endl;
+      std::cout << "Intermediate result saved in BUFFER[" << bufferI << "]." << std::endl;
 #endif
-      }
     }
+  }
 
-    // This is the iterative decoding part: if there is data recovered previously in decoding, 
-    // the buffers with parity checks that contain this new value should be updated in order to check whether
-    // they now contain only one data point an can be used to recover a certain data point.
-    while (previousDataRecovered) {
-      previousDataRecovered = false; //reset flag
-      for (bufferI = 0; bufferI < DARE_DECODING_BUFFERS; bufferI++) {
-        // only process buffers in use
-        if (!buffers[bufferI].inUse) {
-          continue;
-        }
+  return previousDataRecovered;
+}
+
+/*
+ * Stage 3 of the decoding: update the buffers with newly known data points until no more data points come clear
+ * @param fcntup - frame counter of current frame (used to compute recovery delay)
+ * @param deadline - optional point in time after which the iteration stops, NULL to iterate until done. At least one
+ * pass over the buffers is made, so every call recovers a data point or completes
+ * @return false if the deadline stopped the iteration
+ */
+bool DaReDecode::iterateBuffers(uint32_t fcntup, const std::chrono::steady_clock::time_point *deadline) {
+  uint8_t dataPointOffset, dataPoint_i;
+  uint32_t dataPointOffsetPointer;
+  bool previousDataRecovered = true;
+  int bufferI;
+
+  // This is the iterative decoding part: if there is data recovered previously in decoding, 
+  // the buffers with parity checks that contain this new value should be updated in order to check whether
+  // they now contain only one data point an can be used to recover a certain data point.
+  while (previousDataRecovered) {
+    previousDataRecovered = false; //reset flag
+    for (bufferI = 0; bufferI < buffers.size(); bufferI++) {
+      // only process buffers in use
+      if (!buffers[bufferI].inUse) {
+        continue;
+      }
 #if DEBUG >= 2
-        std::cout << "-- Checking BUFFER[" << bufferI << "]" << std::endl;
-#endif
-        for (dataPointOffset = 1; dataPointOffset <= buffers[bufferI].windowSize; dataPointOffset++) {
-          dataPointOffsetPointer = (((buffers[bufferI].fcntup - 1) - dataPointOffset)); // Calculate pointer for previous data point
-          if (buffers[bufferI].generatorLine[dataPointOffset - 1] == 1 && isDataPointReceived[dataPointOffsetPointer]) { // If the data point is known and in the generator line ...
-            buffers[bufferI].generatorLine[dataPointOffset - 1] = 0; // ... remove the data point from the generator line ...
-            for (dataPoint_i = 0; dataPoint_i < dataPointSize; dataPoint_i++) {
-              // .. and remove the data point from the parity check by XORing bytewise
-              buffers[bufferI].parityCheck[dataPoint_i] ^= dataPointsReceived[dataPointOffsetPointer * dataPointSize + dataPoint_i];
-            }
+      std::cout << "-- Checking BUFFER[" << bufferI << "]" << std::endl;
+#endif
+      for (dataPointOffset = 1; dataPointOffset <= buffers[bufferI].windowSize; dataPointOffset++) {
+        dataPointOffsetPointer = (((buffers[bufferI].fcntup - 1) - dataPointOffset)); // Calculate pointer for previous data point
+        if (buffers[bufferI].generatorLine[dataPointOffset - 1] == 1 && isDataPointReceived[dataPointOffsetPointer]) { // If the data point is known and in the generator line ...
+          buffers[bufferI].generatorLine[dataPointOffset - 1] = 0; // ... remove the data point from the generator line ...
+          buffers[bufferI].reduced = false;
+          if (buffers[bufferI].coefficients != NULL) {
+            GF256::mulAdd(buffers[bufferI].parityCheck, &dataPointsReceived[dataPointOffsetPointer * dataPointSize], buffers[bufferI].coefficients[dataPointOffset - 1], dataPointSize);
+            continue;
+          }
+          for (dataPoint_i = 0; dataPoint_i < dataPointSize; dataPoint_i++) {
+            // .. and remove the data point from the parity check by XORing bytewise
+            buffers[bufferI].parityCheck[dataPoint_i] ^= dataPointsReceived[dataPointOffsetPointer * dataPointSize + dataPoint_i];
           }
         }
+      }
 
-        int generatorLineOnes = 0;
-        int newDataOffset = 0;
-        int j;
-        // check the number of data points in the parity check
-        for (j = 0; j < buffers[bufferI].windowSize; j++) {
-          if (buffers[bufferI].generatorLine[j] == 1) {
-            generatorLineOnes += 1;
-            newDataOffset = j + 1;
-          }
+      int generatorLineOnes = 0;
+      int newDataOffset = 0;
+      int j;
+      // check the number of data points in the parity check
+      for (j = 0; j < buffers[bufferI].windowSize; j++) {
+        if (buffers[bufferI].generatorLine[j] == 1) {
+          generatorLineOnes += 1;
+          newDataOffset = j + 1;
         }
+      }
 
-        switch (generatorLineOnes) {
-        case 0: //if no data points in the parity check left, empty the buffer
+      switch (generatorLineOnes) {
+      case 0: //if no data points in the parity check left, empty the buffer
 #if DEBUG >= 2
-          std::cout << "No new data in this buffer anymore" << std::endl;
+        std::cout << "No new data in this buffer anymore" << std::endl;
 #endif
-          clearBuffer(bufferI);
-          break;
-        case 1: //if one data point in the parity check, save this as a decoded value
-          //** STAGE 3 DATA RECOVERY | FROM A BUFFER **//
-          storeDataPoint(buffers[bufferI].fcntup - newDataOffset, buffers[bufferI].parityCheck, fcntup, 3);
-          previousDataRecovered = true; //and raise flag that another data point is recovered
+        clearBuffer(bufferI);
+        break;
+      case 1: //if one data point in the parity check, save this as a decoded value
+        //** STAGE 3 DATA RECOVERY | FROM A BUFFER **//
+        if (buffers[bufferI].coefficients != NULL) {
+          GF256::mulRegion(buffers[bufferI].parityCheck, GF256::inv(buffers[bufferI].coefficients[newDataOffset - 1]), dataPointSize);
+        }
+        storeDataPoint(buffers[bufferI].fcntup - newDataOffset, buffers[bufferI].parityCheck, fcntup, 3);
+        previousDataRecovered = true; //and raise flag that another data point is recovered
 
-          clearBuffer(bufferI);
-          break;
+        clearBuffer(bufferI);
+        break;
 #if DEBUG >= 2
-        default:
-          std::cout << "Still not more info" << std::endl;
+      default:
+        std::cout << "Still not more info" << std::endl;
 #endif
-        }
       }
     }
+    // stop at the deadline, the buffers are consistent after every pass
+    if (previousDataRecovered && deadline != NULL && std::chrono::steady_clock::now() >= *deadline) {
+      return false;
+    }
+  }
+  return true;
+}
 
-    // finally, try to find more data points in all buffers
-    checkBuffersForSubmatrix(false, fcntup);
+/*
+ * Run the elimination that decode() deferred: stage 3 and stage 4 for all frames since the last elimination at once
+ * @param budgetMicroseconds - time budget for this call, 0 for no limit. If the budget runs out during stage 3 the
+ * elimination stays pending. Once stage 3 is done stage 4 always runs, a pass of stage 3 alone can take longer than a
+ * small budget, and stopping there would redo that pass on every call without ever reaching stage 4
+ * @return true if no elimination is pending anymore
+ */
+bool DaReDecode::runElimination(uint32_t budgetMicroseconds) {
+  std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + std::chrono::microseconds(budgetMicroseconds);
+  if (!eliminationPending) {
+    return true;
+  }
+  if (!iterateBuffers(eliminationFcntup, (budgetMicroseconds > 0) ? &deadline : NULL)) {
+    return false;
+  }
+  checkBuffersForSubmatrix(false, eliminationFcntup);
+  eliminationPending = false;
+  if (memoryBudget != NULL) {
+    memoryBudget->enforce();
   }
 
-  // reset the try to recover flag if all previous data points are recovered
-  if (recovered == fcntup && tryToRecover) {
-#if DEBUG >= 2
-    std::cout << "--------- We are complete!" << std::endl;
-#endif
+  if (tryToRecover && !isRecoveryOutstanding()) {
     tryToRecover = false;
   }
+  deliverInOrder(false);
+  return true;
 }
 
 /*
- * perform Gaussian elimination on the results in the buffers in order to eliminate linear dependence between buffer values and to find more data points
+ * perform Gaussian elimination on the results in the buffers in order to eliminate linear dependence between buffer values and to find more data points.
+ * The buffers fall apart in groups that have no data points in common, for example after separate loss bursts. Each
+ * group is eliminated on its own, which is much less work than one submatrix from the oldest to the newest data point
  * @param flushBuffers - whether the buffers should be flushed after being processed
  * @param fcntup - frame counter of current frame (used to compute recovery delay)
  */
 void DaReDecode::checkBuffersForSubmatrix(bool flushBuffers, uint32_t fcntup) {
   uint32_t currentNewestDataPointId = 0, currentOldestDataPointId = 0, buffersInUse = 0;
-  uint32_t bufferI, dataPointOffset, dataPointOffsetPointer, dataPoint_i, j;
-  bool currentOldestDataPointIdSet = false;
+  uint32_t bufferI, dataPointOffset, dataPointOffsetPointer, bufferOldest, bufferNewest, firstDataPoint, component_i, componentEnd;
+  uint32_t componentOldest, componentNewest, clusterNewest;
+  bool currentOldestDataPointIdSet = false, firstDataPointSet, singleComponent;
+  bool gf256 = false; // if any parity check has coefficients, the elimination is done in GF(256)
+  bool changed = false; // whether any buffer changed since the last elimination
 
+  componentOrder.clear();
+  componentSpan.resize(buffers.size());
   // loop through all buffers to determine the newest and oldest data point in the buffers
-  for (bufferI = 0; bufferI < DARE_DECODING_BUFFERS; bufferI++) {
+  for (bufferI = 0; bufferI < buffers.size(); bufferI++) {
     // only consider buffers in use
     if (!buffers[bufferI].inUse) {
       continue;
     }
-    buffersInUse += 1; // determine number of buffers in use
+    gf256 |= (buffers[bufferI].coefficients != NULL);
+    changed |= !buffers[bufferI].reduced;
+    bufferOldest = 0;
+    bufferNewest = 0;
+    firstDataPointSet = false;
 
     for (dataPointOffset = 1; dataPointOffset <= buffers[bufferI].windowSize; dataPointOffset++) {
       if (buffers[bufferI].generatorLine[dataPointOffset - 1] == 1) {
@@ -333,17 +996,29 @@ void DaReDecode::checkBuffersForSubmatrix(bool flushBuffers, uint32_t fcntup) {
 #if DEBUG >= 3
         std::cout << "d[" << (unsigned int)dataPointOffsetPointer << "], ";
 #endif
-        // determine the newest data point id of all datapoints included in all buffers
-        if (dataPointOffsetPointer > currentNewestDataPointId) {
-          currentNewestDataPointId = dataPointOffsetPointer;
-        }
-        // determine the oldest data point id of all datapoints included in all buffers
-        if (dataPointOffsetPointer < currentOldestDataPointId || !currentOldestDataPointIdSet) {
-          currentOldestDataPointIdSet = true;
-          currentOldestDataPointId = dataPointOffsetPointer;
+        if (!firstDataPointSet) {
+          bufferNewest = dataPointOffsetPointer;
+          firstDataPointSet = true;
         }
+        bufferOldest = dataPointOffsetPointer;
       }
     }
+    if (!firstDataPointSet) {
+      clearBuffer(bufferI); // an empty parity check has no information
+      continue;
+    }
+    buffersInUse += 1; // determine number of buffers in use
+    componentSpan[bufferI] = ((uint64_t)bufferOldest << 32) | bufferNewest;
+    componentOrder.push_back(((uint64_t)bufferOldest << 32) | bufferI);
+    // determine the newest data point id of all datapoints included in all buffers
+    if (bufferNewest > currentNewestDataPointId) {
+      currentNewestDataPointId = bufferNewest;
+    }
+    // determine the oldest data point id of all datapoints included in all buffers
+    if (bufferOldest < currentOldestDataPointId || !currentOldestDataPointIdSet) {
+      currentOldestDataPointIdSet = true;
+      currentOldestDataPointId = bufferOldest;
+    }
   }
 #if DEBUG >= 2
   std::cout << "In " << (unsigned int)buffersInUse << " buffers:" << std::endl
@@ -359,197 +1034,296 @@ void DaReDecode::checkBuffersForSubmatrix(bool flushBuffers, uint32_t fcntup) {
     return;
   }
   // if there is only one buffer in use, Gaussian elimination cannot be performed
-  else if (buffersInUse == 1) { 
+  if (buffersInUse == 1) {
 #if DEBUG >= 2
     std::cout << "Only one buffer in use, so discard it.." << std::endl;
 #endif
     if (flushBuffers) {
-      for (bufferI = 0; bufferI < DARE_DECODING_BUFFERS; bufferI++) {
-        if (!buffers[bufferI].inUse) {
-          continue;
-        }
-        clearBuffer(bufferI);
-        break;
-      }
+      clearBuffer((uint32_t)componentOrder[0]);
     }
     return;
-  // if more than one buffer in use, perform Gaussian elimination
+  }
+  // if no buffer changed since the last elimination, they are still in reduced form and cannot give a new data point
+  if (!changed && !flushBuffers) {
+    return;
+  }
+
+  // parity checks whose spans of data points do not overlap cannot share a data point. If all spans chain together,
+  // which is the common case for a large W, the buffers are eliminated as a whole without looking further
+  std::sort(componentOrder.begin(), componentOrder.end());
+  singleComponent = true;
+  clusterNewest = (uint32_t)componentSpan[(uint32_t)componentOrder[0]];
+  for (component_i = 1; component_i < componentOrder.size() && singleComponent; component_i++) {
+    bufferI = (uint32_t)componentOrder[component_i];
+    singleComponent = (uint32_t)(componentSpan[bufferI] >> 32) <= clusterNewest;
+    clusterNewest = ((uint32_t)componentSpan[bufferI] > clusterNewest) ? (uint32_t)componentSpan[bufferI] : clusterNewest;
+  }
+
+  if (singleComponent) {
+    for (component_i = 0; component_i < componentOrder.size(); component_i++) {
+      componentOrder[component_i] = (uint32_t)componentOrder[component_i];
+    }
   } else {
-    // create submatrix that expresses relation between data points and the parity checks in buffers
-    uint32_t subMatrixWidth = (currentNewestDataPointId - currentOldestDataPointId + 1);
-    bool *subMatrix = new bool[subMatrixWidth * buffersInUse]();
-    // create array to contain the parity check values
-    uint8_t *X = new uint8_t[buffersInUse * dataPointSize]();
-
-    // variable that will hold the number of parity checks in the submatrix
-    uint32_t nrBufferInUse = 0;
-    for (bufferI = 0; bufferI < DARE_DECODING_BUFFERS; bufferI++) {
-      if (!buffers[bufferI].inUse) {
-        continue;
-      }
-      // for each buffer, fill the submatrix using the generator line, and fill X with the parity check values
+    // union-find over the data points: all data points of a parity check end up in the same component
+    componentParent.resize(currentNewestDataPointId - currentOldestDataPointId + 1);
+    for (dataPointOffsetPointer = 0; dataPointOffsetPointer < componentParent.size(); dataPointOffsetPointer++) {
+      componentParent[dataPointOffsetPointer] = dataPointOffsetPointer;
+    }
+    for (component_i = 0; component_i < componentOrder.size(); component_i++) {
+      bufferI = (uint32_t)componentOrder[component_i];
+      firstDataPoint = (uint32_t)componentSpan[bufferI] - currentOldestDataPointId;
       for (dataPointOffset = 1; dataPointOffset <= buffers[bufferI].windowSize; dataPointOffset++) {
         if (buffers[bufferI].generatorLine[dataPointOffset - 1] == 1) {
-          dataPointOffsetPointer = (((buffers[bufferI].fcntup - 1) - dataPointOffset)); // Calculate pointer for previous data point
-          subMatrix[nrBufferInUse*subMatrixWidth + dataPointOffsetPointer - currentOldestDataPointId] = 1;
-          for (dataPoint_i = 0; dataPoint_i < dataPointSize; dataPoint_i++) {
-            X[nrBufferInUse * dataPointSize + dataPoint_i] = buffers[bufferI].parityCheck[dataPoint_i];
-          }
+          dataPointOffsetPointer = ((buffers[bufferI].fcntup - 1) - dataPointOffset) - currentOldestDataPointId;
+          componentParent[findComponent(dataPointOffsetPointer)] = findComponent(firstDataPoint);
+        }
+      }
+    }
+    for (component_i = 0; component_i < componentOrder.size(); component_i++) {
+      bufferI = (uint32_t)componentOrder[component_i];
+      componentOrder[component_i] = ((uint64_t)findComponent((uint32_t)componentSpan[bufferI] - currentOldestDataPointId) << 32) | bufferI;
+    }
+  }
+  // the buffers are ordered by component, then by buffer index
+  std::sort(componentOrder.begin(), componentOrder.end());
+
+  for (component_i = 0; component_i < componentOrder.size(); component_i = componentEnd) {
+    componentOldest = currentNewestDataPointId;
+    componentNewest = currentOldestDataPointId;
+    gf256 = false;
+    changed = false;
+    for (componentEnd = component_i; componentEnd < componentOrder.size() && (componentOrder[componentEnd] >> 32) == (componentOrder[component_i] >> 32); componentEnd++) {
+      bufferI = (uint32_t)componentOrder[componentEnd];
+      componentBuffers.push_back(bufferI);
+      gf256 |= (buffers[bufferI].coefficients != NULL);
+      changed |= !buffers[bufferI].reduced;
+      componentOldest = ((uint32_t)(componentSpan[bufferI] >> 32) < componentOldest) ? (uint32_t)(componentSpan[bufferI] >> 32) : componentOldest;
+      componentNewest = ((uint32_t)componentSpan[bufferI] > componentNewest) ? (uint32_t)componentSpan[bufferI] : componentNewest;
+    }
+#if DEBUG >= 2
+    std::cout << "Component of " << componentBuffers.size() << " buffers, d[" << componentOldest << "] to d[" << componentNewest << "]" << std::endl;
+#endif
+
+    if (componentBuffers.size() == 1 && flushBuffers) {
+      // a single parity check cannot be solved, and is not kept when flushing
+      clearBuffer(componentBuffers[0]);
+    } else if (componentBuffers.size() > 1 && (changed || flushBuffers)) {
+      // a component with one parity check has at least two unknowns, and a component that did not change since its
+      // last elimination is still in reduced form, neither can give a new data point
+      eliminateComponent(&componentBuffers[0], (uint32_t)componentBuffers.size(), componentOldest, componentNewest, gf256, flushBuffers, fcntup);
+    }
+    componentBuffers.clear();
+  }
+
+  // if flush buffers flag was set, don't refill the buffers with the result of the Gaussian elimination, and reset the flag to try to recover data points
+  if (flushBuffers) {
+    tryToRecover = false;
+  }
+}
+
+/*
+ * find the root of the component of a data point, halving the path on the way
+ * @param dataPoint - data point id relative to the oldest data point in the buffers
+ */
+uint32_t DaReDecode::findComponent(uint32_t dataPoint) {
+  while (componentParent[dataPoint] != dataPoint) {
+    componentParent[dataPoint] = componentParent[componentParent[dataPoint]];
+    dataPoint = componentParent[dataPoint];
+  }
+  return dataPoint;
+}
+
+/*
+ * Gaussian elimination of the parity checks of one component, the data points that are solved are stored and the
+ * remaining rows replace the parity checks in the buffers
+ * @param bufferIds - the buffers of the component
+ * @param buffersInUse - the number of buffers of the component
+ * @param currentOldestDataPointId - oldest data point in the component
+ * @param currentNewestDataPointId - newest data point in the component
+ * @param gf256 - whether any parity check has coefficients in GF(256)
+ * @param flushBuffers - whether the buffers should be flushed after being processed
+ * @param fcntup - frame counter of current frame (used to compute recovery delay)
+ */
+void DaReDecode::eliminateComponent(const uint32_t *bufferIds, uint32_t buffersInUse, uint32_t currentOldestDataPointId, uint32_t currentNewestDataPointId, bool gf256, bool flushBuffers, uint32_t fcntup) {
+  uint32_t bufferI, dataPointOffset, dataPointOffsetPointer, dataPoint_i, j;
+
+  // create submatrix that expresses relation between data points and the parity checks in buffers
+  uint32_t subMatrixWidth = (currentNewestDataPointId - currentOldestDataPointId + 1);
+  uint8_t *subMatrix = new uint8_t[subMatrixWidth * buffersInUse]();
+  // create array to contain the parity check values
+  uint8_t *X = new uint8_t[buffersInUse * dataPointSize]();
+
+  // variable that will hold the number of parity checks in the submatrix
+  uint32_t nrBufferInUse;
+  for (nrBufferInUse = 0; nrBufferInUse < buffersInUse; nrBufferInUse++) {
+    bufferI = bufferIds[nrBufferInUse];
+    // for each buffer, fill the submatrix using the generator line, and fill X with the parity check values
+    for (dataPointOffset = 1; dataPointOffset <= buffers[bufferI].windowSize; dataPointOffset++) {
+      if (buffers[bufferI].generatorLine[dataPointOffset - 1] == 1) {
+        dataPointOffsetPointer = (((buffers[bufferI].fcntup - 1) - dataPointOffset)); // Calculate pointer for previous data point
+        subMatrix[nrBufferInUse*subMatrixWidth + dataPointOffsetPointer - currentOldestDataPointId] = (buffers[bufferI].coefficients != NULL) ? buffers[bufferI].coefficients[dataPointOffset - 1] : 1;
+        for (dataPoint_i = 0; dataPoint_i < dataPointSize; dataPoint_i++) {
+          X[nrBufferInUse * dataPointSize + dataPoint_i] = buffers[bufferI].parityCheck[dataPoint_i];
         }
       }
-      nrBufferInUse++;
     }
+  }
 #if DEBUG >= 3
-    displayBoolArray(subMatrix, subMatrixWidth * buffersInUse, subMatrixWidth);
-    displayCharArray(X, buffersInUse * dataPointSize, dataPointSize, ' ');
-    std::cout << std::endl;
+  displayCharArray(subMatrix, subMatrixWidth * buffersInUse, subMatrixWidth);
+  displayCharArray(X, buffersInUse * dataPointSize, dataPointSize, ' ');
+  std::cout << std::endl;
 #endif
-    // now perform Gaussian elimination in GF(2) over the submatrix
+  // now perform Gaussian elimination in GF(2) or GF(256) over the submatrix
+  if (gf256) {
+    DaReDecode::gf256rref(subMatrix, subMatrixWidth, buffersInUse, X);
+  } else {
     DaReDecode::g2rref(subMatrix, subMatrixWidth, buffersInUse, X);
+  }
 #if DEBUG >= 3
-    displayBoolArray(subMatrix, subMatrixWidth * buffersInUse, subMatrixWidth);
-    displayCharArray(X, buffersInUse * dataPointSize, dataPointSize, ' ');
-    std::cout << std::endl;
+  displayCharArray(subMatrix, subMatrixWidth * buffersInUse, subMatrixWidth);
+  displayCharArray(X, buffersInUse * dataPointSize, dataPointSize, ' ');
+  std::cout << std::endl;
 #endif
 
-    uint32_t dataPointFoundIndex;
-    uint8_t nrDataPointsInParityCheck;
-    bool foundOne = true;
-    while (foundOne) {
-      foundOne = false;
-      for (nrBufferInUse = 0; nrBufferInUse < buffersInUse; nrBufferInUse++) {
-        nrDataPointsInParityCheck = 0;
-        dataPointFoundIndex = 0;
-        // determine how much data points are in the parity check (and store the index of the last one)
-        for (j = 0; j < subMatrixWidth; j++) {
-          if (subMatrix[nrBufferInUse*subMatrixWidth + j] == 1) {
-            nrDataPointsInParityCheck += 1;
-            dataPointFoundIndex = j;
-          }
+  uint32_t dataPointFoundIndex;
+  uint8_t nrDataPointsInParityCheck;
+  bool foundOne = true;
+  while (foundOne) {
+    foundOne = false;
+    for (nrBufferInUse = 0; nrBufferInUse < buffersInUse; nrBufferInUse++) {
+      nrDataPointsInParityCheck = 0;
+      dataPointFoundIndex = 0;
+      // determine how much data points are in the parity check (and store the index of the last one)
+      for (j = 0; j < subMatrixWidth; j++) {
+        if (subMatrix[nrBufferInUse*subMatrixWidth + j] != 0) {
+          nrDataPointsInParityCheck += 1;
+          dataPointFoundIndex = j;
         }
+      }
 
-        // if only one data point is in the parity check, store it!
-        if (nrDataPointsInParityCheck == 1) {
-          //** STAGE 4 DATA RECOVERY | FROM A SOLVED SUBMATRIX **//
-          storeDataPoint(currentOldestDataPointId + dataPointFoundIndex + 1, &X[nrBufferInUse*dataPointSize], fcntup, 4);
-          subMatrix[nrBufferInUse*subMatrixWidth + dataPointFoundIndex] = 0;
-          // remove the known data point value from parity checks that had this data point included
-          for (j = 0; j < buffersInUse; j++) {
-            if (subMatrix[j*subMatrixWidth + dataPointFoundIndex] == 1) {
-              subMatrix[j*subMatrixWidth + dataPointFoundIndex] = 0;
-              for (dataPoint_i = 0; dataPoint_i < dataPointSize; dataPoint_i++) {
-                X[j*dataPointSize + dataPoint_i] ^= X[nrBufferInUse*dataPointSize + dataPoint_i];
-              }
-            }
+      // if only one data point is in the parity check, store it!
+      if (nrDataPointsInParityCheck == 1) {
+        //** STAGE 4 DATA RECOVERY | FROM A SOLVED SUBMATRIX **//
+        if (subMatrix[nrBufferInUse*subMatrixWidth + dataPointFoundIndex] != 1) { // only in GF(256) the remaining coefficient can differ from one
+          GF256::mulRegion(&X[nrBufferInUse*dataPointSize], GF256::inv(subMatrix[nrBufferInUse*subMatrixWidth + dataPointFoundIndex]), dataPointSize);
+        }
+        storeDataPoint(currentOldestDataPointId + dataPointFoundIndex + 1, &X[nrBufferInUse*dataPointSize], fcntup, 4);
+        subMatrix[nrBufferInUse*subMatrixWidth + dataPointFoundIndex] = 0;
+        // remove the known data point value from parity checks that had this data point included
+        for (j = 0; j < buffersInUse; j++) {
+          if (subMatrix[j*subMatrixWidth + dataPointFoundIndex] != 0) {
+            GF256::mulAdd(&X[j*dataPointSize], &X[nrBufferInUse*dataPointSize], subMatrix[j*subMatrixWidth + dataPointFoundIndex], dataPointSize);
+            subMatrix[j*subMatrixWidth + dataPointFoundIndex] = 0;
           }
+        }
 #if DEBUG >= 3
-          displayBoolArray(subMatrix, subMatrixWidth * buffersInUse, subMatrixWidth);
-          displayCharArray(X, buffersInUse * dataPointSize, dataPointSize, ' ');
-          std::cout << std::endl;
+        displayCharArray(subMatrix, subMatrixWidth * buffersInUse, subMatrixWidth);
+        displayCharArray(X, buffersInUse * dataPointSize, dataPointSize, ' ');
+        std::cout << std::endl;
 #endif
-          foundOne = true; // flag to trigger iterative decoding
-          break;
-        }
+        foundOne = true; // flag to trigger iterative decoding
+        break;
       }
     }
+  }
 
-    // clear all current buffers in use
-    for (bufferI = 0; bufferI < DARE_DECODING_BUFFERS; bufferI++) {
-      if (!buffers[bufferI].inUse) {
-        continue;
-      }
-      clearBuffer(bufferI);
-    }
+  // clear the buffers of the component
+  for (nrBufferInUse = 0; nrBufferInUse < buffersInUse; nrBufferInUse++) {
+    clearBuffer(bufferIds[nrBufferInUse]);
+  }
 
-    // if flush buffers flag was set, don't refill the buffers with the result of the Gaussian elimination, and reset the flag to try to recover data points
-    if (flushBuffers) {
-      tryToRecover = false;
-    } else {
-      // fill the buffers again with the result of the Gaussian elimination
+  // if flush buffers flag was set, don't refill the buffers with the result of the Gaussian elimination
+  if (!flushBuffers) {
+    // fill the buffers again with the result of the Gaussian elimination
 #if DEBUG >= 2
-      std::cout << "Save part of the buffers again, which still have information" << std::endl;
-#endif
-      int newBuffers = 0;
-      bufferI = 0;
-      uint32_t firstOne, lastOne;
-      bool firstOneFound, thisValueIsDoomed;
-      uint32_t oldestDataPointStillReceivable = ((fcntup - 1) > DARE_MAX_W) ? ((fcntup - 1) - DARE_MAX_W) : 0;
-      for (nrBufferInUse = 0; nrBufferInUse < buffersInUse; nrBufferInUse++) {
-        firstOne = 0, lastOne = 0;
-        firstOneFound = false;
-        thisValueIsDoomed = false;
-        for (j = 0; j < subMatrixWidth; j++) {
-          if (subMatrix[nrBufferInUse*subMatrixWidth + j] == 1) {
-            if (!firstOneFound) {
-              firstOne = j;
-              firstOneFound = true;
-              // if the oldest data point in the parity check cannot be included in a to be received parity check, discard the parity check
-              if ((currentOldestDataPointId + firstOne) < oldestDataPointStillReceivable) {
-                thisValueIsDoomed = true;
-              }
+    std::cout << "Save part of the buffers again, which still have information" << std::endl;
+#endif
+    int newBuffers = 0;
+    uint32_t firstOne, lastOne;
+    bool firstOneFound, thisValueIsDoomed;
+    uint32_t oldestDataPointStillReceivable = ((fcntup - 1) > DARE_MAX_W) ? ((fcntup - 1) - DARE_MAX_W) : 0;
+    for (nrBufferInUse = 0; nrBufferInUse < buffersInUse; nrBufferInUse++) {
+      firstOne = 0, lastOne = 0;
+      firstOneFound = false;
+      thisValueIsDoomed = false;
+      for (j = 0; j < subMatrixWidth; j++) {
+        if (subMatrix[nrBufferInUse*subMatrixWidth + j] != 0) {
+          if (!firstOneFound) {
+            firstOne = j;
+            firstOneFound = true;
+            // if the oldest data point in the parity check cannot be included in a to be received parity check, discard the parity check
+            if ((currentOldestDataPointId + firstOne) < oldestDataPointStillReceivable) {
+              thisValueIsDoomed = true;
             }
-            lastOne = j;
           }
+          lastOne = j;
         }
+      }
 
-        if (!firstOneFound) {
+      if (!firstOneFound) {
 #if DEBUG >= 2
-          std::cout << "Discard empty row" << std::endl;
+        std::cout << "Discard empty row" << std::endl;
 #endif
-        } else if (thisValueIsDoomed) {
+      } else if (thisValueIsDoomed) {
 #if DEBUG >= 1
-          std::cout << "-- d[" << currentOldestDataPointId + firstOne << "] is forever lost!" << std::endl;
+        std::cout << "-- d[" << currentOldestDataPointId + firstOne << "] is forever lost!" << std::endl;
 #endif
-        } else {
-          buffers[bufferI].inUse = true;
-          buffers[bufferI].fcntup = currentOldestDataPointId + lastOne + 2;
+      } else {
+        bufferI = buffers.allocate(currentOldestDataPointId + lastOne + 2);
 
-          uint8_t *newParityCheck = new uint8_t[dataPointSize]();
-          for (j = 0; j < dataPointSize; j++) {
-            newParityCheck[j] = X[nrBufferInUse*dataPointSize + j];
-          }
-          buffers[bufferI].parityCheck = newParityCheck;
+        uint8_t *newParityCheck = new uint8_t[dataPointSize]();
+        for (j = 0; j < dataPointSize; j++) {
+          newParityCheck[j] = X[nrBufferInUse*dataPointSize + j];
+        }
+        buffers[bufferI].parityCheck = newParityCheck;
 
-          buffers[bufferI].windowSize = lastOne - firstOne + 1;
-          bool *newGeneratorLine = new bool[buffers[bufferI].windowSize]();
+        buffers[bufferI].windowSize = lastOne - firstOne + 1;
+        bool *newGeneratorLine = new bool[buffers[bufferI].windowSize]();
+        for (j = 0; j < buffers[bufferI].windowSize; j++) {
+          newGeneratorLine[buffers[bufferI].windowSize - 1 - j] = (subMatrix[nrBufferInUse*subMatrixWidth + firstOne + j] != 0);
+        }
+        buffers[bufferI].generatorLine = newGeneratorLine;
+        buffers[bufferI].reduced = true;
+        buffers[bufferI].coefficients = NULL;
+        if (gf256) {
+          buffers[bufferI].coefficients = new uint8_t[buffers[bufferI].windowSize]();
           for (j = 0; j < buffers[bufferI].windowSize; j++) {
-            newGeneratorLine[buffers[bufferI].windowSize - 1 - j] = subMatrix[nrBufferInUse*subMatrixWidth + firstOne + j];
+            buffers[bufferI].coefficients[buffers[bufferI].windowSize - 1 - j] = subMatrix[nrBufferInUse*subMatrixWidth + firstOne + j];
           }
-          buffers[bufferI].generatorLine = newGeneratorLine;
+        }
 
 #if DEBUG >= 2
-          std::cout << "New buffer[" << (int)bufferI
-            << "]: fcnt = " << (int)buffers[bufferI].fcntup
-            << ", firstOne = " << (int)firstOne << ", lastOne = " << (int)lastOne
-            << ", windowSize = " << (int)buffers[bufferI].windowSize
-            << ", parity check = ";
-          displayCharArray(buffers[bufferI].parityCheck, dataPointSize, 1, ' ');
-          std::cout << std::endl;
-          displayBoolArray(buffers[bufferI].generatorLine, buffers[bufferI].windowSize);
-          std::cout << std::endl;
+        std::cout << "New buffer[" << (int)bufferI
+          << "]: fcnt = " << (int)buffers[bufferI].fcntup
+          << ", firstOne = " << (int)firstOne << ", lastOne = " << (int)lastOne
+          << ", windowSize = " << (int)buffers[bufferI].windowSize
+          << ", parity check = ";
+        displayCharArray(buffers[bufferI].parityCheck, dataPointSize, 1, ' ');
+        std::cout << std::endl;
+        displayBoolArray(buffers[bufferI].generatorLine, buffers[bufferI].windowSize);
+        std::cout << std::endl;
 #endif
 
-          bufferI++;
-          newBuffers += 1;
-        }
+        newBuffers += 1;
       }
+    }
 #if DEBUG >= 2
-      std::cout << "There are now still " << newBuffers << " buffers with information left" << std::endl;
+    std::cout << "There are now still " << newBuffers << " buffers with information left" << std::endl;
 #endif
-    }
-
-    free(subMatrix);
-    free(X);
   }
+
+  free(subMatrix);
+  free(X);
 }
 
 //#define DEBUG_G2RREF
 /*
  * Function to perform Gaussian elimination in GF(2)
  */
-void DaReDecode::g2rref(bool* matrix, uint32_t width, uint32_t height, uint8_t *X) {
+void DaReDecode::g2rref(uint8_t *matrix, uint32_t width, uint32_t height, uint8_t *X) {
   uint32_t n = width, m = height, i = 0, j = 0, a, b, k;
-  bool kFound, tempBool;
+  bool kFound;
+  uint8_t tempBool;
   uint8_t tempChar, dataPoint_i;
 
   while ((i < m) && (j < n)) {
@@ -592,7 +1366,7 @@ void DaReDecode::g2rref(bool* matrix, uint32_t width, uint32_t height, uint8_t *
 #ifdef DEBUG_G2RREF
       std::cout << "After swap: ";
       std::cout << std::endl;
-      displayBoolArray(matrix, width*height, width);
+      displayCharArray(matrix, width*height, width);
       displayCharArray(X, height * dataPointSize, dataPointSize, ' ');
       std::cout << std::endl;
 #endif
@@ -638,7 +1412,7 @@ void DaReDecode::g2rref(bool* matrix, uint32_t width, uint32_t height, uint8_t *
 #ifdef DEBUG_G2RREF
     std::cout << "After XOR: ";
     std::cout << std::endl;
-    displayBoolArray(matrix, width*height, width);
+    displayCharArray(matrix, width*height, width);
     displayCharArray(X, height * dataPointSize, dataPointSize, ' ');
     std::cout << std::endl;
     std::cout << std::endl;
@@ -652,6 +1426,58 @@ void DaReDecode::g2rref(bool* matrix, uint32_t width, uint32_t height, uint8_t *
   }
 }
 
+/*
+ * Function to perform Gaussian elimination in GF(256). Every pivot is normalised to one, so a row with a single
+ * non-zero element holds the value of that data point
+ */
+void DaReDecode::gf256rref(uint8_t *matrix, uint32_t width, uint32_t height, uint8_t *X) {
+  uint32_t i = 0, j = 0, a, b, k;
+  uint8_t temp, factor;
+
+  while ((i < height) && (j < width)) {
+    // Find a row with a non-zero element in the remainder of column j
+    for (k = i; k < height; k++) {
+      if (matrix[j + width * k] != 0) {
+        break;
+      }
+    }
+    if (k == height) {
+      j += 1;
+      continue;
+    }
+
+    // Swap i - th and k - th rows.
+    for (b = j; b < width; b++) {
+      temp = matrix[b + width * k];
+      matrix[b + width * k] = matrix[b + width * i];
+      matrix[b + width * i] = temp;
+    }
+    for (b = 0; b < dataPointSize; b++) {
+      temp = X[b + dataPointSize * k];
+      X[b + dataPointSize * k] = X[b + dataPointSize * i];
+      X[b + dataPointSize * i] = temp;
+    }
+
+    // Normalise the pivot row
+    factor = GF256::inv(matrix[j + width * i]);
+    GF256::mulRegion(&matrix[j + width * i], factor, width - j);
+    GF256::mulRegion(&X[dataPointSize * i], factor, dataPointSize);
+
+    // Eliminate column j from all other rows
+    for (a = 0; a < height; a++) {
+      factor = matrix[j + width * a];
+      if (a == i || factor == 0) {
+        continue;
+      }
+      GF256::mulAdd(&matrix[j + width * a], &matrix[j + width * i], factor, width - j);
+      GF256::mulAdd(&X[dataPointSize * a], &X[dataPointSize * i], factor, dataPointSize);
+    }
+
+    i += 1;
+    j += 1;
+  }
+}
+
 /*
  * Debug function for displaying data
  */
@@ -10,53 +10,133 @@ Description: Decoding functions
 License: Revised BSD License, see LICENSE file included in the project
 By: Paul Marcelis
 */
+#include <chrono>
+#include <vector>
 #include "DaRe.h"
+#include "DaReVerifier.h"
+#include "gf256.h"
+#include "DaReBufferPool.h"
+#include "DaReStrategy.h"
+#include "DaReSnapshot.h"
+#include "DaRePlanCache.h"
 
 #ifndef __DARE_DECODE_H
 #define __DARE_DECODE_H
 
-#define DARE_DECODING_BUFFERS 50 // finite number of buffers to store intermediate data point recovery results
-
 class DaReDecode {
+public:
+  // called for every data point in frame counter order, once it is received, decoded, or can never be decoded anymore
+  // phase is the recovery phase (1 received, 2-5 decoded) or 0 if the data point is lost
+  typedef void (*DeliveryCallback)(void *context, uint32_t fcntup, uint8_t *dataPoint, bool received, uint8_t phase, uint32_t delay);
+
+  // a received frame for decodeBatch(), the payload is only read
+  struct Frame {
+    uint32_t fcntup;
+    const uint8_t *payload;
+    uint8_t payloadSize;
+  };
+
+private:
+  // the parity checks of a frame, kept in the log of the lazy mode until they are needed
+  struct LoggedFrame {
+    uint32_t fcntup;
+    uint8_t W, R, D;
+    DaRe::F_VALUE enumF;
+    uint32_t parityOffset; // position of the R - 1 parity checks in parityLog
+  };
+
   uint8_t dataPointSize;
   uint32_t totalDataPoints;
   uint8_t *dataPointsReceived;
   uint32_t *dataPointsDelay;
-#if DEBUG >= 0
-  uint8_t *dataPointsDebug;
-#endif
+  uint8_t *dataPointsPhase;
+  DaReVerifier *verifier = NULL; // optional, only available when the ground truth is known
   bool *isDataPointReceived;
   uint32_t lastFcntup = 0;
   bool tryToRecover = false;
+  bool deferredElimination = false;
+  bool eliminationPending = false;
+  uint32_t eliminationFcntup = 0;
+  DeliveryCallback deliveryCallback = NULL;
+  void *deliveryContext = NULL;
+  uint32_t lastDelivered = 0;
+  DaRe::S_VALUE strategy = DaRe::S_DARE;
+  bool lazyRecovery = false;
+  std::vector<LoggedFrame> frameLog;
+  std::vector<uint8_t> parityLog;
+  uint32_t oldestMissing = 0; // the oldest data point that is not received, decoded or doomed
+  std::vector<uint8_t> scratch; // the parity checks of the current frame, reduced here instead of in the payload
+  std::vector<uint32_t> componentParent; // union-find over the data points in the buffers
+  std::vector<uint64_t> componentOrder; // component and index of every buffer in use
+  std::vector<uint64_t> componentSpan; // oldest and newest data point of every buffer
+  std::vector<uint32_t> componentBuffers; // the buffers of the component being eliminated
+  DaRePlanCache *planCache = NULL; // optional, shared with other decoders
+  std::vector<uint8_t> planValue; // the data point a plan step recovers
+  DaReMemoryBudget *memoryBudget = NULL; // optional, shared with other decoders
+  uint32_t budgetAccount = 0;
 
   int recovered = 0;
+  uint32_t malformedFrames = 0;
+  uint32_t outOfRangeReadings = 0;
   int recoverPhase[5] = { 0, 0, 0, 0, 0 };
 
-  struct buffer {
-    bool inUse = false;
-    uint32_t fcntup;
-    uint8_t *parityCheck;
-    bool *generatorLine;
-    uint8_t windowSize;
-  };
-  buffer buffers[DARE_DECODING_BUFFERS];
+  DaReBufferPool buffers; // finite number of buffers to store intermediate data point recovery results
+  DaReSnapshot snapshot; // the newest data points, for readers on other threads
 
-  void storeDataPoint(uint32_t fcntup, uint8_t *dataPoint, uint32_t currentFcntup, int phase);
-  void g2rref(bool* matrix, uint32_t width, uint32_t height, uint8_t *X);
+  template <class Strategy> bool interpretParityChecks(uint8_t *parityChecks, uint32_t fcntup, uint8_t W, uint8_t R, uint8_t D, DaRe::F_VALUE enumF);
+  int recoverFromPlan(const uint8_t *parityChecks, uint32_t fcntup, uint8_t W, uint8_t R, uint8_t D);
+  bool recoverFromParityChecks(uint8_t *parityChecks, uint32_t fcntup, uint8_t W, uint8_t R, uint8_t D, DaRe::F_VALUE enumF);
+  void logParityChecks(const uint8_t *parityChecks, uint32_t fcntup, uint8_t W, uint8_t R, uint8_t D, DaRe::F_VALUE enumF);
+  void replayParityLog();
+  void updateOldestMissing();
+  bool isRecoveryOutstanding();
+  bool isWindowComplete(uint32_t fcntup, uint8_t W);
+  void storeDataPoint(uint32_t fcntup, const uint8_t *dataPoint, uint32_t currentFcntup, int phase);
+  void g2rref(uint8_t *matrix, uint32_t width, uint32_t height, uint8_t *X);
+  void gf256rref(uint8_t *matrix, uint32_t width, uint32_t height, uint8_t *X);
   void clearBuffer(uint32_t bufferI);
+  void discardDoomedBuffers(uint32_t fcntup);
+  bool iterateBuffers(uint32_t fcntup, const std::chrono::steady_clock::time_point *deadline);
+  bool isReferencedByBuffer(uint32_t dataPointId);
+  void deliverInOrder(bool flush);
   void checkBuffersForSubmatrix(bool flushBuffers, uint32_t fcntup);
+  uint32_t findComponent(uint32_t dataPoint);
+  void eliminateComponent(const uint32_t *bufferIds, uint32_t buffersInUse, uint32_t currentOldestDataPointId, uint32_t currentNewestDataPointId, bool gf256, bool flushBuffers, uint32_t fcntup);
+  void decodeFrame(const uint8_t *payload, uint32_t fcntup);
+  double recoveryValue(uint32_t bufferI);
 
 public:
   void init(uint8_t dataPointSizeIn, uint32_t simulationLength);
   void destroy();
   void decode(DaRe::Payload payload, uint32_t fcntup);
+  void decodeBatch(const Frame *frames, size_t count);
   void displayReceivedData(uint8_t *dataToCheck);
   void displayReceivedDataIds();
   void displayResults();
   void flushBuffers();
-#if DEBUG >= 0
-  void debugData(uint32_t fcntup, uint8_t *dataPoint);
-#endif
+  void setVerifier(DaReVerifier *verifierIn);
+  void setPlanCache(DaRePlanCache *planCacheIn);
+  void setMemoryBudget(DaReMemoryBudget *budget, double priority = 1.0);
+  double leastRecoveryValue();
+  void evictLeastValuable();
+  void setDeferredElimination(bool deferred);
+  void setStrategy(DaRe::S_VALUE strategyIn);
+  void setLazyRecovery(bool lazy);
+  bool query(uint32_t fromFcntup, uint32_t toFcntup);
+  uint32_t getLoggedFrames();
+  bool hasPendingElimination();
+  bool runElimination(uint32_t budgetMicroseconds);
+  void setDeliveryCallback(DeliveryCallback callback, void *context);
+  bool isReceived(uint32_t fcntup);
+  uint8_t *getDataPoint(uint32_t fcntup);
+  uint32_t getDelay(uint32_t fcntup);
+  uint8_t getPhase(uint32_t fcntup);
+  uint32_t getBufferEvictions();
+  uint32_t getBufferAllocations();
+  uint32_t getMalformedFrames();
+  uint32_t getOutOfRangeReadings();
+  DaReSnapshot *getSnapshot();
+  size_t memoryUsage();
 };
 
 #endif
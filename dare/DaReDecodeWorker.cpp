@@ -0,0 +1,183 @@
+/*
+ / _____)             _              | |
+( (____  _____ ____ _| |_ _____  ____| |__
+ \____ \| ___ |    (_   _) ___ |/ ___)  _ \
+ _____) ) ____| | | || |_| ____( (___| | | |
+(______/|_____)_|_|_| \__)_____)\____)_| |_|
+    (C)2017 Semtech
+	
+Description: Background worker for the deferred elimination of DaRe decoders
+License: Revised BSD License, see LICENSE file included in the project
+By: Paul Marcelis
+*/
+#include "DaReDecodeWorker.h"
+
+/*
+ * start the worker thread
+ * @param budgetMicrosecondsIn - time budget for one elimination call, 0 for no limit. A session that runs out of budget is queued again
+ */
+void DaReDecodeWorker::start(uint32_t budgetMicrosecondsIn) {
+  budgetMicroseconds = budgetMicrosecondsIn;
+  running = true;
+  thread = std::thread(&DaReDecodeWorker::run, this);
+}
+
+/*
+ * stop the worker thread, pending eliminations are left in the sessions and can be finished with flush()
+ */
+void DaReDecodeWorker::stop() {
+  {
+    std::lock_guard<std::mutex> guard(queueLock);
+    running = false;
+  }
+  queueSignal.notify_all();
+  if (thread.joinable()) {
+    thread.join();
+  }
+}
+
+/*
+ * attach a decoder to the worker, the decoder is switched to deferred elimination
+ */
+DaReDecodeWorker::Session *DaReDecodeWorker::attach(DaReDecode *decoder) {
+  Session *session = new Session();
+  session->decoder = decoder;
+  decoder->setDeferredElimination(true);
+  return session;
+}
+
+/*
+ * detach a decoder from the worker, waits until the worker is done with it
+ */
+void DaReDecodeWorker::detach(Session *session) {
+  std::unique_lock<std::mutex> guard(queueLock);
+  queueSignal.wait(guard, [session] { return !session->active; });
+  if (session->queued) {
+    for (std::deque<Session *>::iterator it = queue.begin(); it != queue.end(); ++it) {
+      if (*it == session) {
+        queue.erase(it);
+        break;
+      }
+    }
+  }
+  guard.unlock();
+  delete session;
+}
+
+/*
+ * queue a session for elimination, a session is in the queue at most once so multiple pending frames share one elimination
+ */
+void DaReDecodeWorker::enqueue(Session *session) {
+  {
+    std::lock_guard<std::mutex> guard(queueLock);
+    if (session->queued) {
+      return;
+    }
+    session->queued = true;
+    queue.push_back(session);
+  }
+  queueSignal.notify_one();
+}
+
+/*
+ * decode a frame on the calling thread. Only stage 1 and stage 2 are done here, the elimination is queued.
+ * If the worker is busy with this session, the frame is copied to the inbox of the session instead of waiting
+ */
+void DaReDecodeWorker::decode(Session *session, DaRe::Payload payload, uint32_t fcntup) {
+  {
+    std::unique_lock<std::mutex> inboxGuard(session->inboxLock);
+    // frames in the inbox go first to keep the frame order
+    if (session->inbox.empty() && session->lock.try_lock()) {
+      inboxGuard.unlock();
+      session->decoder->decode(payload, fcntup);
+      bool pending = session->decoder->hasPendingElimination();
+      session->lock.unlock();
+      if (pending) {
+        enqueue(session);
+      }
+      return;
+    }
+    session->inbox.push_back((uint8_t)(fcntup >> 24));
+    session->inbox.push_back((uint8_t)(fcntup >> 16));
+    session->inbox.push_back((uint8_t)(fcntup >> 8));
+    session->inbox.push_back((uint8_t)fcntup);
+    session->inbox.push_back(payload.payloadSize);
+    session->inbox.insert(session->inbox.end(), payload.payload, payload.payload + payload.payloadSize);
+  }
+  enqueue(session);
+}
+
+/*
+ * decode the frames from the inbox of a session, the session lock must be held
+ */
+void DaReDecodeWorker::drainInbox(Session *session) {
+  std::vector<uint8_t> frames;
+  DaRe::Payload payload;
+  size_t i;
+  uint32_t fcntup;
+
+  while (true) {
+    {
+      std::lock_guard<std::mutex> inboxGuard(session->inboxLock);
+      if (session->inbox.empty()) {
+        return;
+      }
+      frames.swap(session->inbox);
+    }
+    for (i = 0; i < frames.size(); i += 5 + frames[i + 4]) {
+      fcntup = ((uint32_t)frames[i] << 24) | ((uint32_t)frames[i + 1] << 16) | ((uint32_t)frames[i + 2] << 8) | frames[i + 3];
+      payload.payloadSize = frames[i + 4];
+      payload.payload = &frames[i + 5];
+      session->decoder->decode(payload, fcntup);
+    }
+    frames.clear();
+  }
+}
+
+/*
+ * worker loop: take a session from the queue, decode the frames from its inbox and run its elimination within the budget
+ */
+void DaReDecodeWorker::run() {
+  Session *session;
+  bool done;
+
+  while (true) {
+    {
+      std::unique_lock<std::mutex> guard(queueLock);
+      queueSignal.wait(guard, [this] { return !running || !queue.empty(); });
+      if (!running) {
+        return;
+      }
+      session = queue.front();
+      queue.pop_front();
+      session->queued = false;
+      session->active = true;
+    }
+
+    {
+      std::lock_guard<std::mutex> sessionGuard(session->lock);
+      drainInbox(session);
+      done = session->decoder->runElimination(budgetMicroseconds);
+    }
+
+    {
+      std::lock_guard<std::mutex> guard(queueLock);
+      session->active = false;
+      // out of budget, continue after the other queued sessions
+      if (!done && !session->queued) {
+        session->queued = true;
+        queue.push_back(session);
+      }
+    }
+    queueSignal.notify_all();
+  }
+}
+
+/*
+ * finish all work for a session on the calling thread and flush its buffers
+ */
+void DaReDecodeWorker::flush(Session *session) {
+  std::lock_guard<std::mutex> sessionGuard(session->lock);
+  drainInbox(session);
+  session->decoder->flushBuffers();
+}
@@ -0,0 +1,55 @@
+/*
+ / _____)             _              | |
+( (____  _____ ____ _| |_ _____  ____| |__
+ \____ \| ___ |    (_   _) ___ |/ ___)  _ \
+ _____) ) ____| | | || |_| ____( (___| | | |
+(______/|_____)_|_|_| \__)_____)\____)_| |_|
+    (C)2017 Semtech
+	
+Description: Background worker for the deferred elimination of DaRe decoders
+License: Revised BSD License, see LICENSE file included in the project
+By: Paul Marcelis
+*/
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <vector>
+#include "DaReDecode.h"
+
+#ifndef __DARE_DECODE_WORKER_H
+#define __DARE_DECODE_WORKER_H
+
+class DaReDecodeWorker {
+public:
+  struct Session {
+    DaReDecode *decoder;
+    std::mutex lock; // held while the decoder state is in use
+    std::mutex inboxLock;
+    std::vector<uint8_t> inbox; // frames received while the worker held the decoder: fcntup (4 bytes), payload size (1 byte), payload
+    bool queued = false; // protected by queueLock of the worker
+    bool active = false; // protected by queueLock of the worker
+  };
+
+private:
+  std::thread thread;
+  std::mutex queueLock;
+  std::condition_variable queueSignal;
+  std::deque<Session *> queue;
+  bool running = false;
+  uint32_t budgetMicroseconds = 0;
+
+  void run();
+  void enqueue(Session *session);
+  void drainInbox(Session *session);
+
+public:
+  void start(uint32_t budgetMicrosecondsIn);
+  void stop();
+  Session *attach(DaReDecode *decoder);
+  void detach(Session *session);
+  void decode(Session *session, DaRe::Payload payload, uint32_t fcntup);
+  void flush(Session *session);
+};
+
+#endif
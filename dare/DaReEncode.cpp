@@ -18,21 +18,25 @@ By: Paul Marcelis
  * @param dataPointSizeIn - the size of the original data to be transmitted
  * @param maxR - the maximal value for code rate R that will be allowed (constrained by lorawan frame payload size). Parameter to be used for adaptive coding parameters
  * @param maxW - the maximual value for window size W (constrained by memory size in device). Parameter to be used for adaptive coding parameters
+ * @param maxK - the maximal number of readings per frame, see setK()
  */
-void DaReEncode::init(DaRe::Payload *payload, uint8_t dataPointSizeIn, DaRe::R_VALUE maxR, DaRe::W_VALUE maxW) {
+void DaReEncode::init(DaRe::Payload *payload, uint8_t dataPointSizeIn, DaRe::R_VALUE maxR, DaRe::W_VALUE maxW, uint8_t maxK) {
   MaxR = maxR;
   MaxW = maxW;
+  MaxK = (maxK < 1) ? 1 : ((maxK > DARE_MAX_K) ? DARE_MAX_K : maxK);
   DataPointSize = dataPointSizeIn;
   DataPointHistorySize = DataPointSize * DaRe::getW(MaxW);
 
-  payload->payload = new uint8_t[1 + 2 * DataPointSize*DaRe::getR(MaxR)]();
+  payload->payload = new uint8_t[1 + 2 * DataPointSize*DaRe::getR(MaxR) * MaxK]();
   DataPointHistory = new uint8_t[DataPointHistorySize]();
 }
 
 /*
-* placeholder for destroy function
+* destroy the encoder, the payload buffer belongs to the caller
 */
 void DaReEncode::destroy() {
+  delete[] DataPointHistory;
+  DataPointHistory = NULL;
 }
 
 /*
@@ -64,6 +68,46 @@ bool DaReEncode::setR(DaRe::R_VALUE inR) {
   return false;
 }
 
+/*
+* setter for the field of the parity check coefficients. F_GF256 multiplies every data point in a parity check with a pseudo-random coefficient
+*/
+void DaReEncode::setF(DaRe::F_VALUE inF) {
+  SetF = inF;
+}
+
+/*
+* setter for the coding strategy, the decoder of the device has to be set to the same strategy
+*/
+void DaReEncode::setStrategy(DaRe::S_VALUE inS) {
+  SetS = inS;
+}
+
+/*
+* setter for the degree table, see DaRe::setDegreeTable(). Any table other than 0 adds an extension byte to the header
+* @return false if the table is not set
+*/
+bool DaReEncode::setDegreeTable(uint8_t table) {
+  if (!DaRe::hasDegreeTable(table)) {
+    return false;
+  }
+  SetTable = table;
+  return true;
+}
+
+/*
+* setter for the number of readings k per frame. A frame then carries k consecutive readings and the parity checks of
+* each of them, over the W readings before it, so the data points of the code are the readings. Any k other than 1
+* adds an extension byte to the header
+* @return false if k is 0, more than the maximum given to init() or the payload at the maximal R would exceed 255 bytes
+*/
+bool DaReEncode::setK(uint8_t k) {
+  if (k < 1 || k > MaxK || 2 + DataPointSize * DaRe::getR(MaxR) * k > 255) {
+    return false;
+  }
+  SetK = k;
+  return true;
+}
+
 /*
 * getter for window size W
 */
@@ -78,16 +122,43 @@ DaRe::R_VALUE DaReEncode::getR() {
   return SetR;
 }
 
+/*
+* getter for the field of the parity check coefficients
+*/
+DaRe::F_VALUE DaReEncode::getF() {
+  return SetF;
+}
+
+/*
+* getter for the coding strategy
+*/
+DaRe::S_VALUE DaReEncode::getStrategy() {
+  return SetS;
+}
+
+/*
+* getter for the degree table
+*/
+uint8_t DaReEncode::getDegreeTable() {
+  return SetTable;
+}
+
+/*
+* getter for the number of readings per frame
+*/
+uint8_t DaReEncode::getK() {
+  return SetK;
+}
+
 /*
 * DaRe encoding fuction
 * @param transmit - the payload object to be filled by this function
-* @param dataPoint - the current to be transmitted data point
+* @param dataPoint - the current to be transmitted data point, or the k readings of the frame one after the other
 * @param fcntup - the frame counter of to be transmitted frame, used for the pseudo-random number generator
 */
 void DaReEncode::encode(DaRe::Payload *transmit, uint8_t *dataPoint, uint32_t fcntup) {
-  uint8_t dataPoint_i, R_i, W, R, windowSize, dataPointOffset;
-  uint32_t dataPointOffsetPointer;
-  bool *generatorLine;
+  uint8_t dataPoint_i, W, R, headerSize, reading_i;
+  uint32_t readingCounter;
 
 #if DEBUG >= 3
   displayCharArray(DataPointHistory, DataPointHistorySize, DataPointSize, ' ');
@@ -96,24 +167,66 @@ void DaReEncode::encode(DaRe::Payload *transmit, uint8_t *dataPoint, uint32_t fc
 
   W = DaRe::getW(SetW);
   R = DaRe::getR(SetR);
-  transmit->payloadSize = 1 + DataPointSize * R;
+  headerSize = (SetTable != 0 || SetK != 1) ? 2 : 1;
+  transmit->payloadSize = headerSize + DataPointSize * R * SetK;
 
   for (dataPoint_i = 0; dataPoint_i < transmit->payloadSize; dataPoint_i++) {
     transmit->payload[dataPoint_i] = 0;
   }
 
-  // put coding parameters R and W in the first byte
-  transmit->payload[0] = ((SetR & 0xf) << 4) | (SetW & 0xf);
+  // put coding parameters F, R and W in the first byte, and the degree table in the extension byte
+  transmit->payload[0] = (SetF << DARE_HEADER_F_SHIFT) | ((SetR & DARE_HEADER_R_MASK) << DARE_HEADER_R_SHIFT) | (SetW & DARE_HEADER_W_MASK);
+  if (headerSize == 2) {
+    transmit->payload[0] |= 1 << DARE_HEADER_X_SHIFT;
+    transmit->payload[1] = (((SetK - 1) & DARE_EXTENSION_K_MASK) << DARE_EXTENSION_K_SHIFT) | (SetTable & DARE_EXTENSION_TABLE_MASK);
+  }
+
+  // the readings come first, then the R - 1 parity checks of every reading. Reading i of frame fcntup is data point
+  // (fcntup - 1) * k + i + 1 of the code, with k = 1 that is the frame counter itself
+  for (reading_i = 0; reading_i < SetK; reading_i++) {
+    readingCounter = (fcntup - 1) * SetK + reading_i + 1;
+
+    // put the current data point in the payload
+    for (dataPoint_i = 0; dataPoint_i < DataPointSize; dataPoint_i++) {
+      transmit->payload[headerSize + DataPointSize * reading_i + dataPoint_i] = dataPoint[DataPointSize * reading_i + dataPoint_i];
+    }
+
+    // Calculate one or more parity checks to include in the payload
+    uint8_t *parityChecks = &transmit->payload[headerSize + DataPointSize * (SetK + (R - 1) * reading_i)];
+    switch (SetS) {
+    case DaRe::S_REPETITION:
+      encodeParityChecks<RepetitionStrategy>(parityChecks, readingCounter, W, R, 1);
+      break;
+    default:
+      encodeParityChecks<DaReStrategy>(parityChecks, readingCounter, W, R, DaRe::getDegree(SetTable, SetW));
+    }
 
-  // put the current data point in the payload
-  for (dataPoint_i = 0; dataPoint_i < DataPointSize; dataPoint_i++) {
-    transmit->payload[1 + dataPoint_i] = dataPoint[dataPoint_i];
+    // Write new data point to history, the next readings and frames are coded over it
+    for (dataPoint_i = 0; dataPoint_i < DataPointSize; dataPoint_i++) {
+      DataPointHistory[((readingCounter - 1) * DataPointSize + dataPoint_i) % DataPointHistorySize] = dataPoint[DataPointSize * reading_i + dataPoint_i];
+    }
   }
+}
+
+/*
+* Calculate the R - 1 parity checks of a frame with the generator lines of a coding strategy
+* @param parityChecks - the position of the parity checks in the payload, after the current data point
+* @param fcntup - the frame counter of to be transmitted frame
+* @param W - window size
+* @param R - code rate
+* @param D - degree, number of data points per parity check
+*/
+template <class Strategy>
+void DaReEncode::encodeParityChecks(uint8_t *parityChecks, uint32_t fcntup, uint8_t W, uint8_t R, uint8_t D) {
+  uint8_t dataPoint_i, R_i, windowSize, dataPointOffset;
+  uint32_t dataPointOffsetPointer;
+  bool *generatorLine;
+  uint8_t *coefficients;
 
-  // Calculate one or more parity checks to include in the payload
   windowSize = DaRe::getWindowSize(W, fcntup); // Limit window size to number of previous data points
   for (R_i = 0; R_i < R - 1; R_i++) {
-    generatorLine = DaRe::prlg(W, fcntup, R_i);
+    generatorLine = Strategy::generatorLine(W, fcntup, R_i, D);
+    coefficients = (SetF == DaRe::F_GF256) ? DaRe::prcg(W, fcntup, R_i) : NULL;
 #if DEBUG >= 3
     displayBoolArray(generatorLine, windowSize);
     std::cout << std::endl;
@@ -123,18 +236,20 @@ void DaReEncode::encode(DaRe::Payload *transmit, uint8_t *dataPoint, uint32_t fc
       // If there is a one, XOR a previous data point with
       if (generatorLine[dataPointOffset - 1] == 1) {
         dataPointOffsetPointer = (((fcntup - 1) - dataPointOffset) * DataPointSize) % DataPointHistorySize; // Calculate pointer for previous data point
+        if (coefficients != NULL) {
+          // multiply with the coefficient and add it
+          GF256::mulAdd(&parityChecks[DataPointSize * R_i], &DataPointHistory[dataPointOffsetPointer], coefficients[dataPointOffset - 1], DataPointSize);
+          continue;
+        }
         for (dataPoint_i = 0; dataPoint_i < DataPointSize; dataPoint_i++) {
 #if DEBUG >= 3
           std::cout << std::hex << (unsigned int)DataPointHistory[dataPointOffsetPointer + dataPoint_i] << std::endl;
 #endif
-          transmit->payload[1 + DataPointSize * (1 + R_i) + dataPoint_i] ^= DataPointHistory[dataPointOffsetPointer + dataPoint_i]; // XOR it
+          parityChecks[DataPointSize * R_i + dataPoint_i] ^= DataPointHistory[dataPointOffsetPointer + dataPoint_i]; // XOR it
         }
       }
     }
-  }
-
-  // Write new data point to history, for debugging purposes
-  for (dataPoint_i = 0; dataPoint_i < DataPointSize; dataPoint_i++) {
-    DataPointHistory[((fcntup - 1) * DataPointSize + dataPoint_i) % DataPointHistorySize] = dataPoint[dataPoint_i];
+    delete[] generatorLine;
+    delete[] coefficients;
   }
 }
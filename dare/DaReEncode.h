@@ -11,6 +11,8 @@ License: Revised BSD License, see LICENSE file included in the project
 By: Paul Marcelis
 */
 #include "DaRe.h"
+#include "gf256.h"
+#include "DaReStrategy.h"
 
 #ifndef __DARE_ENCODE_H
 #define __DARE_ENCODE_H
@@ -18,17 +20,31 @@ By: Paul Marcelis
 class DaReEncode {
   DaRe::R_VALUE MaxR, SetR;
   DaRe::W_VALUE MaxW, SetW;
+  DaRe::F_VALUE SetF = DaRe::F_GF2;
+  DaRe::S_VALUE SetS = DaRe::S_DARE;
+  uint8_t SetTable = 0;
+  uint8_t MaxK = 1, SetK = 1;
   uint8_t DataPointSize;
   uint8_t *DataPointHistory;
   uint32_t DataPointHistorySize;
 
+  template <class Strategy> void encodeParityChecks(uint8_t *parityChecks, uint32_t fcntup, uint8_t W, uint8_t R, uint8_t D);
+
 public:
-  void init(DaRe::Payload *payload, uint8_t dataPointSizeIn, DaRe::R_VALUE maxR, DaRe::W_VALUE maxW);
+  void init(DaRe::Payload *payload, uint8_t dataPointSizeIn, DaRe::R_VALUE maxR, DaRe::W_VALUE maxW, uint8_t maxK = 1);
   bool set(DaRe::R_VALUE setR, DaRe::W_VALUE setW);
   bool setR(DaRe::R_VALUE setR);
   bool setW(DaRe::W_VALUE setW);
+  void setF(DaRe::F_VALUE setF);
+  void setStrategy(DaRe::S_VALUE setS);
+  bool setDegreeTable(uint8_t table);
+  bool setK(uint8_t k);
   DaRe::R_VALUE getR();
   DaRe::W_VALUE getW();
+  DaRe::F_VALUE getF();
+  DaRe::S_VALUE getStrategy();
+  uint8_t getDegreeTable();
+  uint8_t getK();
   void encode(DaRe::Payload *transmit, uint8_t *dataPoint, uint32_t fcntup);
   void destroy();
 };
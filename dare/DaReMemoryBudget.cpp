@@ -0,0 +1,161 @@
+/*
+ / _____)             _              | |
+( (____  _____ ____ _| |_ _____  ____| |__
+ \____ \| ___ |    (_   _) ___ |/ ___)  _ \
+ _____) ) ____| | | || |_| ____( (___| | | |
+(______/|_____)_|_|_| \__)_____)\____)_| |_|
+    (C)2017 Semtech
+	
+Description: Memory budget for the pending parity checks of many decoders
+License: Revised BSD License, see LICENSE file included in the project
+By: Paul Marcelis
+*/
+#include "DaReMemoryBudget.h"
+#include "DaReDecode.h"
+
+/*
+ * initialize a budget without decoders
+ * @param limitBytes - bytes that the parity checks of all attached decoders may take together
+ */
+void DaReMemoryBudget::init(size_t limitBytes) {
+  limit = limitBytes;
+}
+
+/*
+ * forget all accounts, the decoders have to be destroyed or detached first
+ */
+void DaReMemoryBudget::destroy() {
+  accounts.clear();
+  freeAccounts.clear();
+  active.clear();
+  used = 0;
+}
+
+/*
+ * open an account for a decoder, see DaReDecode::setMemoryBudget()
+ * @param decoder - the decoder, which evicts its own parity checks when asked
+ * @param priority - weight of the recovery value of its parity checks, 1 for a normal device
+ * @return the account number
+ */
+uint32_t DaReMemoryBudget::attach(DaReDecode *decoder, double priority) {
+  uint32_t account;
+  if (!freeAccounts.empty()) {
+    account = freeAccounts.back();
+    freeAccounts.pop_back();
+  } else {
+    account = (uint32_t)accounts.size();
+    accounts.push_back(Account());
+  }
+  accounts[account].decoder = decoder;
+  accounts[account].priority = priority;
+  accounts[account].bytes = 0;
+  return account;
+}
+
+/*
+ * close the account of a decoder, after all of its parity checks are credited
+ */
+void DaReMemoryBudget::detach(uint32_t account) {
+  credit(account, accounts[account].bytes);
+  accounts[account].decoder = NULL;
+  freeAccounts.push_back(account);
+}
+
+/*
+ * charge the account of a decoder for a new parity check
+ */
+void DaReMemoryBudget::charge(uint32_t account, size_t bytes) {
+  if (accounts[account].bytes == 0 && bytes > 0) {
+    accounts[account].activePosition = (uint32_t)active.size();
+    active.push_back(account);
+  }
+  accounts[account].bytes += bytes;
+  used += bytes;
+  if (used > peak) {
+    peak = used;
+  }
+}
+
+/*
+ * credit the account of a decoder for a released parity check
+ */
+void DaReMemoryBudget::credit(uint32_t account, size_t bytes) {
+  uint32_t position;
+  if (bytes == 0) {
+    return;
+  }
+  accounts[account].bytes -= bytes;
+  used -= bytes;
+  if (accounts[account].bytes == 0) {
+    position = accounts[account].activePosition;
+    active[position] = active.back();
+    accounts[active[position]].activePosition = position;
+    active.pop_back();
+  }
+}
+
+/*
+ * evict parity checks until the decoders fit in the budget again. Every eviction compares the least valuable parity
+ * check of DARE_BUDGET_SAMPLES random decoders with pending parity checks, or of all of them if there are fewer
+ */
+void DaReMemoryBudget::enforce() {
+  uint32_t sample_i, samples, account, victim;
+  double value, lowest, fairShare;
+
+  while (used > limit && !active.empty()) {
+    samples = (active.size() < DARE_BUDGET_SAMPLES) ? (uint32_t)active.size() : DARE_BUDGET_SAMPLES;
+    fairShare = (double)limit / active.size();
+    victim = active[0];
+    lowest = -1;
+    for (sample_i = 0; sample_i < samples; sample_i++) {
+      account = (samples == active.size()) ? active[sample_i] : active[nextRandom() % active.size()];
+      value = accounts[account].priority * accounts[account].decoder->leastRecoveryValue();
+      if (accounts[account].bytes > fairShare) {
+        value *= fairShare / accounts[account].bytes;
+      }
+      if (lowest < 0 || value < lowest) {
+        lowest = value;
+        victim = account;
+      }
+    }
+    accounts[victim].decoder->evictLeastValuable();
+    evictions++;
+  }
+}
+
+uint32_t DaReMemoryBudget::nextRandom() {
+  // xorshift32, the sampling only has to be spread out, not unpredictable
+  random ^= random << 13;
+  random ^= random >> 17;
+  random ^= random << 5;
+  return random;
+}
+
+/*
+ * getter for the number of bytes the parity checks of all decoders may take
+ */
+size_t DaReMemoryBudget::getLimit() {
+  return limit;
+}
+
+/*
+ * getter for the number of bytes the parity checks of all decoders take now
+ */
+size_t DaReMemoryBudget::getUsed() {
+  return used;
+}
+
+/*
+ * getter for the highest number of bytes charged at once. The budget is enforced after every frame, so this is at
+ * most the limit plus what the parity checks of one frame add
+ */
+size_t DaReMemoryBudget::getPeak() {
+  return peak;
+}
+
+/*
+ * getter for the number of parity checks evicted to stay within the budget
+ */
+uint32_t DaReMemoryBudget::getEvictions() {
+  return evictions;
+}
@@ -0,0 +1,67 @@
+/*
+ / _____)             _              | |
+( (____  _____ ____ _| |_ _____  ____| |__
+ \____ \| ___ |    (_   _) ___ |/ ___)  _ \
+ _____) ) ____| | | || |_| ____( (___| | | |
+(______/|_____)_|_|_| \__)_____)\____)_| |_|
+    (C)2017 Semtech
+	
+Description: Memory budget for the pending parity checks of many decoders
+License: Revised BSD License, see LICENSE file included in the project
+By: Paul Marcelis
+*/
+#include <vector>
+#include "DaRe.h"
+
+#ifndef __DARE_MEMORY_BUDGET_H
+#define __DARE_MEMORY_BUDGET_H
+
+#define DARE_BUDGET_SAMPLES 8 // decoders compared per eviction
+
+class DaReDecode;
+
+/*
+ * The buffer pool of every decoder is limited on its own, but a server with many decoders also needs a limit on all
+ * of them together, for example after a network-wide outage when every session holds parity checks at once. The
+ * decoders attached to a budget charge it for every parity check in their buffers. After a frame the budget evicts
+ * parity checks until the total fits again, the one with the lowest expected recovery value of a few sampled
+ * decoders first. The value of a parity check is the priority of its device, times the part of the DARE_MAX_W
+ * frames left before its oldest data point is doomed, divided by the number of other equations it still needs. A
+ * decoder that holds more than an equal share of the budget has its values scaled down, so that a few sessions with
+ * long outages cannot push out the parity checks of all others.
+ * Not thread safe: the decoders of a budget have to run on the same thread, give every worker thread its own budget
+ */
+class DaReMemoryBudget {
+  struct Account {
+    DaReDecode *decoder;
+    double priority;
+    size_t bytes;
+    uint32_t activePosition; // position in active, if bytes > 0
+  };
+
+  std::vector<Account> accounts;
+  std::vector<uint32_t> freeAccounts;
+  std::vector<uint32_t> active; // the accounts with pending parity checks
+  size_t limit = 0;
+  size_t used = 0;
+  size_t peak = 0;
+  uint32_t evictions = 0;
+  uint32_t random = 1;
+
+  uint32_t nextRandom();
+
+public:
+  void init(size_t limitBytes);
+  void destroy();
+  uint32_t attach(DaReDecode *decoder, double priority);
+  void detach(uint32_t account);
+  void charge(uint32_t account, size_t bytes);
+  void credit(uint32_t account, size_t bytes);
+  void enforce();
+  size_t getLimit();
+  size_t getUsed();
+  size_t getPeak();
+  uint32_t getEvictions();
+};
+
+#endif
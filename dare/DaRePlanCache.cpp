@@ -0,0 +1,180 @@
+/*
+ / _____)             _              | |
+( (____  _____ ____ _| |_ _____  ____| |__
+ \____ \| ___ |    (_   _) ___ |/ ___)  _ \
+ _____) ) ____| | | || |_| ____( (___| | | |
+(______/|_____)_|_|_| \__)_____)\____)_| |_|
+    (C)2017 Semtech
+	
+Description: Cache of decode plans, shared by the sessions that decode with the same coding parameters
+License: Revised BSD License, see LICENSE file included in the project
+By: Paul Marcelis
+*/
+#include <mutex>
+#include "DaRePlanCache.h"
+#include "DaReStrategy.h"
+
+/*
+ * initialize an empty cache
+ * @param capacityIn - maximal number of plans
+ */
+void DaRePlanCache::init(size_t capacityIn) {
+  capacity = capacityIn;
+  plans.reserve(capacity);
+}
+
+/*
+ * remove all plans, no decoder may use the cache anymore
+ */
+void DaRePlanCache::destroy() {
+  std::unique_lock<std::shared_timed_mutex> guard(lock);
+  plans.clear();
+}
+
+/*
+ * the phase of a frame counter within the period of the generator lines of a strategy
+ */
+uint32_t DaRePlanCache::getPhase(DaRe::S_VALUE strategy, uint32_t fcntup) {
+  return (strategy == DaRe::S_REPETITION) ? 0 : fcntup % DARE_PLAN_PERIOD;
+}
+
+/*
+ * Find the plan for the parity checks of a frame with a full window, computing it if it is not in the cache yet. The
+ * plan stays valid until destroy()
+ * @param strategy - coding strategy of the session
+ * @param W - window size, equal to the window size of the frame
+ * @param fcntup - frame counter of the frame
+ * @param R - code rate
+ * @param D - degree, number of data points per parity check
+ * @param lossBitmap - bit offset - 1 is set if the data point offset frames before the frame is missing
+ * @return the plan, or NULL if the cache is full
+ */
+const DaRePlanCache::Plan *DaRePlanCache::getPlan(DaRe::S_VALUE strategy, uint8_t W, uint32_t fcntup, uint8_t R, uint8_t D, uint64_t lossBitmap) {
+  Key key = { lossBitmap, getPhase(strategy, fcntup), W, R, D, (uint8_t)strategy };
+  {
+    std::shared_lock<std::shared_timed_mutex> guard(lock);
+    std::unordered_map<Key, Plan, KeyHash>::const_iterator found = plans.find(key);
+    if (found != plans.end()) {
+      hits++;
+      return &found->second;
+    }
+    if (plans.size() >= capacity) {
+      misses++;
+      return NULL;
+    }
+  }
+  misses++;
+
+  // the plan is built outside the lock, another thread may add the same plan in the meantime and then that one is kept
+  Plan plan;
+  if (strategy == DaRe::S_REPETITION) {
+    buildPlan<RepetitionStrategy>(plan, W, fcntup, R, 1, lossBitmap);
+  } else {
+    buildPlan<DaReStrategy>(plan, W, fcntup, R, D, lossBitmap);
+  }
+  std::unique_lock<std::shared_timed_mutex> guard(lock);
+  if (plans.size() >= capacity) {
+    return NULL;
+  }
+  return &plans.emplace(key, std::move(plan)).first->second;
+}
+
+/*
+ * Eliminate the parity checks of a frame in GF(2) over its missing data points. Every row keeps track of the parity
+ * checks and the known data points it is the sum of, so a row with one missing data point left is a step of the plan
+ */
+template <class Strategy>
+void DaRePlanCache::buildPlan(Plan &plan, uint8_t W, uint32_t fcntup, uint8_t R, uint8_t D, uint64_t lossBitmap) {
+  // at most R - 1 = 4 parity checks per frame
+  uint64_t missing[DaRe::R_1_5 + 1], known[DaRe::R_1_5 + 1], swap;
+  uint8_t parity[DaRe::R_1_5 + 1], swapParity;
+  uint8_t R_i, row_i, rows = R - 1, pivots = 0, offset, missingCount = 0;
+  bool *generatorLine;
+
+  for (R_i = 0; R_i < rows; R_i++) {
+    generatorLine = Strategy::generatorLine(W, fcntup, R_i, D);
+    missing[R_i] = 0;
+    known[R_i] = 0;
+    parity[R_i] = (uint8_t)(1 << R_i);
+    for (offset = 1; offset <= W; offset++) {
+      if (generatorLine[offset - 1] == 1) {
+        if ((lossBitmap >> (offset - 1)) & 1) {
+          missing[R_i] |= 1ULL << (offset - 1);
+        } else {
+          known[R_i] |= 1ULL << (offset - 1);
+        }
+      }
+    }
+    delete[] generatorLine;
+  }
+
+  // Gauss-Jordan elimination, one missing data point per column
+  for (offset = 1; offset <= W && pivots < rows; offset++) {
+    uint64_t column = 1ULL << (offset - 1);
+    if (!(lossBitmap & column)) {
+      continue;
+    }
+    for (row_i = pivots; row_i < rows && !(missing[row_i] & column); row_i++);
+    if (row_i == rows) {
+      continue;
+    }
+    swap = missing[row_i]; missing[row_i] = missing[pivots]; missing[pivots] = swap;
+    swap = known[row_i]; known[row_i] = known[pivots]; known[pivots] = swap;
+    swapParity = parity[row_i]; parity[row_i] = parity[pivots]; parity[pivots] = swapParity;
+    for (row_i = 0; row_i < rows; row_i++) {
+      if (row_i != pivots && (missing[row_i] & column)) {
+        missing[row_i] ^= missing[pivots];
+        known[row_i] ^= known[pivots];
+        parity[row_i] ^= parity[pivots];
+      }
+    }
+    pivots++;
+  }
+
+  // only a plan that recovers the whole window is worth keeping, otherwise the parity checks have to go to the buffers
+  for (row_i = 0; row_i < pivots; row_i++) {
+    if ((missing[row_i] & (missing[row_i] - 1)) != 0) {
+      plan.steps.clear();
+      return;
+    }
+    Step step;
+    for (offset = 1; !((missing[row_i] >> (offset - 1)) & 1); offset++);
+    step.offset = offset;
+    step.parityMask = parity[row_i];
+    for (offset = 1; offset <= W; offset++) {
+      if ((known[row_i] >> (offset - 1)) & 1) {
+        step.known.push_back(offset);
+      }
+    }
+    plan.steps.push_back(step);
+  }
+  for (offset = 1; offset <= W; offset++) {
+    missingCount += (lossBitmap >> (offset - 1)) & 1;
+  }
+  plan.complete = plan.steps.size() == missingCount;
+  if (!plan.complete) {
+    plan.steps.clear();
+  }
+}
+
+/*
+ * getter for the number of plans in the cache
+ */
+size_t DaRePlanCache::size() {
+  std::shared_lock<std::shared_timed_mutex> guard(lock);
+  return plans.size();
+}
+
+/*
+ * getter for the number of requests answered from the cache
+ */
+uint64_t DaRePlanCache::getHits() {
+  return hits;
+}
+
+/*
+ * getter for the number of requests that needed a new plan or found the cache full
+ */
+uint64_t DaRePlanCache::getMisses() {
+  return misses;
+}
@@ -0,0 +1,81 @@
+/*
+ / _____)             _              | |
+( (____  _____ ____ _| |_ _____  ____| |__
+ \____ \| ___ |    (_   _) ___ |/ ___)  _ \
+ _____) ) ____| | | || |_| ____( (___| | | |
+(______/|_____)_|_|_| \__)_____)\____)_| |_|
+    (C)2017 Semtech
+	
+Description: Cache of decode plans, shared by the sessions that decode with the same coding parameters
+License: Revised BSD License, see LICENSE file included in the project
+By: Paul Marcelis
+*/
+#include <vector>
+#include <unordered_map>
+#include <shared_mutex>
+#include <atomic>
+#include "DaRe.h"
+
+#ifndef __DARE_PLAN_CACHE_H
+#define __DARE_PLAN_CACHE_H
+
+#define DARE_PLAN_PERIOD 64770 // the generator lines of DaRe::prlg() repeat after lcm(255, 254) frames
+#define DARE_PLAN_CACHE_CAPACITY 65536 // default maximal number of plans
+
+/*
+ * The generator lines of a frame only depend on R, W, the degree and the phase of the frame counter, so sessions with
+ * the same coding parameters keep meeting the same few missing data points in the same windows. A plan is the outcome
+ * of the elimination of the parity checks of one frame for one loss pattern in its window: for every missing data
+ * point, which parity checks and which known data points to XOR. Plans are computed on the first request and never
+ * change after, so any number of sessions and threads can apply them. When the cache is full, no plans are added and
+ * the decoders fall back on the general decoding
+ */
+class DaRePlanCache {
+public:
+  // the data point offset frames back is the XOR of the parity checks in parityMask and the known data points at the offsets in known
+  struct Step {
+    uint8_t offset;
+    uint8_t parityMask;
+    std::vector<uint8_t> known;
+  };
+  struct Plan {
+    bool complete = false; // all missing data points of the window are recovered, otherwise there are no steps
+    std::vector<Step> steps;
+  };
+
+private:
+  struct Key {
+    uint64_t lossBitmap; // bit offset - 1 is set if the data point offset frames back is missing
+    uint32_t phase;
+    uint8_t W, R, D, strategy;
+    bool operator==(const Key &other) const {
+      return lossBitmap == other.lossBitmap && phase == other.phase && W == other.W && R == other.R && D == other.D && strategy == other.strategy;
+    }
+  };
+  struct KeyHash {
+    size_t operator()(const Key &key) const {
+      uint64_t hash = key.lossBitmap * 0x9e3779b97f4a7c15ULL;
+      hash ^= ((uint64_t)key.phase << 32) | ((uint32_t)key.W << 24) | ((uint32_t)key.R << 16) | ((uint32_t)key.D << 8) | key.strategy;
+      return (size_t)(hash ^ (hash >> 29));
+    }
+  };
+
+  std::unordered_map<Key, Plan, KeyHash> plans;
+  std::shared_timed_mutex lock; // shared while looking up, exclusive while adding a plan
+  size_t capacity = 0;
+  std::atomic<uint64_t> hits{ 0 };
+  std::atomic<uint64_t> misses{ 0 };
+
+  template <class Strategy> void buildPlan(Plan &plan, uint8_t W, uint32_t fcntup, uint8_t R, uint8_t D, uint64_t lossBitmap);
+
+public:
+  void init(size_t capacityIn = DARE_PLAN_CACHE_CAPACITY);
+  void destroy();
+  const Plan *getPlan(DaRe::S_VALUE strategy, uint8_t W, uint32_t fcntup, uint8_t R, uint8_t D, uint64_t lossBitmap);
+  static uint32_t getPhase(DaRe::S_VALUE strategy, uint32_t fcntup);
+  size_t size();
+  uint64_t getHits();
+  uint64_t getMisses();
+};
+
+#endif
@@ -0,0 +1,171 @@
+/*
+ / _____)             _              | |
+( (____  _____ ____ _| |_ _____  ____| |__
+ \____ \| ___ |    (_   _) ___ |/ ___)  _ \
+ _____) ) ____| | | || |_| ____( (___| | | |
+(______/|_____)_|_|_| \__)_____)\____)_| |_|
+    (C)2017 Semtech
+	
+Description: Pre-coding of slowly changing sensor readings into small data points
+License: Revised BSD License, see LICENSE file included in the project
+By: Paul Marcelis
+*/
+#include <string.h>
+#include "DaRePrecode.h"
+
+/*
+ * initialise the pre-coding, both sides need the same parameters
+ * @param readingBitsIn - width of a reading, at most 32
+ * @param bitsIn - low bits of a reading sent in a data point, at most readingBitsIn
+ * @param readingsPerDataPointIn - number of readings packed in one data point
+ * @param keyIntervalIn - frames between key data points, 0 for none. Since a key is followed by a data point with
+ *   readings, the interval is at least 2
+ */
+void DaRePrecode::init(uint8_t readingBitsIn, uint8_t bitsIn, uint8_t readingsPerDataPointIn, uint32_t keyIntervalIn) {
+  uint8_t keySize;
+
+  readingBits = (readingBitsIn > 32) ? 32 : readingBitsIn;
+  bits = (bitsIn > readingBits) ? readingBits : bitsIn;
+  readingsPerDataPoint = (readingsPerDataPointIn == 0) ? 1 : readingsPerDataPointIn;
+  // a key carries the high bits, there are none if the readings are sent in full
+  keyInterval = (bits == readingBits) ? 0 : ((keyIntervalIn == 1) ? 2 : keyIntervalIn);
+  keySize = (keyInterval > 0) ? (uint8_t)((readingBits - bits + 7) / 8) : 0;
+  dataPointSize = (uint8_t)((bits * readingsPerDataPoint + 7) / 8);
+  dataPointSize = (keySize > dataPointSize) ? keySize : dataPointSize;
+
+  group = new uint32_t[readingsPerDataPoint]();
+  groupCount = 0;
+  nextFcntup = 1;
+  keyPending = false;
+  reference = 0;
+  referenceValid = false;
+  keyFcntup = 0;
+}
+
+/*
+ * destroy the pre-coding, readings of a data point that is not complete are dropped
+ */
+void DaRePrecode::destroy() {
+  delete[] group;
+  group = NULL;
+}
+
+/*
+ * getter for the data point size, the size DaReEncode and DaReDecode are initialised with
+ */
+uint8_t DaRePrecode::getDataPointSize() {
+  return dataPointSize;
+}
+
+uint8_t DaRePrecode::getReadingsPerDataPoint() {
+  return readingsPerDataPoint;
+}
+
+/*
+ * whether the data point of a frame is a key, which carries no readings
+ */
+bool DaRePrecode::isKey(uint32_t fcntup) {
+  return keyInterval > 0 && (fcntup - 1) % keyInterval == 0;
+}
+
+/*
+ * write the lowest width bits of a value into a data point, least significant bit first
+ */
+void DaRePrecode::writeBits(uint8_t *dataPoint, uint32_t offset, uint8_t width, uint32_t value) {
+  uint8_t bit_i;
+  for (bit_i = 0; bit_i < width; bit_i++) {
+    if ((value >> bit_i) & 1) {
+      dataPoint[(offset + bit_i) / 8] |= (uint8_t)(1 << ((offset + bit_i) % 8));
+    }
+  }
+}
+
+uint32_t DaRePrecode::readBits(const uint8_t *dataPoint, uint32_t offset, uint8_t width) {
+  uint32_t value = 0;
+  uint8_t bit_i;
+  for (bit_i = 0; bit_i < width; bit_i++) {
+    value |= (uint32_t)((dataPoint[(offset + bit_i) / 8] >> ((offset + bit_i) % 8)) & 1) << bit_i;
+  }
+  return value;
+}
+
+/*
+ * the reading with the given low bits that is closest to the last delivered reading, modulo 2^readingBits
+ */
+uint32_t DaRePrecode::closestReading(uint32_t lowBits) {
+  uint64_t range = (uint64_t)1 << bits, readingMask = ((uint64_t)1 << readingBits) - 1;
+  int64_t difference = (int64_t)((lowBits - reference) & (range - 1));
+  if (difference >= (int64_t)(range / 2)) {
+    difference -= (int64_t)range;
+  }
+  return (uint32_t)(((uint64_t)reference + (uint64_t)difference) & readingMask);
+}
+
+/*
+ * Add a reading on the device. Once a data point is full it is written, preceded by a key data point if the frame
+ * counter of the data point is a key position. The data points have to be encoded with successive frame counters,
+ * starting at 1
+ * @param reading - the reading, only the lowest readingBits bits are used
+ * @param dataPoints - room for two data points
+ * @return the number of data points written, 0, 1 or 2
+ */
+uint8_t DaRePrecode::pack(uint32_t reading, uint8_t *dataPoints) {
+  uint8_t written = 0, reading_i;
+
+  if (groupCount == 0) {
+    keyPending = isKey(nextFcntup);
+  }
+  group[groupCount++] = reading;
+  if (groupCount < readingsPerDataPoint) {
+    return 0;
+  }
+
+  memset(dataPoints, 0, 2 * dataPointSize);
+  if (keyPending) {
+    writeBits(dataPoints, 0, readingBits - bits, group[0] >> bits);
+    written++;
+    nextFcntup++;
+  }
+  for (reading_i = 0; reading_i < readingsPerDataPoint; reading_i++) {
+    writeBits(&dataPoints[written * dataPointSize], reading_i * bits, bits, group[reading_i]);
+  }
+  written++;
+  nextFcntup++;
+  groupCount = 0;
+  return written;
+}
+
+/*
+ * Get the readings from a data point on the network server, for every data point in frame counter order, including
+ * the lost ones. The delivery callback of DaReDecode or DaReSession calls in this order
+ * @param fcntup - frame counter of the data point
+ * @param dataPoint - the received or decoded data point
+ * @param received - false if the data point is lost
+ * @param readings - room for getReadingsPerDataPoint() readings
+ * @return the number of readings, 0 for a key or a lost data point
+ */
+uint8_t DaRePrecode::unpack(uint32_t fcntup, const uint8_t *dataPoint, bool received, uint32_t *readings) {
+  uint8_t reading_i;
+  uint32_t lowBits;
+
+  if (!received) {
+    return 0;
+  }
+  if (isKey(fcntup)) {
+    keyFcntup = fcntup + 1;
+    keyValue = readBits(dataPoint, 0, readingBits - bits);
+    return 0;
+  }
+
+  for (reading_i = 0; reading_i < readingsPerDataPoint; reading_i++) {
+    lowBits = readBits(dataPoint, reading_i * bits, bits);
+    if (reading_i == 0 && keyFcntup == fcntup) {
+      reference = (uint32_t)((((uint64_t)keyValue << bits) | lowBits) & (((uint64_t)1 << readingBits) - 1));
+    } else {
+      reference = referenceValid ? closestReading(lowBits) : lowBits;
+    }
+    referenceValid = true;
+    readings[reading_i] = reference;
+  }
+  return readingsPerDataPoint;
+}
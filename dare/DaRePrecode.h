@@ -0,0 +1,61 @@
+/*
+ / _____)             _              | |
+( (____  _____ ____ _| |_ _____  ____| |__
+ \____ \| ___ |    (_   _) ___ |/ ___)  _ \
+ _____) ) ____| | | || |_| ____( (___| | | |
+(______/|_____)_|_|_| \__)_____)\____)_| |_|
+    (C)2017 Semtech
+	
+Description: Pre-coding of slowly changing sensor readings into small data points
+License: Revised BSD License, see LICENSE file included in the project
+By: Paul Marcelis
+*/
+#include <stdint.h>
+
+#ifndef __DARE_PRECODE_H
+#define __DARE_PRECODE_H
+
+/*
+ * Optional stage in front of DaReEncode and after DaReDecode. A data point holds only the low bits of one or more
+ * successive readings, packed back to back. After decoding, a reading is the value closest to the previous delivered
+ * reading with the same low bits, which is correct as long as a reading differs less than half the range of the low
+ * bits from the previous delivered reading, also across lost data points. So each data point is decoded on its own and
+ * the order in which DaReDecode recovers them does not matter, only the delivery in frame counter order.
+ * Every keyInterval frames, a key data point carries the high bits of the first reading of the next data point, to
+ * start a session and to correct a wrong reading after a large jump or a long run of lost frames.
+ * One instance is used on each side, the device packs and the network server unpacks
+ */
+class DaRePrecode {
+  uint8_t readingBits = 16; // width of a reading, readings are computed modulo 2^readingBits
+  uint8_t bits = 16; // low bits of a reading in a data point
+  uint8_t readingsPerDataPoint = 1;
+  uint8_t dataPointSize = 2;
+  uint32_t keyInterval = 0;
+
+  // pack side
+  uint32_t *group = NULL; // readings of the data point being filled
+  uint8_t groupCount = 0;
+  uint32_t nextFcntup = 1;
+  bool keyPending = false;
+
+  // unpack side
+  uint32_t reference = 0; // the last delivered reading
+  bool referenceValid = false;
+  uint32_t keyFcntup = 0; // frame counter of the data point the last key belongs to
+  uint32_t keyValue = 0;
+
+  static void writeBits(uint8_t *dataPoint, uint32_t offset, uint8_t width, uint32_t value);
+  static uint32_t readBits(const uint8_t *dataPoint, uint32_t offset, uint8_t width);
+  uint32_t closestReading(uint32_t lowBits);
+
+public:
+  void init(uint8_t readingBitsIn, uint8_t bitsIn, uint8_t readingsPerDataPointIn, uint32_t keyIntervalIn);
+  void destroy();
+  uint8_t getDataPointSize();
+  uint8_t getReadingsPerDataPoint();
+  bool isKey(uint32_t fcntup);
+  uint8_t pack(uint32_t reading, uint8_t *dataPoints);
+  uint8_t unpack(uint32_t fcntup, const uint8_t *dataPoint, bool received, uint32_t *readings);
+};
+
+#endif
@@ -0,0 +1,177 @@
+/*
+ / _____)             _              | |
+( (____  _____ ____ _| |_ _____  ____| |__
+ \____ \| ___ |    (_   _) ___ |/ ___)  _ \
+ _____) ) ____| | | || |_| ____( (___| | | |
+(______/|_____)_|_|_| \__)_____)\____)_| |_|
+    (C)2017 Semtech
+	
+Description: Bounded reorder window, releasing frames to a decoder in frame counter order
+License: Revised BSD License, see LICENSE file included in the project
+By: Paul Marcelis
+*/
+#include <algorithm>
+#include "DaReReorder.h"
+
+/*
+ * initialise a reorder window in front of a decoder. A frame is held back while an older frame is missing, until either
+ * more than maxDepthIn frames are held or the oldest held frame waited maxHoldIn ms. A missing frame is then
+ * considered lost and the frames behind it are released. A depth of 0 releases every frame immediately
+ * @param decoderIn - the decoder of the session, frames are released to it in frame counter order
+ * @param maxDepthIn - the maximal number of frames held back
+ * @param maxHoldIn - the maximal time in ms a frame is held back, DARE_REORDER_HOLD_FOREVER to only limit the depth
+ */
+void DaReReorder::init(DaReDecode *decoderIn, uint8_t maxDepthIn, uint32_t maxHoldIn) {
+  decoder = decoderIn;
+  maxDepth = maxDepthIn;
+  maxHold = maxHoldIn;
+  nextFcntup = 1;
+  releasedMask = 0;
+  lateFrames = 0;
+  duplicateFrames = 0;
+}
+
+/*
+ * destroy the reorder window, frames still held are dropped. Call flush() first to decode them
+ */
+void DaReReorder::destroy() {
+  std::map<uint32_t, heldFrame>::iterator it;
+  for (it = held.begin(); it != held.end(); ++it) {
+    delete[] it->second.payload;
+  }
+  held.clear();
+}
+
+/*
+ * check whether a frame older than the next expected frame was already released to the decoder. Frames too old to be
+ * remembered are not known to be released, they are passed on and the decoder decides whether their data point is new
+ */
+bool DaReReorder::isReleased(uint32_t fcntup) {
+  uint32_t age = nextFcntup - 1 - fcntup;
+  return (age < 64) && ((releasedMask >> age) & 1);
+}
+
+/*
+ * hand a frame to the decoder and remember it was released
+ */
+void DaReReorder::decodeFrame(uint8_t *payload, uint8_t payloadSize, uint32_t fcntup) {
+  DaRe::Payload frame;
+  uint32_t shift;
+
+  if (fcntup >= nextFcntup) {
+    shift = fcntup + 1 - nextFcntup;
+    releasedMask = (shift >= 64) ? 0 : (releasedMask << shift);
+    releasedMask |= 1;
+    nextFcntup = fcntup + 1;
+  } else {
+    releasedMask |= (uint64_t)1 << (nextFcntup - 1 - fcntup);
+  }
+
+  frame.payload = payload;
+  frame.payloadSize = payloadSize;
+  decoder->decode(frame, fcntup);
+}
+
+/*
+ * release a held frame to the decoder and forget it
+ */
+void DaReReorder::releaseFrame(std::map<uint32_t, heldFrame>::iterator frame) {
+  decodeFrame(frame->second.payload, frame->second.payloadSize, frame->first);
+  delete[] frame->second.payload;
+  held.erase(frame);
+}
+
+/*
+ * offer a received frame. It is released to the decoder right away if it is the next expected frame, otherwise it is
+ * held back until the missing frames arrive or the depth or hold time is exceeded.
+ * A frame arriving after newer frames were released is passed to the decoder as a late frame, a duplicate of one of
+ * the last 64 released frames is dropped
+ * @param payload - the payload of the frame, copied if the frame is held back
+ * @param fcntup - the frame counter
+ * @param now - the current time in ms
+ */
+void DaReReorder::push(DaRe::Payload payload, uint32_t fcntup, uint32_t now) {
+  heldFrame frame;
+
+  if (fcntup < nextFcntup) {
+    if (isReleased(fcntup)) {
+      duplicateFrames++;
+    } else {
+      lateFrames++;
+      decodeFrame(payload.payload, payload.payloadSize, fcntup);
+    }
+    return;
+  }
+  if (held.find(fcntup) != held.end()) {
+    duplicateFrames++;
+    return;
+  }
+
+  if (fcntup == nextFcntup && held.empty()) {
+    decodeFrame(payload.payload, payload.payloadSize, fcntup);
+    return;
+  }
+
+  frame.payload = new uint8_t[payload.payloadSize];
+  std::copy(payload.payload, payload.payload + payload.payloadSize, frame.payload);
+  frame.payloadSize = payload.payloadSize;
+  frame.arrival = now;
+  held[fcntup] = frame;
+  release(now);
+}
+
+/*
+ * release all frames that are in order, and give up on missing frames once the depth or hold time is exceeded.
+ * Call this periodically when no frames arrive to bound the hold time
+ * @param now - the current time in ms
+ */
+void DaReReorder::release(uint32_t now) {
+  std::map<uint32_t, heldFrame>::iterator it;
+  uint32_t oldestArrival;
+
+  while (!held.empty()) {
+    it = held.begin();
+    if (it->first != nextFcntup && held.size() <= maxDepth) {
+      // still waiting for a missing frame, check how long the longest waiting frame is held
+      oldestArrival = it->second.arrival;
+      for (; it != held.end(); ++it) {
+        oldestArrival = std::min(oldestArrival, it->second.arrival);
+      }
+      if (maxHold == DARE_REORDER_HOLD_FOREVER || now - oldestArrival < maxHold) {
+        break;
+      }
+      it = held.begin();
+    }
+    releaseFrame(it);
+  }
+}
+
+/*
+ * release all held frames in order, without waiting for missing frames
+ */
+void DaReReorder::flush() {
+  while (!held.empty()) {
+    releaseFrame(held.begin());
+  }
+}
+
+/*
+ * getter for the number of frames currently held back
+ */
+uint32_t DaReReorder::getHeld() {
+  return (uint32_t)held.size();
+}
+
+/*
+ * getter for the number of frames that arrived after newer frames were released
+ */
+uint32_t DaReReorder::getLateFrames() {
+  return lateFrames;
+}
+
+/*
+ * getter for the number of dropped duplicate frames
+ */
+uint32_t DaReReorder::getDuplicateFrames() {
+  return duplicateFrames;
+}
@@ -0,0 +1,53 @@
+/*
+ / _____)             _              | |
+( (____  _____ ____ _| |_ _____  ____| |__
+ \____ \| ___ |    (_   _) ___ |/ ___)  _ \
+ _____) ) ____| | | || |_| ____( (___| | | |
+(______/|_____)_|_|_| \__)_____)\____)_| |_|
+    (C)2017 Semtech
+	
+Description: Bounded reorder window, releasing frames to a decoder in frame counter order
+License: Revised BSD License, see LICENSE file included in the project
+By: Paul Marcelis
+*/
+#include <map>
+#include "DaRe.h"
+#include "DaReDecode.h"
+
+#ifndef __DARE_REORDER_H
+#define __DARE_REORDER_H
+
+#define DARE_REORDER_HOLD_FOREVER 0xffffffff // hold time to wait for a missing frame only as long as the depth allows
+
+class DaReReorder {
+  struct heldFrame {
+    uint8_t *payload;
+    uint8_t payloadSize;
+    uint32_t arrival; // time of arrival in ms
+  };
+
+  DaReDecode *decoder;
+  uint8_t maxDepth; // frames held back while waiting for a missing frame
+  uint32_t maxHold; // ms to wait for a missing frame
+  uint32_t nextFcntup; // the frame counter expected next by the decoder
+  uint64_t releasedMask; // bit i is set if frame nextFcntup - 1 - i was released to the decoder
+  std::map<uint32_t, heldFrame> held;
+  uint32_t lateFrames;
+  uint32_t duplicateFrames;
+
+  void releaseFrame(std::map<uint32_t, heldFrame>::iterator frame);
+  void decodeFrame(uint8_t *payload, uint8_t payloadSize, uint32_t fcntup);
+  bool isReleased(uint32_t fcntup);
+
+public:
+  void init(DaReDecode *decoderIn, uint8_t maxDepthIn, uint32_t maxHoldIn);
+  void destroy();
+  void push(DaRe::Payload payload, uint32_t fcntup, uint32_t now);
+  void release(uint32_t now);
+  void flush();
+  uint32_t getHeld();
+  uint32_t getLateFrames();
+  uint32_t getDuplicateFrames();
+};
+
+#endif
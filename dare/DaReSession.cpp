@@ -0,0 +1,494 @@
+/*
+ / _____)             _              | |
+( (____  _____ ____ _| |_ _____  ____| |__
+ \____ \| ___ |    (_   _) ___ |/ ___)  _ \
+ _____) ) ____| | | || |_| ____( (___| | | |
+(______/|_____)_|_|_| \__)_____)\____)_| |_|
+    (C)2017 Semtech
+	
+Description: Compact decoder state for a large number of sessions
+License: Revised BSD License, see LICENSE file included in the project
+By: Paul Marcelis
+*/
+#include <string.h>
+#include "DaReSession.h"
+
+#define SESSION_CHECK_HEADER 12 // frame counter (4 bytes) and mask (8 bytes) of a pending check, then its value
+#define SESSION_SERIALIZED_HEADER (4 + 4 + 2 + 1 + 1 + sizeof(known) + 4) // lastFcntup, lastDelivered, checkCount, dataPointSize, strategy, known, rejectedChecks
+
+/*
+ * initialise an empty session
+ * @param dataPointSizeIn - the size in bytes of the data points
+ */
+void DaReSession::init(uint8_t dataPointSizeIn) {
+  dataPointSize = dataPointSizeIn;
+  block = new uint8_t[DARE_SESSION_WINDOW * (dataPointSize + 2) + DARE_SESSION_INLINE_CHECKS * checkSize()]();
+  memset(known, 0, sizeof(known));
+}
+
+/*
+ * destroy the session, data points that were not delivered yet are dropped, call flush() first to get them
+ */
+void DaReSession::destroy() {
+  delete[] block;
+  block = NULL;
+  std::vector<uint8_t>().swap(spill);
+  checkCount = 0;
+}
+
+/*
+ * set the coding strategy of the device, see DaReDecode::setStrategy()
+ */
+void DaReSession::setStrategy(DaRe::S_VALUE strategyIn) {
+  strategy = strategyIn;
+}
+
+/*
+ * set the callback that receives all data points in frame counter order, see DaReDecode::setDeliveryCallback()
+ */
+void DaReSession::setDeliveryCallback(DaReDecode::DeliveryCallback callback, void *context) {
+  deliveryCallback = callback;
+  deliveryContext = context;
+}
+
+/*
+ * position of the value, phase and delay of a data point in the window
+ */
+uint8_t *DaReSession::value(uint32_t dataPointId) {
+  return &block[(dataPointId % DARE_SESSION_WINDOW) * dataPointSize];
+}
+
+uint8_t *DaReSession::phase(uint32_t dataPointId) {
+  return &block[DARE_SESSION_WINDOW * dataPointSize + dataPointId % DARE_SESSION_WINDOW];
+}
+
+uint8_t *DaReSession::delay(uint32_t dataPointId) {
+  return &block[DARE_SESSION_WINDOW * (dataPointSize + 1) + dataPointId % DARE_SESSION_WINDOW];
+}
+
+/*
+ * size in bytes of a pending check record
+ */
+uint32_t DaReSession::checkSize() {
+  return SESSION_CHECK_HEADER + dataPointSize;
+}
+
+/*
+ * position of a pending check record, inline in the block or in the spill
+ */
+uint8_t *DaReSession::check(uint32_t check_i) {
+  if (check_i < DARE_SESSION_INLINE_CHECKS) {
+    return &block[DARE_SESSION_WINDOW * (dataPointSize + 2) + check_i * checkSize()];
+  }
+  return &spill[(check_i - DARE_SESSION_INLINE_CHECKS) * checkSize()];
+}
+
+/*
+ * change the number of pending checks, the spill only exists while the inline checks do not suffice
+ */
+void DaReSession::setCheckCount(uint32_t count) {
+  checkCount = (uint16_t)count;
+  if (count > DARE_SESSION_INLINE_CHECKS) {
+    spill.resize((count - DARE_SESSION_INLINE_CHECKS) * checkSize());
+  } else if (!spill.empty()) {
+    std::vector<uint8_t>().swap(spill);
+  }
+}
+
+/*
+ * whether a data point of the window is received or decoded
+ */
+bool DaReSession::isKnown(uint32_t dataPointId) {
+  if (dataPointId >= lastFcntup || dataPointId + DARE_SESSION_WINDOW < lastFcntup) {
+    return false;
+  }
+  return (known[(dataPointId % DARE_SESSION_WINDOW) / 64] >> (dataPointId % 64)) & 1;
+}
+
+/*
+ * the known data points before the newest frame as a check mask: bit j is data point lastFcntup - 2 - j
+ */
+uint64_t DaReSession::knownMask() {
+  uint64_t mask = 0;
+  uint32_t j;
+  for (j = 0; j < 64 && j + 2 <= lastFcntup; j++) {
+    if (isKnown(lastFcntup - 2 - j)) {
+      mask |= (uint64_t)1 << j;
+    }
+  }
+  return mask;
+}
+
+/*
+ * store a received or decoded data point in the window
+ */
+void DaReSession::storeDataPoint(uint32_t dataPointId, uint8_t *dataPoint, uint8_t phaseIn) {
+  memcpy(value(dataPointId), dataPoint, dataPointSize);
+  *phase(dataPointId) = phaseIn;
+  *delay(dataPointId) = (uint8_t)((lastFcntup - 1) - dataPointId);
+  known[(dataPointId % DARE_SESSION_WINDOW) / 64] |= (uint64_t)1 << (dataPointId % 64);
+}
+
+/*
+ * move the window to a new newest frame. The data points that the new frame dooms are delivered first, since their
+ * place in the window is reused
+ */
+void DaReSession::advance(uint32_t fcntup) {
+  uint32_t dataPointId;
+
+  deliverInOrder(((fcntup - 1) > DARE_MAX_W) ? ((fcntup - 1) - DARE_MAX_W) : 0);
+  if (fcntup - lastFcntup > DARE_SESSION_WINDOW) {
+    memset(known, 0, sizeof(known));
+  } else {
+    for (dataPointId = lastFcntup; dataPointId < fcntup; dataPointId++) {
+      known[(dataPointId % DARE_SESSION_WINDOW) / 64] &= ~((uint64_t)1 << (dataPointId % 64));
+    }
+  }
+  lastFcntup = fcntup;
+}
+
+/*
+ * Stage 2: remove the known data points from a parity check of a frame, and add it to the pending checks if data
+ * points are left. A parity check with a data point that is doomed or out of the window is useless
+ * @param generatorLine - the data points in the parity check
+ * @param parityCheck - the value of the parity check, reduced in place
+ * @param fcntup - frame counter of the frame of the parity check
+ * @param W - window size
+ */
+void DaReSession::addParityCheck(bool *generatorLine, uint8_t *parityCheck, uint32_t fcntup, uint8_t W) {
+  uint32_t dataPointOffset, dataPointId, shift = lastFcntup - fcntup, i;
+  uint8_t windowSize = DaRe::getWindowSize(W, fcntup);
+  uint64_t mask = 0;
+  uint8_t *record;
+
+  for (dataPointOffset = 1; dataPointOffset <= windowSize; dataPointOffset++) {
+    if (!generatorLine[dataPointOffset - 1]) {
+      continue;
+    }
+    dataPointId = (fcntup - 1) - dataPointOffset;
+    if (isKnown(dataPointId)) {
+      for (i = 0; i < dataPointSize; i++) {
+        parityCheck[i] ^= value(dataPointId)[i];
+      }
+    } else if (dataPointOffset - 1 + shift >= 64) {
+      return; // doomed
+    } else {
+      mask |= (uint64_t)1 << (dataPointOffset - 1 + shift);
+    }
+  }
+  if (mask == 0) {
+    return;
+  }
+  if ((mask & (mask - 1)) == 0) {
+    for (i = 0; ((mask >> i) & 1) == 0; i++) {
+    }
+    storeDataPoint((lastFcntup - 2) - i, parityCheck, 2); // a single data point left, recovered directly
+    return;
+  }
+  setCheckCount(checkCount + 1);
+  record = check(checkCount - 1);
+  memcpy(record, &lastFcntup, 4);
+  memcpy(record + 4, &mask, 8);
+  memcpy(record + SESSION_CHECK_HEADER, parityCheck, dataPointSize);
+}
+
+/*
+ * Stage 3 and 4: remove the known data points from the pending checks and bring them in reduced row echelon form.
+ * A check with a single data point left recovers it, the other checks stay pending, at most 64 of them
+ */
+void DaReSession::eliminate() {
+  uint64_t mask, pivotMask = 0, knownNow = knownMask(), other;
+  uint32_t check_i, other_i, recordFcntup, kept, bit, i;
+  uint8_t *record, *otherRecord;
+  bool combined[DARE_SESSION_WINDOW] = { false }; // the rank is at most 64, so at most 64 + 4 checks are pending
+  uint8_t newPhase;
+
+  // move all masks to the newest frame and reduce the known data points
+  for (check_i = 0; check_i < checkCount; check_i++) {
+    record = check(check_i);
+    memcpy(&recordFcntup, record, 4);
+    memcpy(&mask, record + 4, 8);
+    if (recordFcntup != lastFcntup) {
+      // a check that includes a data point that is doomed now can never be solved
+      mask = (lastFcntup - recordFcntup >= 64 || (mask >> (64 - (lastFcntup - recordFcntup))) != 0) ? 0 : (mask << (lastFcntup - recordFcntup));
+      memcpy(record, &lastFcntup, 4);
+    }
+    other = mask & knownNow;
+    for (bit = 0; other != 0; bit++, other >>= 1) {
+      if (other & 1) {
+        for (i = 0; i < dataPointSize; i++) {
+          record[SESSION_CHECK_HEADER + i] ^= value((lastFcntup - 2) - bit)[i];
+        }
+      }
+    }
+    mask &= ~knownNow;
+    memcpy(record + 4, &mask, 8);
+  }
+
+  // Gauss-Jordan elimination, the pivot rows stay in place. The oldest data points are eliminated first, so that
+  // only the pivot check of a data point includes it when the data point is doomed, and no other information is lost
+  for (bit = 64; bit-- > 0;) {
+    for (check_i = 0; check_i < checkCount; check_i++) {
+      memcpy(&mask, check(check_i) + 4, 8);
+      if (((mask >> bit) & 1) && (mask & pivotMask) == 0) {
+        break;
+      }
+    }
+    if (check_i == checkCount) {
+      continue;
+    }
+    pivotMask |= (uint64_t)1 << bit;
+    record = check(check_i);
+    for (other_i = 0; other_i < checkCount; other_i++) {
+      otherRecord = check(other_i);
+      memcpy(&other, otherRecord + 4, 8);
+      if (other_i == check_i || ((other >> bit) & 1) == 0) {
+        continue;
+      }
+      other ^= mask;
+      memcpy(otherRecord + 4, &other, 8);
+      for (i = 0; i < dataPointSize; i++) {
+        otherRecord[SESSION_CHECK_HEADER + i] ^= record[SESSION_CHECK_HEADER + i];
+      }
+      combined[other_i] = true;
+    }
+  }
+
+  // store the recovered data points, keep the checks with more than one data point
+  kept = 0;
+  for (check_i = 0; check_i < checkCount; check_i++) {
+    record = check(check_i);
+    memcpy(&mask, record + 4, 8);
+    if (mask != 0 && (mask & (mask - 1)) == 0) {
+      for (bit = 0; ((mask >> bit) & 1) == 0; bit++) {
+      }
+      newPhase = combined[check_i] ? 4 : 3;
+      storeDataPoint((lastFcntup - 2) - bit, record + SESSION_CHECK_HEADER, newPhase);
+    } else if (mask != 0) {
+      if (kept != check_i) {
+        memcpy(check(kept), record, checkSize());
+      }
+      kept++;
+    }
+  }
+  setCheckCount(kept);
+}
+
+/*
+ * pass data points to the delivery callback in frame counter order, up to the first missing data point that is not
+ * doomed yet
+ * @param limit - the data points before this data point id are doomed
+ */
+void DaReSession::deliverInOrder(uint32_t limit) {
+  while (lastDelivered < lastFcntup) {
+    if (isKnown(lastDelivered)) {
+      if (deliveryCallback != NULL) {
+        deliveryCallback(deliveryContext, lastDelivered + 1, value(lastDelivered), true, *phase(lastDelivered), *delay(lastDelivered));
+      }
+    } else if (lastDelivered < limit) {
+      if (deliveryCallback != NULL) {
+        deliveryCallback(deliveryContext, lastDelivered + 1, NULL, false, 0, 0);
+      }
+    } else {
+      break;
+    }
+    lastDelivered++;
+  }
+}
+
+/*
+ * Decode the payload of a frame, see DaReDecode::decode(). Frames are expected in frame counter order, the data point
+ * and the parity checks of a late frame are still used while they are in the window. Frames with k readings are
+ * decoded per reading, the frame counters of the session are then reading counters. A frame with counter 0, or with
+ * reading counters that do not fit in 32 bits, is ignored
+ * @param payload - the payload from the frame to be decoded
+ * @param fcntup - the frame counter
+ */
+void DaReSession::decode(DaRe::Payload payload, uint32_t fcntup) {
+  // a frame with k readings is decoded as k frames of one reading each, see DaReDecode::decode()
+  uint8_t k = DaRe::getK(payload.payload);
+  if (fcntup == 0 || (uint64_t)fcntup * k > 0xffffffff) {
+    return;
+  }
+  if (k > 1) {
+    uint8_t reading[256], reading_i;
+    DaRe::Payload readingPayload = { reading, 0 };
+    for (reading_i = 0; reading_i < k; reading_i++) {
+      readingPayload.payloadSize = DaRe::getReading(reading, payload.payload, reading_i, dataPointSize);
+      decode(readingPayload, (fcntup - 1) * k + reading_i + 1);
+    }
+    return;
+  }
+
+  DaRe::F_VALUE enumF = (DaRe::F_VALUE)(payload.payload[0] >> DARE_HEADER_F_SHIFT);
+  bool extension = (payload.payload[0] >> DARE_HEADER_X_SHIFT) & 1;
+  DaRe::R_VALUE enumR = (DaRe::R_VALUE)((payload.payload[0] >> DARE_HEADER_R_SHIFT) & DARE_HEADER_R_MASK);
+  DaRe::W_VALUE enumW = (DaRe::W_VALUE)(payload.payload[0] & DARE_HEADER_W_MASK);
+  uint8_t W = DaRe::getW(enumW), R = DaRe::getR(enumR), R_i, dataPointOffset;
+  uint8_t headerSize = extension ? 2 : 1, table = extension ? (payload.payload[1] & DARE_EXTENSION_TABLE_MASK) : 0;
+  uint8_t windowSize = DaRe::getWindowSize(W, fcntup);
+  bool missing = false, *generatorLine;
+
+  if (fcntup > lastFcntup) {
+    advance(fcntup);
+  } else if (fcntup + DARE_MAX_W < lastFcntup) {
+    return; // too late to be of any use
+  }
+  if (!isKnown(fcntup - 1)) {
+    storeDataPoint(fcntup - 1, &payload.payload[headerSize], 1);
+  }
+
+  // stage 2, only for parity checks over a window with missing data points
+  for (dataPointOffset = 1; dataPointOffset <= windowSize && !missing; dataPointOffset++) {
+    missing = !isKnown((fcntup - 1) - dataPointOffset);
+  }
+  if (enumF != DaRe::F_GF2 || (strategy != DaRe::S_REPETITION && !DaRe::hasDegreeTable(table))) {
+    rejectedChecks += R - 1; // only plain XOR parity checks with a known degree table can be used
+  } else if (missing) {
+    for (R_i = 0; R_i < R - 1; R_i++) {
+      if (strategy == DaRe::S_REPETITION) {
+        generatorLine = RepetitionStrategy::generatorLine(W, fcntup, R_i, 1);
+      } else {
+        generatorLine = DaReStrategy::generatorLine(W, fcntup, R_i, DaRe::getDegree(table, enumW));
+      }
+      addParityCheck(generatorLine, &payload.payload[headerSize + dataPointSize * (1 + R_i)], fcntup, W);
+      delete[] generatorLine;
+    }
+  }
+
+  // the new data point and new checks can make pending checks solvable
+  if (checkCount > 0) {
+    eliminate();
+  }
+  deliverInOrder(((lastFcntup - 1) > DARE_MAX_W) ? ((lastFcntup - 1) - DARE_MAX_W) : 0);
+}
+
+/*
+ * deliver all remaining data points, the missing ones as lost, and drop the pending checks
+ */
+void DaReSession::flush() {
+  if (checkCount > 0) {
+    eliminate();
+  }
+  deliverInOrder(lastFcntup);
+  setCheckCount(0);
+}
+
+/*
+ * getter for a received or decoded data point of the window, NULL if it is missing or out of the window
+ */
+uint8_t *DaReSession::getDataPoint(uint32_t fcntup) {
+  return isKnown(fcntup - 1) ? value(fcntup - 1) : NULL;
+}
+
+/*
+ * getter for the number of parity checks with more than one missing data point
+ */
+uint32_t DaReSession::getPendingChecks() {
+  return checkCount;
+}
+
+/*
+ * getter for the number of received parity checks the session could not use, those of GF(256) frames and of frames
+ * with an unknown degree table. Their data points are still used, but the session recovers nothing from them, so a
+ * device sending them should be decoded with DaReDecode instead
+ */
+uint32_t DaReSession::getRejectedChecks() {
+  return rejectedChecks;
+}
+
+/*
+ * bytes in use by this session, the object itself included
+ */
+size_t DaReSession::memoryUsage() {
+  return sizeof(DaReSession) + ((block != NULL) ? DARE_SESSION_WINDOW * (dataPointSize + 2) + DARE_SESSION_INLINE_CHECKS * checkSize() : 0)
+    + spill.capacity();
+}
+
+/*
+ * size in bytes of the serialized session, see serialize()
+ */
+size_t DaReSession::serializedSize() {
+  size_t knownCount = 0;
+  uint32_t word_i;
+  uint64_t word;
+  for (word_i = 0; word_i < DARE_SESSION_WINDOW / 64; word_i++) {
+    for (word = known[word_i]; word != 0; word &= word - 1) {
+      knownCount++;
+    }
+  }
+  return SESSION_SERIALIZED_HEADER + knownCount * (dataPointSize + 2) + (size_t)checkCount * checkSize();
+}
+
+/*
+ * Write the session to serializedSize() bytes, to be paged out while the device is idle. Only the known data points
+ * of the window are written, with the pending checks. The delivery callback is not part of it
+ * @param out - the destination
+ */
+void DaReSession::serialize(uint8_t *out) {
+  uint32_t position, check_i;
+  uint8_t strategyByte = (uint8_t)strategy;
+
+  memcpy(out, &lastFcntup, 4);
+  memcpy(out + 4, &lastDelivered, 4);
+  memcpy(out + 8, &checkCount, 2);
+  out[10] = dataPointSize;
+  out[11] = strategyByte;
+  memcpy(out + 12, known, sizeof(known));
+  memcpy(out + 12 + sizeof(known), &rejectedChecks, 4);
+  out += SESSION_SERIALIZED_HEADER;
+  // the window positions of the known data points follow from the known bitmap
+  for (position = 0; position < DARE_SESSION_WINDOW; position++) {
+    if ((known[position / 64] >> (position % 64)) & 1) {
+      memcpy(out, value(position), dataPointSize);
+      out[dataPointSize] = *phase(position);
+      out[dataPointSize + 1] = *delay(position);
+      out += dataPointSize + 2;
+    }
+  }
+  for (check_i = 0; check_i < checkCount; check_i++) {
+    memcpy(out, check(check_i), checkSize());
+    out += checkSize();
+  }
+}
+
+/*
+ * Restore a session written by serialize() into a new session object. The delivery callback has to be set again
+ * @param in - the serialized session
+ * @param size - its size in bytes
+ * @return false if the size does not match, the session is then not initialized
+ */
+bool DaReSession::deserialize(const uint8_t *in, size_t size) {
+  uint32_t position, check_i;
+  uint16_t checks;
+
+  if (size < SESSION_SERIALIZED_HEADER) {
+    return false;
+  }
+  init(in[10]);
+  strategy = (DaRe::S_VALUE)in[11];
+  memcpy(&lastFcntup, in, 4);
+  memcpy(&lastDelivered, in + 4, 4);
+  memcpy(&checks, in + 8, 2);
+  memcpy(known, in + 12, sizeof(known));
+  memcpy(&rejectedChecks, in + 12 + sizeof(known), 4);
+  setCheckCount(checks);
+  if (serializedSize() != size) {
+    destroy();
+    return false;
+  }
+  in += SESSION_SERIALIZED_HEADER;
+  for (position = 0; position < DARE_SESSION_WINDOW; position++) {
+    if ((known[position / 64] >> (position % 64)) & 1) {
+      memcpy(value(position), in, dataPointSize);
+      *phase(position) = in[dataPointSize];
+      *delay(position) = in[dataPointSize + 1];
+      in += dataPointSize + 2;
+    }
+  }
+  for (check_i = 0; check_i < checkCount; check_i++) {
+    memcpy(check(check_i), in, checkSize());
+    in += checkSize();
+  }
+  return true;
+}
@@ -0,0 +1,76 @@
+/*
+ / _____)             _              | |
+( (____  _____ ____ _| |_ _____  ____| |__
+ \____ \| ___ |    (_   _) ___ |/ ___)  _ \
+ _____) ) ____| | | || |_| ____( (___| | | |
+(______/|_____)_|_|_| \__)_____)\____)_| |_|
+    (C)2017 Semtech
+	
+Description: Compact decoder state for a large number of sessions
+License: Revised BSD License, see LICENSE file included in the project
+By: Paul Marcelis
+*/
+#include <vector>
+#include "DaRe.h"
+#include "DaReDecode.h"
+
+#ifndef __DARE_SESSION_H
+#define __DARE_SESSION_H
+
+#define DARE_SESSION_WINDOW 128 // frames of data points kept, a power of 2 of at least 2 * DARE_MAX_W
+#define DARE_SESSION_INLINE_CHECKS 8 // pending parity checks stored in the session block, more spill to the heap
+
+/*
+ * Decoder state of one device in a few hundred bytes, for servers with millions of sessions. Unlike DaReDecode it
+ * does not keep the whole history: the data points leave through the delivery callback once they are recovered or
+ * doomed, and only the last DARE_SESSION_WINDOW frames are kept. A pending parity check is a record of its frame
+ * counter, a 64-bit mask of its missing data points and its reduced value. The missing data points that can still be
+ * recovered always fit in 64 bits, the DARE_MAX_W data points before the newest frame, so stage 3 and 4 of
+ * DaReDecode become one Gaussian elimination on 64-bit masks.
+ * Only plain XOR parity checks are supported, of GF(256) frames only the data point is used and the parity checks are
+ * counted in getRejectedChecks()
+ */
+class DaReSession {
+  uint8_t *block = NULL; // the data points, phases and delays of the window, then the inline pending checks
+  std::vector<uint8_t> spill; // pending checks beyond DARE_SESSION_INLINE_CHECKS, empty when not needed
+  uint64_t known[DARE_SESSION_WINDOW / 64]; // bitmap of the received or decoded data points of the window
+  uint32_t lastFcntup = 0;
+  uint32_t lastDelivered = 0;
+  uint16_t checkCount = 0;
+  uint32_t rejectedChecks = 0; // parity checks of GF(256) frames or with an unknown degree table
+  uint8_t dataPointSize = 0;
+  DaRe::S_VALUE strategy = DaRe::S_DARE;
+  DaReDecode::DeliveryCallback deliveryCallback = NULL;
+  void *deliveryContext = NULL;
+
+  uint8_t *value(uint32_t dataPointId);
+  uint8_t *phase(uint32_t dataPointId);
+  uint8_t *delay(uint32_t dataPointId);
+  uint8_t *check(uint32_t check_i);
+  uint32_t checkSize();
+  bool isKnown(uint32_t dataPointId);
+  uint64_t knownMask();
+  void setCheckCount(uint32_t count);
+  void storeDataPoint(uint32_t dataPointId, uint8_t *dataPoint, uint8_t phaseIn);
+  void advance(uint32_t fcntup);
+  void addParityCheck(bool *generatorLine, uint8_t *parityCheck, uint32_t fcntup, uint8_t W);
+  void eliminate();
+  void deliverInOrder(uint32_t limit);
+
+public:
+  void init(uint8_t dataPointSizeIn);
+  void destroy();
+  void setStrategy(DaRe::S_VALUE strategyIn);
+  void setDeliveryCallback(DaReDecode::DeliveryCallback callback, void *context);
+  void decode(DaRe::Payload payload, uint32_t fcntup);
+  void flush();
+  uint8_t *getDataPoint(uint32_t fcntup);
+  uint32_t getPendingChecks();
+  uint32_t getRejectedChecks();
+  size_t memoryUsage();
+  size_t serializedSize();
+  void serialize(uint8_t *out);
+  bool deserialize(const uint8_t *in, size_t size);
+};
+
+#endif
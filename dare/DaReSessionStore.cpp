@@ -0,0 +1,511 @@
+/*
+ / _____)             _              | |
+( (____  _____ ____ _| |_ _____  ____| |__
+ \____ \| ___ |    (_   _) ___ |/ ___)  _ \
+ _____) ) ____| | | || |_| ____( (___| | | |
+(______/|_____)_|_|_| \__)_____)\____)_| |_|
+    (C)2017 Semtech
+	
+Description: Session store that keeps the recently active sessions in memory and pages idle ones out to a log file
+License: Revised BSD License, see LICENSE file included in the project
+By: Paul Marcelis
+*/
+#include <iostream>
+#include <string.h>
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#include "DaReSessionStore.h"
+
+#define STORE_NO_SLOT 0xffffffff
+
+/*
+ * open or create a session store file
+ * @param path - the file, the sessions in an existing file are kept
+ * @param dataPointSizeIn - the size in bytes of the data points, has to match the size in an existing file
+ * @param cacheCapacity - number of sessions kept in memory
+ * @return false if the file cannot be opened, mapped or has a different format
+ */
+bool DaReSessionStore::init(const char *path, uint8_t dataPointSizeIn, uint32_t cacheCapacity) {
+  uint64_t fileSize, offset;
+
+  dataPointSize = dataPointSizeIn;
+  slots.resize((cacheCapacity > 0) ? cacheCapacity : 1);
+  newest = oldest = STORE_NO_SLOT;
+
+#ifdef _WIN32
+  LARGE_INTEGER size;
+  file = CreateFileA(path, GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, NULL, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+  if (file == INVALID_HANDLE_VALUE || !GetFileSizeEx((HANDLE)file, &size)) {
+    std::cout << "Cannot open session store " << path << std::endl;
+    file = NULL;
+    return false;
+  }
+  fileSize = (uint64_t)size.QuadPart;
+#else
+  struct stat status;
+  file = open(path, O_RDWR | O_CREAT, 0644);
+  if (file < 0 || fstat(file, &status) != 0) {
+    std::cout << "Cannot open session store " << path << std::endl;
+    return false;
+  }
+  fileSize = (uint64_t)status.st_size;
+#endif
+
+  if (fileSize < DARE_SESSION_STORE_HEADER) {
+    // a new file
+    if (!mapFile(DARE_SESSION_STORE_GROW)) {
+      destroy();
+      return false;
+    }
+    getFileHeader()->magic = DARE_SESSION_STORE_MAGIC;
+    getFileHeader()->dataPointSize = dataPointSize;
+    getFileHeader()->end = DARE_SESSION_STORE_HEADER;
+    return true;
+  }
+
+  if (!mapFile(fileSize)) {
+    destroy();
+    return false;
+  }
+  if (getFileHeader()->magic != DARE_SESSION_STORE_MAGIC || getFileHeader()->dataPointSize != dataPointSize || getFileHeader()->end > mapSize) {
+    std::cout << "Session store " << path << " has a different format" << std::endl;
+    destroy();
+    return false;
+  }
+
+  // rebuild the table of live records, a later record of a device replaces an earlier one
+  for (offset = DARE_SESSION_STORE_HEADER; offset < getFileHeader()->end; offset += recordSize(getRecordHeader(offset)->size)) {
+    if (getRecordHeader(offset)->magic != DARE_SESSION_STORE_MAGIC || offset + recordSize(getRecordHeader(offset)->size) > getFileHeader()->end) {
+      std::cout << "Session store " << path << " is truncated after " << offset << " bytes" << std::endl;
+      getFileHeader()->end = offset;
+      break;
+    }
+    setRecord(getRecordHeader(offset)->deviceId, offset);
+  }
+  return true;
+}
+
+/*
+ * write the sessions in memory to the file, and close it
+ */
+void DaReSessionStore::destroy() {
+  uint32_t slot_i;
+  if (map != NULL) {
+    flush();
+  }
+  for (slot_i = 0; slot_i < slotsUsed; slot_i++) {
+    slots[slot_i].session.destroy();
+  }
+  unmapFile();
+#ifdef _WIN32
+  if (file != NULL) {
+    CloseHandle((HANDLE)file);
+    file = NULL;
+  }
+#else
+  if (file >= 0) {
+    close(file);
+    file = -1;
+  }
+#endif
+  slots.clear();
+  resident.clear();
+  records.clear();
+  slotsUsed = 0;
+  liveBytes = 0;
+}
+
+/*
+ * (re)map the file with a certain size, growing the file if needed. All pointers into the previous mapping become
+ * invalid, if the file cannot grow or be mapped the previous mapping stays
+ */
+bool DaReSessionStore::mapFile(uint64_t size) {
+  uint8_t *newMap = NULL;
+
+#ifdef _WIN32
+  // the mapping grows the file to the mapped size
+  void *newMapping = CreateFileMappingA((HANDLE)file, NULL, PAGE_READWRITE, (DWORD)(size >> 32), (DWORD)size, NULL);
+  if (newMapping != NULL) {
+    newMap = (uint8_t *)MapViewOfFile((HANDLE)newMapping, FILE_MAP_ALL_ACCESS, 0, 0, (SIZE_T)size);
+    if (newMap == NULL) {
+      CloseHandle((HANDLE)newMapping);
+    }
+  }
+#else
+  struct stat status;
+  if (fstat(file, &status) != 0 || ((uint64_t)status.st_size < size && ftruncate(file, (off_t)size) != 0)) {
+    std::cout << "Cannot grow session store" << std::endl;
+    return false;
+  }
+  void *mapped = mmap(NULL, (size_t)size, PROT_READ | PROT_WRITE, MAP_SHARED, file, 0);
+  newMap = (mapped == MAP_FAILED) ? NULL : (uint8_t *)mapped;
+#endif
+  if (newMap == NULL) {
+    std::cout << "Cannot map session store" << std::endl;
+    return false;
+  }
+
+  unmapFile();
+  map = newMap;
+#ifdef _WIN32
+  mapping = newMapping;
+#endif
+  mapSize = size;
+  return true;
+}
+
+/*
+ * write the mapped file back and unmap it
+ */
+void DaReSessionStore::unmapFile() {
+  if (map != NULL) {
+#ifdef _WIN32
+    FlushViewOfFile(map, 0);
+    UnmapViewOfFile(map);
+#else
+    msync(map, (size_t)mapSize, MS_ASYNC);
+    munmap(map, (size_t)mapSize);
+#endif
+    map = NULL;
+  }
+#ifdef _WIN32
+  if (mapping != NULL) {
+    CloseHandle((HANDLE)mapping);
+    mapping = NULL;
+  }
+#endif
+}
+
+DaReSessionStore::fileHeader *DaReSessionStore::getFileHeader() {
+  return (fileHeader *)map;
+}
+
+DaReSessionStore::recordHeader *DaReSessionStore::getRecordHeader(uint64_t offset) {
+  return (recordHeader *)&map[offset];
+}
+
+/*
+ * bytes in the file of a record with a serialized session of a certain size
+ */
+uint64_t DaReSessionStore::recordSize(uint32_t sessionSize) {
+  return (sizeof(recordHeader) + sessionSize + DARE_SESSION_STORE_ALIGN - 1) / DARE_SESSION_STORE_ALIGN * DARE_SESSION_STORE_ALIGN;
+}
+
+/*
+ * make a record the live record of a device, the previous one becomes stale
+ */
+void DaReSessionStore::setRecord(uint32_t deviceId, uint64_t offset) {
+  if (deviceId >= records.size()) {
+    records.resize((size_t)deviceId + 1, 0);
+  }
+  if (records[deviceId] != 0) {
+    liveBytes -= recordSize(getRecordHeader(records[deviceId])->size);
+  }
+  records[deviceId] = offset;
+  liveBytes += recordSize(getRecordHeader(offset)->size);
+}
+
+/*
+ * remove a slot from the least recently used list
+ */
+void DaReSessionStore::unlink(uint32_t slot_i) {
+  if (slots[slot_i].newer != STORE_NO_SLOT) {
+    slots[slots[slot_i].newer].older = slots[slot_i].older;
+  } else {
+    newest = slots[slot_i].older;
+  }
+  if (slots[slot_i].older != STORE_NO_SLOT) {
+    slots[slots[slot_i].older].newer = slots[slot_i].newer;
+  } else {
+    oldest = slots[slot_i].newer;
+  }
+}
+
+/*
+ * put a slot in front of the least recently used list
+ */
+void DaReSessionStore::linkNewest(uint32_t slot_i) {
+  slots[slot_i].newer = STORE_NO_SLOT;
+  slots[slot_i].older = newest;
+  if (newest != STORE_NO_SLOT) {
+    slots[newest].newer = slot_i;
+  }
+  newest = slot_i;
+  if (oldest == STORE_NO_SLOT) {
+    oldest = slot_i;
+  }
+}
+
+/*
+ * Get the slot of the session of a device, reading it from the file or starting a new session if it is not in memory.
+ * The least recently used session makes place, it is written to the file first if it changed
+ * @return the slot, which is the most recently used from now on, or STORE_NO_SLOT if the session that has to make
+ * place cannot be written because the file cannot grow. That session stays in memory
+ */
+uint32_t DaReSessionStore::fault(uint32_t deviceId) {
+  std::unordered_map<uint32_t, uint32_t>::iterator found = resident.find(deviceId);
+  uint32_t slot_i;
+
+  if (found != resident.end()) {
+    slot_i = found->second;
+    unlink(slot_i);
+    linkNewest(slot_i);
+    return slot_i;
+  }
+
+  if (slotsUsed < slots.size()) {
+    slot_i = slotsUsed++;
+  } else {
+    slot_i = oldest;
+    if (slots[slot_i].dirty && !writeBack(slot_i)) {
+      return STORE_NO_SLOT;
+    }
+    unlink(slot_i);
+    resident.erase(slots[slot_i].deviceId);
+    slots[slot_i].session.destroy();
+  }
+
+  slot &s = slots[slot_i];
+  s.store = this;
+  s.deviceId = deviceId;
+  s.session = DaReSession();
+  s.dirty = false;
+  if (deviceId < records.size() && records[deviceId] != 0
+    && s.session.deserialize(&map[records[deviceId] + sizeof(recordHeader)], getRecordHeader(records[deviceId])->size)) {
+    faults++;
+  } else {
+    s.session = DaReSession();
+    s.session.init(dataPointSize);
+    s.session.setStrategy(strategy);
+    s.dirty = true;
+  }
+  s.session.setDeliveryCallback(onDelivery, &s);
+  resident[deviceId] = slot_i;
+  linkNewest(slot_i);
+  return slot_i;
+}
+
+/*
+ * append the session of a slot to the file, compacting or growing the file if it is full
+ * @return false if the file cannot grow
+ */
+bool DaReSessionStore::writeBack(uint32_t slot_i) {
+  uint32_t sessionSize = (uint32_t)slots[slot_i].session.serializedSize();
+  uint64_t size = recordSize(sessionSize), end = getFileHeader()->end;
+
+  if (end + size > mapSize) {
+    // compact if more than half of the file is stale, grow otherwise
+    if (liveBytes < (end - DARE_SESSION_STORE_HEADER) / 2) {
+      compact();
+      end = getFileHeader()->end;
+    }
+    if (end + size > mapSize && !mapFile(mapSize + ((size > DARE_SESSION_STORE_GROW) ? size : 0) + DARE_SESSION_STORE_GROW)) {
+      return false;
+    }
+  }
+  getRecordHeader(end)->magic = DARE_SESSION_STORE_MAGIC;
+  getRecordHeader(end)->deviceId = slots[slot_i].deviceId;
+  getRecordHeader(end)->size = sessionSize;
+  getRecordHeader(end)->reserved = 0;
+  slots[slot_i].session.serialize(&map[end + sizeof(recordHeader)]);
+  getFileHeader()->end = end + size;
+  setRecord(slots[slot_i].deviceId, end);
+  slots[slot_i].dirty = false;
+  writes++;
+  return true;
+}
+
+/*
+ * Move the live records to the front of the file, in file order, dropping the stale records. The records are moved in
+ * place and the end in the file header is written last, so the file is not consistent while this runs: after a crash
+ * during compaction a record can be overwritten by the one moved over it, and reopening the file truncates it at the
+ * first damaged record, losing the sessions after it
+ */
+void DaReSessionStore::compact() {
+  uint64_t offset, size, write = DARE_SESSION_STORE_HEADER, end = getFileHeader()->end;
+  uint32_t deviceId;
+
+  for (offset = DARE_SESSION_STORE_HEADER; offset < end; offset += size) {
+    size = recordSize(getRecordHeader(offset)->size);
+    deviceId = getRecordHeader(offset)->deviceId;
+    if (records[deviceId] == offset) {
+      if (write != offset) {
+        memmove(&map[write], &map[offset], (size_t)size);
+        records[deviceId] = write;
+      }
+      write += size;
+    }
+  }
+  getFileHeader()->end = write;
+  compactions++;
+}
+
+void DaReSessionStore::onDelivery(void *context, uint32_t fcntup, uint8_t *dataPoint, bool received, uint8_t phase, uint32_t delay) {
+  slot *s = (slot *)context;
+  if (s->store->deliveryCallback != NULL) {
+    s->store->deliveryCallback(s->store->deliveryContext, s->deviceId, fcntup, dataPoint, received, phase, delay);
+  }
+}
+
+/*
+ * set the coding strategy of the sessions started from now on, see DaReSession::setStrategy()
+ */
+void DaReSessionStore::setStrategy(DaRe::S_VALUE strategyIn) {
+  strategy = strategyIn;
+}
+
+/*
+ * set the callback that receives the data points of all devices
+ */
+void DaReSessionStore::setDeliveryCallback(DeliveryCallback callback, void *context) {
+  deliveryCallback = callback;
+  deliveryContext = context;
+}
+
+/*
+ * decode a frame of a device, see DaReSession::decode()
+ * @param deviceId - the device
+ * @param payload - the payload from the frame to be decoded
+ * @param fcntup - the frame counter
+ * @return false if the frame is not decoded because the session cannot be brought in memory, the file cannot grow
+ */
+bool DaReSessionStore::decode(uint32_t deviceId, DaRe::Payload payload, uint32_t fcntup) {
+  uint32_t slot_i = fault(deviceId);
+  if (slot_i == STORE_NO_SLOT) {
+    return false;
+  }
+  slots[slot_i].session.decode(payload, fcntup);
+  slots[slot_i].dirty = true;
+  return true;
+}
+
+/*
+ * Hint that a frame of a device is coming, for example from the gateway that received it before the network server
+ * deduplicated it, or from the schedule of the device. A session in memory becomes the most recently used, so it is
+ * not paged out before the frame arrives, the pages of a session in the file are requested from the operating system
+ * without waiting for them
+ */
+void DaReSessionStore::prefetch(uint32_t deviceId) {
+  std::unordered_map<uint32_t, uint32_t>::iterator found = resident.find(deviceId);
+
+  if (found != resident.end()) {
+    unlink(found->second);
+    linkNewest(found->second);
+    return;
+  }
+  if (deviceId >= records.size() || records[deviceId] == 0) {
+    return;
+  }
+  prefetches++;
+  // the size of the record is in its header, which is not read here since that could wait for the disk, so the pages
+  // of a session with a full window and its inline pending checks are requested
+  uint64_t first = records[deviceId], size = recordSize(DARE_SESSION_WINDOW * (dataPointSize + 2) + DARE_SESSION_INLINE_CHECKS * (12 + dataPointSize) + 32);
+  if (first + size > mapSize) {
+    size = mapSize - first;
+  }
+#ifdef _WIN32
+#if defined(_WIN32_WINNT) && _WIN32_WINNT >= 0x0602
+  WIN32_MEMORY_RANGE_ENTRY range;
+  range.VirtualAddress = &map[first];
+  range.NumberOfBytes = (SIZE_T)size;
+  PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+#endif
+#else
+  uint64_t page = (uint64_t)sysconf(_SC_PAGESIZE);
+  size += first % page;
+  first -= first % page;
+  madvise(&map[first], (size_t)size, MADV_WILLNEED);
+#endif
+}
+
+/*
+ * the session of a device, read from the file if needed. The pointer is valid until the next call to the store
+ * @return NULL if the session cannot be brought in memory because the file cannot grow
+ */
+DaReSession *DaReSessionStore::getSession(uint32_t deviceId) {
+  uint32_t slot_i = fault(deviceId);
+  if (slot_i == STORE_NO_SLOT) {
+    return NULL;
+  }
+  slots[slot_i].dirty = true; // the caller may change it
+  return &slots[slot_i].session;
+}
+
+/*
+ * write all changed sessions in memory to the file, they stay in memory
+ * @return false if a session cannot be written because the file cannot grow, it stays changed in memory
+ */
+bool DaReSessionStore::flush() {
+  uint32_t slot_i;
+  bool written = true;
+  for (slot_i = 0; slot_i < slotsUsed; slot_i++) {
+    if (slots[slot_i].dirty && !writeBack(slot_i)) {
+      written = false;
+    }
+  }
+  return written;
+}
+
+/*
+ * getter for the number of sessions in memory
+ */
+uint32_t DaReSessionStore::getResident() {
+  return (uint32_t)resident.size();
+}
+
+/*
+ * getter for the number of sessions read back from the file
+ */
+uint32_t DaReSessionStore::getFaults() {
+  return faults;
+}
+
+/*
+ * getter for the number of sessions written to the file
+ */
+uint32_t DaReSessionStore::getWrites() {
+  return writes;
+}
+
+/*
+ * getter for the number of prefetch hints passed on to the operating system
+ */
+uint32_t DaReSessionStore::getPrefetches() {
+  return prefetches;
+}
+
+/*
+ * getter for the number of times the file was compacted
+ */
+uint32_t DaReSessionStore::getCompactions() {
+  return compactions;
+}
+
+/*
+ * getter for the bytes of records in the file, stale records included
+ */
+uint64_t DaReSessionStore::getFileBytes() {
+  return (map != NULL) ? getFileHeader()->end : 0;
+}
+
+/*
+ * bytes in memory for the store, the sessions in memory included but not the mapped file, which the operating
+ * system pages in and out
+ */
+size_t DaReSessionStore::memoryUsage() {
+  size_t bytes = sizeof(DaReSessionStore) + slots.capacity() * (sizeof(slot) - sizeof(DaReSession)) + records.capacity() * sizeof(uint64_t)
+    + resident.size() * (sizeof(std::pair<uint32_t, uint32_t>) + 2 * sizeof(void *)) + resident.bucket_count() * sizeof(void *);
+  uint32_t slot_i;
+  for (slot_i = 0; slot_i < slotsUsed; slot_i++) {
+    bytes += slots[slot_i].session.memoryUsage();
+  }
+  return bytes;
+}
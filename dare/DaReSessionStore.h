@@ -0,0 +1,113 @@
+/*
+ / _____)             _              | |
+( (____  _____ ____ _| |_ _____  ____| |__
+ \____ \| ___ |    (_   _) ___ |/ ___)  _ \
+ _____) ) ____| | | || |_| ____( (___| | | |
+(______/|_____)_|_|_| \__)_____)\____)_| |_|
+    (C)2017 Semtech
+	
+Description: Session store that keeps the recently active sessions in memory and pages idle ones out to a log file
+License: Revised BSD License, see LICENSE file included in the project
+By: Paul Marcelis
+*/
+#include <vector>
+#include <unordered_map>
+#include "DaRe.h"
+#include "DaReSession.h"
+
+#ifndef __DARE_SESSION_STORE_H
+#define __DARE_SESSION_STORE_H
+
+#define DARE_SESSION_STORE_GROW (1 << 20) // bytes the file grows with at once, a multiple of the page size and of the Windows allocation granularity
+#define DARE_SESSION_STORE_HEADER 64 // bytes of the file header, the records follow
+#define DARE_SESSION_STORE_ALIGN 8 // alignment of the records
+#define DARE_SESSION_STORE_MAGIC 0x53526144 // "DaRS"
+
+/*
+ * Most devices send a frame every 10 to 60 minutes, so nearly all sessions of a server are idle at any moment. The
+ * store keeps a bounded number of sessions in memory, the least recently used one is serialized to a memory-mapped,
+ * log-structured file when another session needs its place, and read back on the next frame of its device. Every
+ * write appends a record, the newest record of a device is the live one. When more than half of the file is stale
+ * records, the live records are compacted to the front of the file in place, which is not crash safe, see compact().
+ * An existing file is reopened with the sessions in it. When the file cannot grow, the sessions that cannot be paged
+ * out stay in memory and the frames of devices that are not in memory are refused.
+ * Device ids index a table of 8 bytes per device, so they are expected to be dense, as the rows of a device table.
+ * Not thread safe, use one store per worker thread
+ */
+class DaReSessionStore {
+public:
+  // called for every data point of every device in frame counter order, see DaReDecode::DeliveryCallback
+  typedef void (*DeliveryCallback)(void *context, uint32_t deviceId, uint32_t fcntup, uint8_t *dataPoint, bool received, uint8_t phase, uint32_t delay);
+
+private:
+  struct fileHeader {
+    uint32_t magic;
+    uint32_t dataPointSize;
+    uint64_t end; // offset after the last record
+  };
+  struct recordHeader {
+    uint32_t magic;
+    uint32_t deviceId;
+    uint32_t size; // of the serialized session that follows
+    uint32_t reserved;
+  };
+  struct slot {
+    DaReSessionStore *store;
+    uint32_t deviceId;
+    DaReSession session;
+    bool dirty; // changed since it was last written to the file
+    uint32_t newer, older; // least recently used list
+  };
+
+  uint8_t dataPointSize = 0;
+  DaRe::S_VALUE strategy = DaRe::S_DARE;
+  DeliveryCallback deliveryCallback = NULL;
+  void *deliveryContext = NULL;
+  std::vector<slot> slots;
+  std::unordered_map<uint32_t, uint32_t> resident; // device id to slot
+  uint32_t slotsUsed = 0;
+  uint32_t newest, oldest; // ends of the least recently used list
+  std::vector<uint64_t> records; // offset of the live record per device id, 0 if the device has none
+  uint64_t liveBytes = 0;
+  uint64_t mapSize = 0;
+  uint8_t *map = NULL;
+#ifdef _WIN32
+  void *file = NULL;
+  void *mapping = NULL;
+#else
+  int file = -1;
+#endif
+  uint32_t faults = 0, writes = 0, prefetches = 0, compactions = 0;
+
+  bool mapFile(uint64_t size);
+  void unmapFile();
+  fileHeader *getFileHeader();
+  recordHeader *getRecordHeader(uint64_t offset);
+  static uint64_t recordSize(uint32_t sessionSize);
+  void setRecord(uint32_t deviceId, uint64_t offset);
+  void unlink(uint32_t slot_i);
+  void linkNewest(uint32_t slot_i);
+  uint32_t fault(uint32_t deviceId);
+  bool writeBack(uint32_t slot_i);
+  void compact();
+  static void onDelivery(void *context, uint32_t fcntup, uint8_t *dataPoint, bool received, uint8_t phase, uint32_t delay);
+
+public:
+  bool init(const char *path, uint8_t dataPointSizeIn, uint32_t cacheCapacity);
+  void destroy();
+  void setStrategy(DaRe::S_VALUE strategyIn);
+  void setDeliveryCallback(DeliveryCallback callback, void *context);
+  bool decode(uint32_t deviceId, DaRe::Payload payload, uint32_t fcntup);
+  void prefetch(uint32_t deviceId);
+  DaReSession *getSession(uint32_t deviceId);
+  bool flush();
+  uint32_t getResident();
+  uint32_t getFaults();
+  uint32_t getWrites();
+  uint32_t getPrefetches();
+  uint32_t getCompactions();
+  uint64_t getFileBytes();
+  size_t memoryUsage();
+};
+
+#endif
@@ -0,0 +1,171 @@
+/*
+ / _____)             _              | |
+( (____  _____ ____ _| |_ _____  ____| |__
+ \____ \| ___ |    (_   _) ___ |/ ___)  _ \
+ _____) ) ____| | | || |_| ____( (___| | | |
+(______/|_____)_|_|_| \__)_____)\____)_| |_|
+    (C)2017 Semtech
+	
+Description: Window of the newest data points of a decoder, readable from other threads while the decoder runs
+License: Revised BSD License, see LICENSE file included in the project
+By: Paul Marcelis
+*/
+#include <thread>
+#include "DaReSnapshot.h"
+
+#define SNAPSHOT_SEQUENCE 0
+#define SNAPSHOT_NEWEST 1
+#define SNAPSHOT_HEADER_WORDS 2
+
+/*
+ * initialise an empty window
+ * @param dataPointSizeIn - the size in bytes of the data points
+ */
+void DaReSnapshot::init(uint8_t dataPointSizeIn) {
+  uint32_t i, size;
+  dataPointSize = dataPointSizeIn;
+  slotWords = 2 + (dataPointSize + 3) / 4;
+  size = SNAPSHOT_HEADER_WORDS + DARE_SNAPSHOT_WINDOW * slotWords;
+  words = new std::atomic<uint32_t>[size];
+  for (i = 0; i < size; i++) {
+    words[i].store(0, std::memory_order_relaxed);
+  }
+}
+
+/*
+ * destroy the window, no reader may use it anymore
+ */
+void DaReSnapshot::destroy() {
+  delete[] words;
+  words = NULL;
+}
+
+/*
+ * Publish a received or decoded data point, only to be called by the writer. Data points that are older than the
+ * window are ignored
+ * @param fcntup - frame counter of the data point
+ * @param dataPoint - the value
+ * @param phase - recovery phase, 1 if received
+ * @param delay - decoding delay in frames
+ */
+void DaReSnapshot::publish(uint32_t fcntup, const uint8_t *dataPoint, uint8_t phase, uint32_t delay) {
+  uint32_t sequence, newest, word_i, i, packed;
+  std::atomic<uint32_t> *slot = &words[SNAPSHOT_HEADER_WORDS + ((fcntup - 1) % DARE_SNAPSHOT_WINDOW) * slotWords];
+
+  newest = words[SNAPSHOT_NEWEST].load(std::memory_order_relaxed);
+  if (fcntup + DARE_SNAPSHOT_WINDOW <= newest) {
+    return;
+  }
+
+  // an odd sequence number tells the readers a write is in progress
+  sequence = words[SNAPSHOT_SEQUENCE].load(std::memory_order_relaxed);
+  words[SNAPSHOT_SEQUENCE].store(sequence + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+
+  slot[0].store(fcntup, std::memory_order_relaxed);
+  slot[1].store(((uint32_t)phase << 24) | (delay & 0xffffff), std::memory_order_relaxed);
+  for (word_i = 0; word_i < slotWords - 2; word_i++) {
+    packed = 0;
+    for (i = 0; i < 4 && word_i * 4 + i < dataPointSize; i++) {
+      packed |= (uint32_t)dataPoint[word_i * 4 + i] << (8 * i);
+    }
+    slot[2 + word_i].store(packed, std::memory_order_relaxed);
+  }
+  if (fcntup > newest) {
+    words[SNAPSHOT_NEWEST].store(fcntup, std::memory_order_relaxed);
+  }
+
+  words[SNAPSHOT_SEQUENCE].store(sequence + 2, std::memory_order_release);
+}
+
+/*
+ * wait until no write is in progress and return the sequence number to validate the read with
+ */
+uint32_t DaReSnapshot::beginRead() {
+  uint32_t sequence;
+  while ((sequence = words[SNAPSHOT_SEQUENCE].load(std::memory_order_acquire)) & 1) {
+    std::this_thread::yield();
+  }
+  return sequence;
+}
+
+/*
+ * whether the words read since beginRead() form a consistent snapshot
+ */
+bool DaReSnapshot::endRead(uint32_t sequence) {
+  std::atomic_thread_fence(std::memory_order_acquire);
+  return words[SNAPSHOT_SEQUENCE].load(std::memory_order_relaxed) == sequence;
+}
+
+/*
+ * copy one data point from the ring, phase 0 if the slot does not hold the data point of this frame
+ */
+void DaReSnapshot::readSlot(uint32_t slot_i, uint32_t fcntup, uint8_t *value, uint8_t *phase, uint32_t *delay) {
+  std::atomic<uint32_t> *slot = &words[SNAPSHOT_HEADER_WORDS + slot_i * slotWords];
+  uint32_t word_i, i, packed;
+
+  if (slot[0].load(std::memory_order_relaxed) != fcntup) {
+    *phase = 0;
+    *delay = 0;
+    return;
+  }
+  packed = slot[1].load(std::memory_order_relaxed);
+  *phase = (uint8_t)(packed >> 24);
+  *delay = packed & 0xffffff;
+  for (word_i = 0; word_i < slotWords - 2; word_i++) {
+    packed = slot[2 + word_i].load(std::memory_order_relaxed);
+    for (i = 0; i < 4 && word_i * 4 + i < dataPointSize; i++) {
+      value[word_i * 4 + i] = (uint8_t)(packed >> (8 * i));
+    }
+  }
+}
+
+/*
+ * Read the newest data points, all from the same moment in the decoding. Can be called from any thread
+ * @param count - number of data points to read, at most DARE_SNAPSHOT_WINDOW
+ * @param values - count * data point size bytes, the oldest data point first
+ * @param phases - count recovery phases, 0 for a data point that is missing (so far), its value is left as it was
+ * @return the frame counter of the newest data point, the last one in values. 0 if nothing is published yet
+ */
+uint32_t DaReSnapshot::readNewest(uint32_t count, uint8_t *values, uint8_t *phases) {
+  uint32_t sequence, newest, fcntup, i, delay;
+
+  count = (count > DARE_SNAPSHOT_WINDOW) ? DARE_SNAPSHOT_WINDOW : count;
+  do {
+    sequence = beginRead();
+    newest = words[SNAPSHOT_NEWEST].load(std::memory_order_relaxed);
+    for (i = 0; i < count; i++) {
+      fcntup = newest - (count - 1) + i;
+      if (fcntup < 1 || fcntup > newest) { // before the first frame
+        phases[i] = 0;
+        continue;
+      }
+      readSlot((fcntup - 1) % DARE_SNAPSHOT_WINDOW, fcntup, &values[i * dataPointSize], &phases[i], &delay);
+    }
+  } while (!endRead(sequence));
+  return newest;
+}
+
+/*
+ * Read a single data point of the window. Can be called from any thread
+ * @param fcntup - frame counter of the data point
+ * @param value - data point size bytes
+ * @param phase - recovery phase, 1 if received
+ * @param delay - decoding delay in frames
+ * @return false if the data point is missing (so far), or no longer in the window
+ */
+bool DaReSnapshot::readDataPoint(uint32_t fcntup, uint8_t *value, uint8_t *phase, uint32_t *delay) {
+  uint32_t sequence;
+  do {
+    sequence = beginRead();
+    readSlot((fcntup - 1) % DARE_SNAPSHOT_WINDOW, fcntup, value, phase, delay);
+  } while (!endRead(sequence));
+  return *phase != 0;
+}
+
+/*
+ * bytes of the window, without the object itself
+ */
+size_t DaReSnapshot::memoryUsage() {
+  return (words != NULL) ? (SNAPSHOT_HEADER_WORDS + DARE_SNAPSHOT_WINDOW * slotWords) * sizeof(std::atomic<uint32_t>) : 0;
+}
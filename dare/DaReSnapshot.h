@@ -0,0 +1,44 @@
+/*
+ / _____)             _              | |
+( (____  _____ ____ _| |_ _____  ____| |__
+ \____ \| ___ |    (_   _) ___ |/ ___)  _ \
+ _____) ) ____| | | || |_| ____( (___| | | |
+(______/|_____)_|_|_| \__)_____)\____)_| |_|
+    (C)2017 Semtech
+	
+Description: Window of the newest data points of a decoder, readable from other threads while the decoder runs
+License: Revised BSD License, see LICENSE file included in the project
+By: Paul Marcelis
+*/
+#include <atomic>
+#include "DaRe.h"
+
+#ifndef __DARE_SNAPSHOT_H
+#define __DARE_SNAPSHOT_H
+
+#define DARE_SNAPSHOT_WINDOW 128 // number of newest frames in the window, a power of 2 larger than DARE_MAX_W + 1
+
+/*
+ * A seqlock over a ring of the newest data points. The decoder is the single writer, it publishes every stored data
+ * point. Readers never block the writer, they retry when the writer published during their read. All shared state
+ * is in relaxed atomic words, ordered by the fences around the sequence number
+ */
+class DaReSnapshot {
+  uint8_t dataPointSize = 0;
+  uint32_t slotWords = 0; // fcntup, phase and delay, then the data point
+  std::atomic<uint32_t> *words = NULL; // sequence number, newest fcntup, then the slots
+
+  uint32_t beginRead();
+  bool endRead(uint32_t sequence);
+  void readSlot(uint32_t slot, uint32_t fcntup, uint8_t *value, uint8_t *phase, uint32_t *delay);
+
+public:
+  void init(uint8_t dataPointSizeIn);
+  void destroy();
+  void publish(uint32_t fcntup, const uint8_t *dataPoint, uint8_t phase, uint32_t delay);
+  uint32_t readNewest(uint32_t count, uint8_t *values, uint8_t *phases);
+  bool readDataPoint(uint32_t fcntup, uint8_t *value, uint8_t *phase, uint32_t *delay);
+  size_t memoryUsage();
+};
+
+#endif
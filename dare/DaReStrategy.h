@@ -0,0 +1,63 @@
+/*
+ / _____)             _              | |
+( (____  _____ ____ _| |_ _____  ____| |__
+ \____ \| ___ |    (_   _) ___ |/ ___)  _ \
+ _____) ) ____| | | || |_| ____( (___| | | |
+(______/|_____)_|_|_| \__)_____)\____)_| |_|
+    (C)2017 Semtech
+	
+Description: Coding strategies, determining which previous data points are included in the parity checks
+License: Revised BSD License, see LICENSE file included in the project
+By: Paul Marcelis
+*/
+#include "DaRe.h"
+
+#ifndef __DARE_STRATEGY_H
+#define __DARE_STRATEGY_H
+
+/*
+ * A strategy is a class with only static members. The encoder and the decoder process the parity checks of a frame in a
+ * function template instantiated per strategy, so the strategy is selected once per frame and the generator line
+ * calls within are resolved at compile time. A new strategy needs a value in DaRe::S_VALUE, a class below and a case
+ * in the switches of DaReEncode::encode() and DaReDecode::decode()
+ */
+
+/*
+ * DaRe: every parity check includes a pseudo random selection of the previous W data points
+ */
+class DaReStrategy {
+public:
+  static const DaRe::S_VALUE id = DaRe::S_DARE;
+  static const char *name() { return "DaRe"; }
+
+  /*
+   * @param W - window size
+   * @param fcntup - frame counter value of the frame
+   * @param R - index of the parity check within the frame
+   * @param D - number of data points in the parity check
+   * @return the generator line of W elements, to be deleted by the caller
+   */
+  static bool *generatorLine(uint8_t W, uint32_t fcntup, uint8_t R, uint8_t D) {
+    return DaRe::prlg(W, fcntup, R, D);
+  }
+};
+
+/*
+ * Repetition coding: parity check R of a frame is a copy of the data point R + 1 frames back, so a frame repeats the
+ * previous R - 1 data points. The degree is always 1
+ */
+class RepetitionStrategy {
+public:
+  static const DaRe::S_VALUE id = DaRe::S_REPETITION;
+  static const char *name() { return "repetition"; }
+
+  static bool *generatorLine(uint8_t W, uint32_t /*fcntup*/, uint8_t R, uint8_t /*D*/) {
+    bool *line = new bool[W]();
+    if (R < W) {
+      line[R] = 1;
+    }
+    return line;
+  }
+};
+
+#endif
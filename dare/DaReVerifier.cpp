@@ -0,0 +1,80 @@
+/*
+ / _____)             _              | |
+( (____  _____ ____ _| |_ _____  ____| |__
+ \____ \| ___ |    (_   _) ___ |/ ___)  _ \
+ _____) ) ____| | | || |_| ____( (___| | | |
+(______/|_____)_|_|_| \__)_____)\____)_| |_|
+    (C)2017 Semtech
+	
+Description: Optional verification layer comparing decoded data points with the ground truth
+License: Revised BSD License, see LICENSE file included in the project
+By: Paul Marcelis
+*/
+#include "DaReVerifier.h"
+
+/*
+ * initialise a verifier, which holds the original data points of a simulation
+ * @param dataPointSizeIn - the size in bytes of the data points
+ * @param simulationLength - required to allocate sufficient memory for the ground truth
+ */
+void DaReVerifier::init(uint8_t dataPointSizeIn, uint32_t simulationLength) {
+  dataPointSize = dataPointSizeIn;
+  totalDataPoints = simulationLength;
+  dataPointsTruth = new uint8_t[simulationLength * dataPointSize]();
+  mismatches = 0;
+}
+
+/*
+ * destroy the verifier
+ */
+void DaReVerifier::destroy() {
+  delete[] dataPointsTruth;
+  dataPointsTruth = NULL;
+}
+
+/*
+ * store the known value for a certain data point for later correctness comparison of the decoded value
+ */
+void DaReVerifier::setDataPoint(uint32_t fcntup, uint8_t *dataPoint) {
+  uint8_t i;
+  for (i = 0; i < dataPointSize; i++) {
+    dataPointsTruth[(fcntup - 1) * dataPointSize + i] = dataPoint[i];
+  }
+}
+
+/*
+ * getter for the known value of a certain data point
+ */
+uint8_t *DaReVerifier::getDataPoint(uint32_t fcntup) {
+  return &dataPointsTruth[(fcntup - 1) * dataPointSize];
+}
+
+/*
+ * compare a decoded data point with the known value
+ * @param fcntup - frame counter value of the frame the decoded data point is originally from
+ * @param dataPoint - the decoded value
+ * @param phase - the phase at which the data point was decoded, only used for reporting
+ * @return true if the decoded value is correct
+ */
+bool DaReVerifier::verify(uint32_t fcntup, const uint8_t *dataPoint, int phase) {
+  uint8_t i;
+  bool wrong = false;
+  for (i = 0; i < dataPointSize; i++) {
+    if (dataPoint[i] != dataPointsTruth[(fcntup - 1) * dataPointSize + i]) {
+      wrong = true;
+      std::printf("FOUT! d[%d_%d](%d) = %02x != %02x. ", (fcntup - 1), i, phase, dataPoint[i], dataPointsTruth[(fcntup - 1) * dataPointSize + i]);
+    }
+  }
+
+  if (wrong) {
+    mismatches += 1;
+  }
+  return !wrong;
+}
+
+/*
+ * getter for the number of wrongly decoded data points
+ */
+uint32_t DaReVerifier::getMismatches() {
+  return mismatches;
+}
@@ -0,0 +1,33 @@
+/*
+ / _____)             _              | |
+( (____  _____ ____ _| |_ _____  ____| |__
+ \____ \| ___ |    (_   _) ___ |/ ___)  _ \
+ _____) ) ____| | | || |_| ____( (___| | | |
+(______/|_____)_|_|_| \__)_____)\____)_| |_|
+    (C)2017 Semtech
+	
+Description: Optional verification layer comparing decoded data points with the ground truth
+License: Revised BSD License, see LICENSE file included in the project
+By: Paul Marcelis
+*/
+#include "DaRe.h"
+
+#ifndef __DARE_VERIFIER_H
+#define __DARE_VERIFIER_H
+
+class DaReVerifier {
+  uint8_t dataPointSize;
+  uint32_t totalDataPoints;
+  uint8_t *dataPointsTruth;
+  uint32_t mismatches = 0;
+
+public:
+  void init(uint8_t dataPointSizeIn, uint32_t simulationLength);
+  void destroy();
+  void setDataPoint(uint32_t fcntup, uint8_t *dataPoint);
+  uint8_t *getDataPoint(uint32_t fcntup);
+  bool verify(uint32_t fcntup, const uint8_t *dataPoint, int phase);
+  uint32_t getMismatches();
+};
+
+#endif
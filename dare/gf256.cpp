@@ -0,0 +1,111 @@
+/*
+ / _____)             _              | |
+( (____  _____ ____ _| |_ _____  ____| |__
+ \____ \| ___ |    (_   _) ___ |/ ___)  _ \
+ _____) ) ____| | | || |_| ____( (___| | | |
+(______/|_____)_|_|_| \__)_____)\____)_| |_|
+    (C)2017 Semtech
+	
+Description: Arithmetic in GF(256) for coded parity checks with coefficients
+License: Revised BSD License, see LICENSE file included in the project
+By: Paul Marcelis
+*/
+#include "gf256.h"
+
+#if defined(__SSSE3__) || defined(__AVX__)
+#include <tmmintrin.h>
+#define GF256_SIMD
+#endif
+
+uint8_t GF256::expTable[512];
+uint8_t GF256::logTable[256];
+bool GF256::tablesReady = GF256::initTables(); // filled once before main() runs, so the tables are read-only afterwards
+
+/*
+ * Fill the exponent and logarithm tables, the exponent table is doubled to avoid a modulo in mul()
+ */
+bool GF256::initTables() {
+  uint32_t i, x = 1;
+  for (i = 0; i < 255; i++) {
+    expTable[i] = (uint8_t)x;
+    expTable[i + 255] = (uint8_t)x;
+    logTable[x] = (uint8_t)i;
+    x <<= 1;
+    if (x & 0x100) {
+      x ^= GF256_POLYNOMIAL;
+    }
+  }
+  expTable[510] = expTable[0];
+  expTable[511] = expTable[1];
+  logTable[0] = 0;
+  return true;
+}
+
+/*
+ * Multiply two field elements
+ */
+uint8_t GF256::mul(uint8_t a, uint8_t b) {
+  if (a == 0 || b == 0) {
+    return 0;
+  }
+  return expTable[logTable[a] + logTable[b]];
+}
+
+/*
+ * Multiplicative inverse of a non-zero field element
+ */
+uint8_t GF256::inv(uint8_t a) {
+  return expTable[255 - logTable[a]];
+}
+
+/*
+ * dst = dst + c * src, bytewise over a region. Addition in GF(256) is XOR, so for c = 1 this is the plain XOR of DaRe
+ * The SIMD kernel splits every byte in two nibbles and looks up both partial products with PSHUFB
+ */
+void GF256::mulAdd(uint8_t *dst, uint8_t *src, uint8_t c, uint32_t length) {
+  uint32_t i = 0;
+  if (c == 0) {
+    return;
+  }
+  if (c == 1) {
+    for (i = 0; i < length; i++) {
+      dst[i] ^= src[i];
+    }
+    return;
+  }
+#ifdef GF256_SIMD
+  if (length >= 16) {
+    uint8_t low[16], high[16];
+    for (i = 0; i < 16; i++) {
+      low[i] = mul(c, (uint8_t)i);
+      high[i] = mul(c, (uint8_t)(i << 4));
+    }
+    __m128i tableLow = _mm_loadu_si128((__m128i *)low);
+    __m128i tableHigh = _mm_loadu_si128((__m128i *)high);
+    __m128i mask = _mm_set1_epi8(0x0f);
+    for (i = 0; i + 16 <= length; i += 16) {
+      __m128i in = _mm_loadu_si128((__m128i *)&src[i]);
+      __m128i productLow = _mm_shuffle_epi8(tableLow, _mm_and_si128(in, mask));
+      __m128i productHigh = _mm_shuffle_epi8(tableHigh, _mm_and_si128(_mm_srli_epi64(in, 4), mask));
+      __m128i out = _mm_loadu_si128((__m128i *)&dst[i]);
+      _mm_storeu_si128((__m128i *)&dst[i], _mm_xor_si128(out, _mm_xor_si128(productLow, productHigh)));
+    }
+  }
+#endif
+  uint8_t logC = logTable[c];
+  for (; i < length; i++) {
+    if (src[i] != 0) {
+      dst[i] ^= expTable[logTable[src[i]] + logC];
+    }
+  }
+}
+
+/*
+ * dst = c * dst, bytewise over a region
+ */
+void GF256::mulRegion(uint8_t *dst, uint8_t c, uint32_t length) {
+  uint32_t i;
+  for (i = 0; i < length; i++) {
+    dst[i] = mul(c, dst[i]);
+  }
+}
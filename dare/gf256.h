@@ -0,0 +1,34 @@
+/*
+ / _____)             _              | |
+( (____  _____ ____ _| |_ _____  ____| |__
+ \____ \| ___ |    (_   _) ___ |/ ___)  _ \
+ _____) ) ____| | | || |_| ____( (___| | | |
+(______/|_____)_|_|_| \__)_____)\____)_| |_|
+    (C)2017 Semtech
+	
+Description: Arithmetic in GF(256) for coded parity checks with coefficients
+License: Revised BSD License, see LICENSE file included in the project
+By: Paul Marcelis
+*/
+#include <stdint.h>
+
+#ifndef __DARE_GF256_H
+#define __DARE_GF256_H
+
+#define GF256_POLYNOMIAL 0x11d // x^8+x^4+x^3+x^2+1, the field generator polynomial
+
+class GF256 {
+  static uint8_t expTable[512];
+  static uint8_t logTable[256];
+  static bool tablesReady;
+
+  static bool initTables();
+
+public:
+  static uint8_t mul(uint8_t a, uint8_t b);
+  static uint8_t inv(uint8_t a);
+  static void mulAdd(uint8_t *dst, uint8_t *src, uint8_t c, uint32_t length);
+  static void mulRegion(uint8_t *dst, uint8_t c, uint32_t length);
+};
+
+#endif
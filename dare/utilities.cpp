@@ -61,3 +61,61 @@ int hexCharToDecimal(char ch) {
 	else // ch is '0', '1', ..., or '9'
 		return ch - '0';
 }
+
+static const char base64Alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+/*!
+* \brief   Function to encode binary data in base64, as used for the payloads of the Semtech packet forwarder
+*
+* \param   [IN] data - the data to encode
+* \param   [IN] dataSize - the size of the data
+* \param   [OUT] out - the encoded string, at least 4 * ((dataSize + 2) / 3) + 1 characters
+* \return  the length of the encoded string
+*/
+int base64Encode(const unsigned char *data, int dataSize, char *out) {
+	int i, length = 0;
+	for (i = 0; i < dataSize; i += 3) {
+		unsigned int block = data[i] << 16;
+		if (i + 1 < dataSize) block |= data[i + 1] << 8;
+		if (i + 2 < dataSize) block |= data[i + 2];
+		out[length++] = base64Alphabet[(block >> 18) & 0x3f];
+		out[length++] = base64Alphabet[(block >> 12) & 0x3f];
+		out[length++] = (i + 1 < dataSize) ? base64Alphabet[(block >> 6) & 0x3f] : '=';
+		out[length++] = (i + 2 < dataSize) ? base64Alphabet[block & 0x3f] : '=';
+	}
+	out[length] = '\0';
+	return length;
+}
+
+/*!
+* \brief   Function to decode a base64 string
+*
+* \param   [IN] in - the base64 string, padding is optional
+* \param   [IN] inSize - the length of the string
+* \param   [OUT] out - the decoded data, at least 3 * inSize / 4 bytes
+* \return  the size of the decoded data, or -1 if the string contains an invalid character
+*/
+int base64Decode(const char *in, int inSize, unsigned char *out) {
+	static signed char values[256];
+	static bool valuesReady = false;
+	unsigned int block = 0;
+	int i, bits = 0, length = 0;
+
+	if (!valuesReady) {
+		for (i = 0; i < 256; i++) values[i] = -1;
+		for (i = 0; i < 64; i++) values[(unsigned char)base64Alphabet[i]] = (signed char)i;
+		valuesReady = true;
+	}
+	for (i = 0; i < inSize && in[i] != '='; i++) {
+		if (values[(unsigned char)in[i]] < 0) {
+			return -1;
+		}
+		block = (block << 6) | values[(unsigned char)in[i]];
+		bits += 6;
+		if (bits >= 8) {
+			bits -= 8;
+			out[length++] = (unsigned char)(block >> bits);
+		}
+	}
+	return length;
+}
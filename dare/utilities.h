@@ -17,5 +17,7 @@ void displayCharArray(unsigned char data[], int dataSize, int breaks = 0, char b
 void displayBoolArray(bool* data, int dataSize, int breaks = 0);
 int hang();
 int hexCharToDecimal(char);
+int base64Encode(const unsigned char *data, int dataSize, char *out);
+int base64Decode(const char *in, int inSize, unsigned char *out);
 
 #endif